@@ -0,0 +1,47 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <iostream>
+#include <iomanip>
+
+// small helpers shared by the micro-benchmarks
+
+// keeps the optimizer from discarding a result
+template <typename T>
+inline void do_not_optimize(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// runs fn(i) for i in [0, iters) and returns the average ns per call
+template <typename F>
+double ns_per_op(long iters, F &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iters; i++) {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / iters;
+}
+
+inline std::vector<std::string> make_keys(long n, const std::string &prefix = "key:") {
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (long i = 0; i < n; i++) {
+        keys.emplace_back(prefix + std::to_string(i));
+    }
+
+    return keys;
+}
+
+inline void report(const std::string &name, double value, const std::string &unit = "ns/op") {
+    std::cout << std::left << std::setw(40) << name 
+        << std::right << std::setw(12) << std::fixed << std::setprecision(1) << value 
+        << " " << unit << std::endl;
+}
+
+#endif
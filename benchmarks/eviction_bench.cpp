@@ -0,0 +1,117 @@
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+
+#include "bench.hpp"
+#include "lru_cache.hpp"
+
+// key ids drawn from a Zipfian distribution over [0, num_keys) with exponent s
+std::vector<long> zipf_trace(long num_keys, long length, double s, unsigned seed) {
+    std::vector<double> cdf(num_keys);
+    double sum = 0;
+    for (long i = 0; i < num_keys; i++) {
+        sum += 1.0 / std::pow(i + 1, s);
+        cdf[i] = sum;
+    }
+
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> dist(0, sum);
+
+    std::vector<long> trace(length);
+    for (auto &id : trace) {
+        id = std::lower_bound(cdf.begin(), cdf.end(), dist(gen)) - cdf.begin();
+    }
+
+    return trace;
+}
+
+// inserts a burst of scan_length one-off keys (ids from first_id up) every `every` requests
+std::vector<long> with_scans(const std::vector<long> &trace, long every, long scan_length, long first_id) {
+    std::vector<long> scanned;
+    long next_id = first_id;
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        if (i > 0 && i % every == 0) {
+            for (long j = 0; j < scan_length; j++) {
+                scanned.push_back(next_id++);
+            }
+        }
+        scanned.push_back(trace[i]);
+    }
+
+    return scanned;
+}
+
+// replays the trace as GET, then SET on a miss, like a read-through cache
+void bench_policy(const std::string &policy, const std::vector<std::string> &keys, const std::vector<long> &trace, long capacity, const std::string &workload) {
+    LRUCache lru { capacity, capacity };
+    lru.set_eviction(make_eviction_policy(policy));
+
+    long hits = 0;
+    double ns = ns_per_op(trace.size(), [&](long i) {
+        const std::string &key = keys[trace[i]];
+        if (lru.get(key)) {
+            hits++;
+        } else {
+            lru.add(key, Value("value"));
+        }
+    });
+
+    std::stringstream name;
+    name << policy << "/" << workload << "/" << capacity << " cap";
+    report(name.str() + " hit ratio", 100.0 * hits / trace.size(), "%");
+    report(name.str(), ns);
+}
+
+// GET hits only, so the cost is the read path of each policy
+void bench_reads(const std::string &policy, const std::vector<std::string> &keys, const std::vector<long> &trace, long capacity) {
+    LRUCache lru { capacity, capacity };
+    lru.set_eviction(make_eviction_policy(policy));
+    for (long i = 0; i < capacity; i++) {
+        lru.add(keys[i], Value("value"));
+    }
+
+    double ns = ns_per_op(trace.size(), [&](long i) {
+        do_not_optimize(lru.get(keys[trace[i] % capacity]));
+    });
+
+    report(policy + "/get_hit/" + std::to_string(capacity) + " keys", ns);
+}
+
+int main() {
+    const long num_keys = 1000000;
+    const long length = 4000000;
+    const long scan_every = 200000;
+    const long scan_length = 50000;
+    std::vector<std::string> keys = make_keys(num_keys + length / scan_every * scan_length);
+    const char *policies[] = {"lru", "sampled", "clock", "tinylfu"};
+
+    for (double s : {0.8, 0.99}) {
+        std::vector<long> trace = zipf_trace(num_keys, length, s, 42);
+
+        std::stringstream workload;
+        workload << "zipf " << s;
+
+        for (long capacity : {10000L, 100000L}) {
+            for (const char *policy : policies) {
+                bench_policy(policy, keys, trace, capacity, workload.str());
+            }
+        }
+    }
+
+    // bursts of one-off keys, like a KEYS sweep or a batch job, between zipf 0.99 requests
+    std::vector<long> scans = with_scans(zipf_trace(num_keys, length, 0.99, 42), scan_every, scan_length, num_keys);
+    for (long capacity : {10000L, 100000L}) {
+        for (const char *policy : policies) {
+            bench_policy(policy, keys, scans, capacity, "zipf 0.99+scans");
+        }
+    }
+
+    std::vector<long> reads = zipf_trace(num_keys, length, 0.99, 7);
+    for (const char *policy : policies) {
+        bench_reads(policy, keys, reads, num_keys);
+    }
+
+    return EXIT_SUCCESS;
+}
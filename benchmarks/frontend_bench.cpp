@@ -0,0 +1,225 @@
+#include <thread>
+#include <atomic>
+#include <zmq.hpp>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "bench.hpp"
+#include "tcp_server.hpp"
+#include "command.hpp"
+#include "resp.hpp"
+#include "lru_cache.hpp"
+#include "globals.hpp"
+
+// client front ends under closed loop load: every connection keeps one GET in flight, sending the next
+// as soon as its reply arrives. the ZMQ REP socket serves one request at a time however many clients are
+// connected, while the epoll TCP server serves every connection that is ready each poll.
+// both serve this process' cache from one server thread, so only the front end differs
+
+constexpr long KEYS = 1000;
+constexpr auto RUN_TIME = std::chrono::seconds(2);
+const std::string VALUE = "value";
+// bytes in a GET reply for VALUE, "$5\r\nvalue\r\n"
+const size_t REPLY_SIZE = 1 + std::to_string(VALUE.size()).size() + 2 + VALUE.size() + 2;
+
+static std::vector<std::string> requests() {
+    std::vector<std::string> reqs;
+    for (const std::string &key : make_keys(KEYS)) {
+        std::string get = "get " + key;
+        Tokens args { get };
+        std::string req;
+        resp::write_request(args, req);
+        reqs.push_back(req);
+    }
+
+    return reqs;
+}
+
+static bool serve(const Tokens &args, resp::Protocol &protocol, std::string &out, const TcpServer::Ticket &ticket) {
+    Command cmd { args, protocol };
+    out += cmd.parse_cmd();
+    return true;
+}
+
+static void report_run(const std::string &name, int conns, long ops, double secs) {
+    report(name, ops / secs, "ops/s");
+    // each connection waits for its reply before sending again
+    report(name + " latency", ops > 0 ? secs * 1e6 * conns / ops : 0, "us/op");
+}
+
+void bench_tcp(int conns, const std::vector<std::string> &reqs) {
+    TcpServer server { serve };
+    server.listen(0);
+
+    std::atomic<bool> done = false;
+    std::thread server_thread([&]() {
+        while (!done) {
+            server.poll(10);
+        }
+    });
+
+    int epoll_fd = epoll_create1(0);
+    std::vector<int> fds(conns);
+    std::vector<size_t> received(conns, 0);
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server.get_port());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int i = 0; i < conns; i++) {
+        fds[i] = socket(AF_INET, SOCK_STREAM, 0);
+        connect(fds[i], reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        int one = 1;
+        setsockopt(fds[i], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[i], &event);
+    }
+
+    long ops = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + RUN_TIME;
+
+    for (int i = 0; i < conns; i++) {
+        const std::string &req = reqs[i % reqs.size()];
+        send(fds[i], req.data(), req.size(), 0);
+    }
+
+    epoll_event events[256];
+    char buf[4096];
+    while (std::chrono::steady_clock::now() < end) {
+        int count = epoll_wait(epoll_fd, events, 256, 10);
+        for (int e = 0; e < count; e++) {
+            int i = events[e].data.u32;
+            ssize_t n = recv(fds[i], buf, sizeof(buf), MSG_DONTWAIT);
+            if (n <= 0) {
+                continue;
+            }
+
+            received[i] += n;
+            if (received[i] == REPLY_SIZE) {
+                received[i] = 0;
+                const std::string &req = reqs[(ops + i) % reqs.size()];
+                send(fds[i], req.data(), req.size(), 0);
+                ops++;
+            }
+        }
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report_run("tcp epoll " + std::to_string(conns) + " conns", conns, ops, secs);
+
+    done = true;
+    server_thread.join();
+    for (int fd : fds) {
+        close(fd);
+    }
+    close(epoll_fd);
+}
+
+void bench_zmq(int conns, const std::vector<std::string> &reqs) {
+    zmq::context_t context{1};
+    context.set(zmq::ctxopt::max_sockets, conns + 16);
+
+    zmq::socket_t rep{context, zmq::socket_type::rep};
+    rep.bind("tcp://127.0.0.1:*");
+    std::string endpoint = rep.get(zmq::sockopt::last_endpoint);
+
+    // how the leader served clients before the TCP front end: one request, one reply
+    std::atomic<bool> done = false;
+    std::thread server_thread([&]() {
+        zmq::pollitem_t item { rep.handle(), 0, ZMQ_POLLIN, 0 };
+        while (!done) {
+            if (zmq::poll(&item, 1, std::chrono::milliseconds(10)) <= 0) {
+                continue;
+            }
+
+            zmq::message_t request;
+            if (!rep.recv(request, zmq::recv_flags::none)) {
+                continue;
+            }
+
+            Tokens args;
+            resp::Protocol protocol;
+            std::string reply;
+            if (resp::parse_message(request.to_string_view(), args, protocol)) {
+                serve(args, protocol, reply, {});
+            }
+            rep.send(zmq::buffer(reply), zmq::send_flags::none);
+        }
+    });
+
+    std::vector<zmq::socket_t> clients;
+    std::vector<zmq::pollitem_t> items;
+    clients.reserve(conns);
+    for (int i = 0; i < conns; i++) {
+        clients.emplace_back(context, zmq::socket_type::req);
+        clients.back().set(zmq::sockopt::linger, 0);
+        clients.back().connect(endpoint);
+    }
+    for (int i = 0; i < conns; i++) {
+        items.push_back({ clients[i].handle(), 0, ZMQ_POLLIN, 0 });
+    }
+
+    long ops = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + RUN_TIME;
+
+    for (int i = 0; i < conns; i++) {
+        clients[i].send(zmq::buffer(reqs[i % reqs.size()]), zmq::send_flags::none);
+    }
+
+    while (std::chrono::steady_clock::now() < end) {
+        if (zmq::poll(items, std::chrono::milliseconds(10)) <= 0) {
+            continue;
+        }
+
+        for (int i = 0; i < conns; i++) {
+            if (!(items[i].revents & ZMQ_POLLIN)) {
+                continue;
+            }
+
+            zmq::message_t reply;
+            if (clients[i].recv(reply, zmq::recv_flags::none)) {
+                const std::string &req = reqs[(ops + i) % reqs.size()];
+                clients[i].send(zmq::buffer(req), zmq::send_flags::none);
+                ops++;
+            }
+        }
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report_run("zmq rep " + std::to_string(conns) + " conns", conns, ops, secs);
+
+    done = true;
+    server_thread.join();
+}
+
+int main() {
+    // both ends of every connection are in this process
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    for (const std::string &key : make_keys(KEYS)) {
+        cache.add(key, Value(VALUE));
+    }
+
+    std::vector<std::string> reqs = requests();
+    for (int conns : {1, 64, 1024}) {
+        bench_tcp(conns, reqs);
+        bench_zmq(conns, reqs);
+    }
+
+    return 0;
+}
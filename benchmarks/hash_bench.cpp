@@ -0,0 +1,48 @@
+#include <functional>
+#include <string_view>
+
+#include "bench.hpp"
+#include "wyhash.hpp"
+
+// hash throughput for short keys: wyhash, which places keys on the ring, against std::hash,
+// which did before and whose result depends on the standard library
+
+constexpr long ITERS = 20000000;
+// a power of two, so picking a key is a mask
+constexpr long KEYS = 1024;
+
+void bench_length(size_t length) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> byte('a', 'z');
+
+    std::vector<std::string> keys;
+    for (long i = 0; i < KEYS; i++) {
+        std::string key;
+        for (size_t j = 0; j < length; j++) {
+            key += static_cast<char>(byte(rng));
+        }
+        keys.push_back(std::move(key));
+    }
+
+    double std_hash = ns_per_op(ITERS, [&](long i) {
+        do_not_optimize(std::hash<std::string_view>()(keys[i & (KEYS - 1)]));
+    });
+
+    double wy = ns_per_op(ITERS, [&](long i) {
+        const std::string &key = keys[i & (KEYS - 1)];
+        do_not_optimize(wyhash::hash(key.data(), key.size()));
+    });
+
+    std::string name = std::to_string(length) + " byte keys";
+    report(name + " std::hash", std_hash);
+    report(name + " wyhash", wy);
+    report(name + " wyhash throughput", 1000 / wy, "M keys/s");
+}
+
+int main() {
+    for (size_t length : { 4, 8, 16, 32, 64 }) {
+        bench_length(length);
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <unordered_map>
+#include <malloc.h>
+#include <new>
+#include <cstdlib>
+
+#include "bench.hpp"
+#include "key_index.hpp"
+#include "entries/cache_entry.hpp"
+
+// compares KeyIndex to the std::unordered_map it replaced in LRUCache
+
+// count live heap bytes (including allocator rounding) to measure memory per key
+static size_t live_bytes = 0;
+
+void *operator new(size_t n) {
+    void *p = std::malloc(n);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    if (p) {
+        live_bytes -= malloc_usable_size(p);
+        std::free(p);
+    }
+}
+
+void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+// entries are created before measuring, so memory per key only counts the index itself.
+// the map keeps its own copy of each key, while KeyIndex reads keys from the entries
+template <typename Insert, typename Find>
+void run(const std::string &name, long n, const std::vector<std::string> &keys, const std::vector<CacheEntry*> &entries,
+        const std::vector<std::string> &missing, const std::vector<long> &order, Insert &&insert, Find &&find) {
+    
+    size_t before = live_bytes;
+    for (long i = 0; i < n; i++) {
+        insert(keys[i], entries[i]);
+    }
+    double bytes_per_key = (double) (live_bytes - before) / n;
+
+    long iters = order.size();
+    double hit = ns_per_op(iters, [&](long i) {
+        do_not_optimize(find(keys[order[i]]));
+    });
+    double miss = ns_per_op(iters, [&](long i) {
+        do_not_optimize(find(missing[order[i]]));
+    });
+
+    std::string suffix = "/" + std::to_string(n) + " keys";
+    report(name + " hit" + suffix, hit);
+    report(name + " miss" + suffix, miss);
+    report(name + " memory" + suffix, bytes_per_key, "bytes/key");
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<long> sizes = { 1000000, 10000000 };
+    if (argc > 1) {
+        sizes = { std::atol(argv[1]) };
+    }
+
+    for (long n : sizes) {
+        std::vector<std::string> keys = make_keys(n);
+        std::vector<std::string> missing = make_keys(n, "miss:");
+
+        std::vector<CacheEntry*> entries;
+        entries.reserve(n);
+        for (auto &key : keys) {
+            entries.push_back(new CacheEntry(key));
+        }
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<long> dist(0, n - 1);
+        std::vector<long> order(2000000);
+        for (auto &i : order) {
+            i = dist(gen);
+        }
+
+        {
+            std::unordered_map<std::string, CacheEntry*> map;
+            run("unordered_map", n, keys, entries, missing, order,
+                [&](const std::string &key, CacheEntry *value) { map.insert({key, value}); },
+                [&](const std::string &key) { 
+                    auto it = map.find(key);
+                    return it == map.end() ? nullptr : it->second;
+                });
+        }
+
+        {
+            KeyIndex index;
+            run("KeyIndex", n, keys, entries, missing, order,
+                [&](const std::string &key, CacheEntry *value) { index.insert(value); },
+                [&](const std::string &key) { return index.find(key); });
+        }
+
+        for (CacheEntry *entry : entries) {
+            delete entry;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
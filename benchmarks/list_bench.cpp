@@ -0,0 +1,97 @@
+#include <malloc.h>
+#include <new>
+#include <cstdlib>
+
+#include "bench.hpp"
+#include "quick_list.hpp"
+
+// memory per element and push, pop, index and range throughput for lists
+
+// count live heap bytes (including allocator rounding)
+static size_t live_bytes = 0;
+
+void *operator new(size_t n) {
+    void *p = std::malloc(n);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    if (p) {
+        live_bytes -= malloc_usable_size(p);
+        std::free(p);
+    }
+}
+
+void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+// slabs are malloc'd directly, so they are counted separately from operator new
+size_t total_bytes() {
+    return live_bytes + QuickList::chunk_pool().memory_usage() + QuickList::pool().memory_usage();
+}
+
+void bench_list(const std::string &name, const std::string &value, long size, long iters) {
+    std::string suffix = "/" + std::to_string(size) + " " + name;
+
+    // the previous run's slabs would be reused and hide this run's memory
+    if (QuickList::chunk_pool().get_in_use() == 0) {
+        QuickList::chunk_pool().release();
+    }
+    if (QuickList::pool().get_in_use() == 0) {
+        QuickList::pool().release();
+    }
+
+    size_t bytes_before = total_bytes();
+    QuickList *list = new QuickList();
+    double push = ns_per_op(size, [&](long i) {
+        list->add_end(str_to_value(value));
+    });
+    double bytes = (double) (total_bytes() - bytes_before) / size;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, size - 1);
+    // random access to long lists is slow, so fewer lookups are timed
+    long index_iters = std::max(100L, std::min(iters, 100000000L / size));
+    std::vector<int> order(index_iters);
+    for (auto &i : order) {
+        i = dist(gen);
+    }
+
+    double index = ns_per_op(index_iters, [&](long i) {
+        do_not_optimize(list->get(order[i]));
+    });
+
+    long ranges = std::max(1L, iters / size);
+    double range = ns_per_op(ranges, [&](long i) {
+        do_not_optimize(list->values(0, -1, false, true));
+    }) / size;
+
+    double pop = ns_per_op(size, [&](long i) {
+        do_not_optimize(list->remove_front());
+    });
+
+    delete list;
+
+    report("memory" + suffix, bytes, "bytes/element");
+    report("rpush" + suffix, push);
+    report("lindex" + suffix, index);
+    report("lrange" + suffix, range, "ns/element");
+    report("lpop" + suffix, pop);
+}
+
+int main() {
+    const long iters = 100000;
+
+    for (long size : {100L, 10000L, 1000000L}) {
+        bench_list("ints", "12345", size, iters);
+        bench_list("short strings", "value", size, iters);
+        bench_list("32 byte strings", std::string(32, 'v'), size, iters);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include <random>
+
+#include "bench.hpp"
+#include "lru_cache.hpp"
+#include "quick_list.hpp"
+
+// GET hits against a warm cache. Every hit moves the entry to the end of the LRU queue.
+void bench_get_hits(long num_keys, long iters) {
+    LRUCache lru { num_keys, num_keys };
+    std::vector<std::string> keys = make_keys(num_keys);
+    for (auto &key : keys) {
+        lru.add(key, str_to_value("value"));
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<long> dist(0, num_keys - 1);
+    std::vector<long> order(iters);
+    for (auto &i : order) {
+        i = dist(gen);
+    }
+
+    double ns = ns_per_op(iters, [&](long i) {
+        do_not_optimize(lru.get(keys[order[i]]));
+    });
+
+    report("get_hit/" + std::to_string(num_keys) + " keys", ns);
+}
+
+// SETs that overwrite existing keys (no eviction)
+void bench_set_existing(long num_keys, long iters) {
+    LRUCache lru { num_keys, num_keys };
+    std::vector<std::string> keys = make_keys(num_keys);
+    for (auto &key : keys) {
+        lru.add(key, str_to_value("value"));
+    }
+
+    double ns = ns_per_op(iters, [&](long i) {
+        lru.add(keys[i % num_keys], str_to_value("value"));
+    });
+
+    report("set_existing/" + std::to_string(num_keys) + " keys", ns);
+}
+
+// SETs of new keys into a full cache, so every add evicts the LRU head
+void bench_set_evict(long num_keys, long iters) {
+    LRUCache lru { num_keys, num_keys };
+    std::vector<std::string> keys = make_keys(num_keys + iters);
+
+    for (long i = 0; i < num_keys; i++) {
+        lru.add(keys[i], str_to_value("value"));
+    }
+
+    double ns = ns_per_op(iters, [&](long i) {
+        lru.add(keys[num_keys + i], str_to_value("value"));
+    });
+
+    report("set_evict/" + std::to_string(num_keys) + " keys", ns);
+}
+
+// fills an empty cache with new keys, then clears it like flushall. reports ns per key for each
+void bench_fill_flush(long num_keys) {
+    std::vector<std::string> keys = make_keys(num_keys);
+    LRUCache lru { num_keys, num_keys };
+
+    double fill = ns_per_op(num_keys, [&](long i) {
+        lru.add(keys[i], Value("value"));
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    lru.clear();
+    double flush = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / num_keys;
+
+    report("fill/" + std::to_string(num_keys) + " keys", fill);
+    report("flushall/" + std::to_string(num_keys) + " keys", flush);
+}
+
+// pushes values onto lists of list_size elements, then pops them all
+void bench_list_push_pop(long list_size, long iters) {
+    QuickList list;
+
+    double ns = ns_per_op(iters, [&](long i) {
+        list.add_end(Value(i));
+        if (list.get_size() >= list_size) {
+            while (list.get_size() > 0) {
+                list.remove_front();
+            }
+        }
+    });
+
+    report("list push+pop/" + std::to_string(list_size) + " values", ns);
+}
+
+int main() {
+    const long iters = 2000000;
+    for (long n : {1000L, 100000L, 1000000L}) {
+        bench_get_hits(n, iters);
+        bench_set_existing(n, iters);
+        bench_set_evict(n, iters / 4);
+        bench_fill_flush(n);
+    }
+
+    bench_list_push_pop(1000, iters);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include <sstream>
+#include <iterator>
+
+#include "bench.hpp"
+#include "tokens.hpp"
+#include "command.hpp"
+#include "resp.hpp"
+#include "lru_cache.hpp"
+#include "globals.hpp"
+
+// request parsing throughput: splitting a request, what the leader does to route it, and building a Command
+
+// how requests were split before Tokens
+std::vector<std::string> split_stream(const std::string &msg) {
+    std::stringstream ss (msg);
+    std::istream_iterator<std::string> begin (ss), end;
+    return std::vector<std::string> (begin, end);
+}
+
+void bench_request(const std::string &name, const std::string &msg, long iters) {
+    double stream = ns_per_op(iters, [&](long i) {
+        do_not_optimize(split_stream(msg));
+    });
+
+    double tokens = ns_per_op(iters, [&](long i) {
+        Tokens t { msg };
+        do_not_optimize(t);
+    });
+
+    // the leader reads the name to pick fan out commands and the key to pick a node
+    double route = ns_per_op(iters, [&](long i) {
+        Tokens t { msg };
+        do_not_optimize(cmd::lookup(t.name()));
+        do_not_optimize(t.key());
+    });
+
+    double command = ns_per_op(iters, [&](long i) {
+        Command cmd { msg };
+        do_not_optimize(cmd);
+    });
+
+    double total = ns_per_op(iters, [&](long i) {
+        Command cmd { msg };
+        do_not_optimize(cmd.parse_cmd());
+    });
+
+    report(name + " stringstream split", stream);
+    report(name + " Tokens", tokens);
+    report(name + " route", route);
+    report(name + " Command", command);
+    report(name + " parse_cmd", total);
+}
+
+// the same request framed in RESP, parsed and run with RESP replies
+void bench_resp(const std::string &name, const std::string &msg, long iters) {
+    Tokens text { msg };
+    std::string framed;
+    resp::write_request(text, framed);
+
+    double parse = ns_per_op(iters, [&](long i) {
+        Tokens args;
+        resp::Protocol protocol;
+        do_not_optimize(resp::parse_message(framed, args, protocol));
+        do_not_optimize(args);
+    });
+
+    double total = ns_per_op(iters, [&](long i) {
+        Tokens args;
+        resp::Protocol protocol;
+        resp::parse_message(framed, args, protocol);
+        Command cmd { args, protocol };
+        do_not_optimize(cmd.parse_cmd());
+    });
+
+    report(name + " RESP parse", parse);
+    report(name + " RESP parse_cmd", total);
+}
+
+int main() {
+    const long iters = 1000000;
+
+    cache.add("key:12345", Value("value"));
+
+    bench_request("get", "get key:12345", iters);
+    bench_resp("get", "get key:12345", iters);
+    bench_request("set", "set key:12345 value", iters);
+    bench_request("memory", "memory usage key:12345", iters);
+
+    std::string del = "del";
+    for (int i = 0; i < 32; i++) {
+        del += " key:" + std::to_string(i);
+    }
+    bench_request("del 32 keys", del, iters / 10);
+
+    return EXIT_SUCCESS;
+}
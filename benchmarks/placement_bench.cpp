@@ -0,0 +1,85 @@
+#include <algorithm>
+
+#include "bench.hpp"
+#include "placement.hpp"
+#include "consistent-hashing.hpp"
+
+// each placement's lookup time, how evenly it spreads keys, and how many keys move when a node
+// joins or leaves, against the fewest that could: the joining node's share, or the leaving node's keys
+
+constexpr long ITERS = 20000000;
+constexpr long KEYS = 1000000;
+constexpr int NODES = 8;
+
+std::vector<Placement::Node> make_nodes(int count) {
+    std::vector<Placement::Node> nodes;
+    for (int i = 0; i < count; i++) {
+        nodes.push_back({ std::to_string(10000 + i), "tcp://localhost:" + std::to_string(6000 + i), DEFAULT_VNODES });
+    }
+
+    return nodes;
+}
+
+// the pid of each key's owner
+std::vector<std::string> owners(const Placement &placement, const std::vector<Placement::Node> &nodes,
+    const std::vector<uint64_t> &hashes) {
+    std::vector<std::string> pids;
+    pids.reserve(hashes.size());
+    for (uint64_t hash : hashes) {
+        pids.push_back(nodes[placement.get(hash)].pid);
+    }
+
+    return pids;
+}
+
+double percent_moved(const std::vector<std::string> &before, const std::vector<std::string> &after) {
+    long moved = 0;
+    for (size_t i = 0; i < before.size(); i++) {
+        moved += before[i] != after[i];
+    }
+
+    return 100.0 * moved / before.size();
+}
+
+void bench_placement(PlacementType type, const std::vector<uint64_t> &hashes) {
+    std::vector<Placement::Node> nodes = make_nodes(NODES);
+    std::unique_ptr<Placement> placement = Placement::make(type, nodes);
+
+    double lookup = ns_per_op(ITERS, [&](long i) {
+        do_not_optimize(placement->get(hashes[i % KEYS]));
+    });
+
+    std::vector<long> counts(nodes.size(), 0);
+    for (uint64_t hash : hashes) {
+        counts[placement->get(hash)]++;
+    }
+    long max = *std::max_element(counts.begin(), counts.end());
+
+    // a node started after the others joins, then the first node started leaves
+    std::vector<std::string> before = owners(*placement, nodes, hashes);
+    std::vector<Placement::Node> joined = make_nodes(NODES + 1);
+    std::vector<std::string> after_join = owners(*Placement::make(type, joined), joined, hashes);
+    std::vector<Placement::Node> left(nodes.begin() + 1, nodes.end());
+    std::vector<std::string> after_leave = owners(*Placement::make(type, left), left, hashes);
+
+    std::string name = placement_name(type);
+    report(name + " lookup", lookup);
+    report(name + " max/mean keys", static_cast<double>(max) / (KEYS / NODES), "x");
+    report(name + " moved on join", percent_moved(before, after_join), "% of keys");
+    report(name + " moved on leave", percent_moved(before, after_leave), "% of keys");
+}
+
+int main() {
+    std::vector<uint64_t> hashes;
+    for (const std::string &key : make_keys(KEYS)) {
+        hashes.push_back(hash_function(key));
+    }
+
+    std::cout << std::fixed << std::setprecision(1) << NODES << " nodes with " << DEFAULT_VNODES << " points each. a join moves at least "
+        << 100.0 / (NODES + 1) << "% of keys and a leave " << 100.0 / NODES << "%" << std::endl;
+    for (PlacementType type : { PlacementType::Ring, PlacementType::Jump, PlacementType::Rendezvous, PlacementType::Bounded }) {
+        bench_placement(type, hashes);
+    }
+
+    return 0;
+}
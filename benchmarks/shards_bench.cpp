@@ -0,0 +1,85 @@
+#include <thread>
+#include <poll.h>
+
+#include "bench.hpp"
+#include "shards.hpp"
+#include "worker.hpp"
+#include "tokens.hpp"
+#include "resp.hpp"
+#include "globals.hpp"
+
+// node throughput with its cache split across executor threads, against running every command on one thread.
+// the leader sends a worker BATCH messages, so each message here is a batch of sets and gets on random keys
+
+constexpr long BATCH_REQUESTS = 100;
+constexpr long BATCHES = 20000;
+// batches sent before waiting for replies, like the leader's requests in flight
+constexpr long IN_FLIGHT = 64;
+
+std::vector<std::string> make_batches(long count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<long> key(0, 100000);
+    std::vector<std::string> batches;
+
+    for (long i = 0; i < count; i++) {
+        std::string msg;
+        msg += BATCH;
+        msg += static_cast<char>(resp::Protocol::RESP2);
+        for (long j = 0; j < BATCH_REQUESTS; j++) {
+            std::string request = j % 2
+                ? "set key:" + std::to_string(key(rng)) + " " + std::to_string(j)
+                : "get key:" + std::to_string(key(rng));
+            resp::write_request(Tokens { request }, msg);
+        }
+        batches.push_back(std::move(msg));
+    }
+
+    return batches;
+}
+
+double single_thread(const std::vector<std::string> &batches) {
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string &msg : batches) {
+        do_not_optimize(serve_commands(msg, cache));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return batches.size() * BATCH_REQUESTS / std::chrono::duration<double>(end - start).count();
+}
+
+double sharded(const std::vector<std::string> &batches, size_t threads, bool pin) {
+    LRUCache config;
+    Shards shards { threads, config, pin };
+
+    long sent = 0;
+    long done = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (done < static_cast<long>(batches.size())) {
+        while (sent < static_cast<long>(batches.size()) && sent - done < IN_FLIGHT) {
+            shards.submit(batches[sent++], [&done](std::string &&reply) {
+                do_not_optimize(reply);
+                done++;
+            });
+        }
+
+        pollfd item { shards.fd(), POLLIN, 0 };
+        poll(&item, 1, 10);
+        shards.collect();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return batches.size() * BATCH_REQUESTS / std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    std::vector<std::string> batches = make_batches(BATCHES);
+    std::cout << std::thread::hardware_concurrency() << " cores" << std::endl;
+
+    report("1 thread, no shards", single_thread(batches), "req/s");
+    for (size_t threads : { 1, 2, 4, 8 }) {
+        report(std::to_string(threads) + " shard threads", sharded(batches, threads, false), "req/s");
+        report(std::to_string(threads) + " pinned shard threads", sharded(batches, threads, true), "req/s");
+    }
+
+    return 0;
+}
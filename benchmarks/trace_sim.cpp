@@ -0,0 +1,75 @@
+#include <fstream>
+
+#include "bench.hpp"
+#include "lru_cache.hpp"
+#include "command.hpp"
+
+// Replays a recorded key stream against each eviction policy and prints its hit ratio.
+// The trace has one request per line: either a bare key, or a command such as
+// "get key" (like the commands a leader prints with MONITOR). Commands without a key are skipped.
+// Every request is a lookup, followed by an insert on a miss, like a read-through cache.
+
+std::vector<std::string> read_trace(const std::string &path) {
+    std::ifstream file(path);
+    std::vector<std::string> keys;
+
+    for (std::string line; std::getline(file, line); ) {
+        if (line.find(' ') == std::string::npos) {
+            if (line != "") {
+                keys.emplace_back(line);
+            }
+            continue;
+        }
+
+        std::string key = cmd::extract_key(line);
+        if (key != "") {
+            keys.emplace_back(key);
+        }
+    }
+
+    return keys;
+}
+
+double hit_ratio(const std::string &policy, const std::vector<std::string> &trace, long capacity) {
+    LRUCache sim { capacity, capacity };
+    sim.set_eviction(make_eviction_policy(policy));
+
+    long hits = 0;
+    for (const std::string &key : trace) {
+        if (sim.get(key)) {
+            hits++;
+        } else {
+            sim.add(key, Value(""));
+        }
+    }
+
+    return 100.0 * hits / trace.size();
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: ./trace_sim TRACE_FILE CAPACITY [CAPACITY ...]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> trace = read_trace(argv[1]);
+    if (trace.empty()) {
+        std::cout << "No keys found in " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << trace.size() << " requests" << std::endl;
+    for (int i = 2; i < argc; i++) {
+        long capacity = atol(argv[i]);
+        if (capacity <= 0) {
+            std::cout << "Capacity must be greater than 0!" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        for (const char *policy : {"lru", "sampled", "clock", "tinylfu"}) {
+            report(std::string(policy) + "/" + std::to_string(capacity) + " keys hit ratio", hit_ratio(policy, trace, capacity), "%");
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include <malloc.h>
+#include <new>
+#include <cstdlib>
+
+#include "bench.hpp"
+#include "lru_cache.hpp"
+#include "command.hpp"
+#include "quick_list.hpp"
+#include "globals.hpp"
+
+// memory per key, allocations per key and GET/SET throughput for each kind of value and key length
+
+// count live heap bytes (including allocator rounding) and allocations
+static size_t live_bytes = 0;
+static size_t allocations = 0;
+
+void *operator new(size_t n) {
+    void *p = std::malloc(n);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    live_bytes += malloc_usable_size(p);
+    allocations++;
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    if (p) {
+        live_bytes -= malloc_usable_size(p);
+        std::free(p);
+    }
+}
+
+void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+
+// slabs are malloc'd directly, so they are counted separately from operator new
+size_t total_bytes() {
+    return live_bytes + CacheEntry::pool().memory_usage() + QuickList::chunk_pool().memory_usage() + QuickList::pool().memory_usage();
+}
+
+size_t total_allocations() {
+    return allocations + CacheEntry::pool().get_slab_count() + QuickList::chunk_pool().get_slab_count() + QuickList::pool().get_slab_count();
+}
+
+void bench_value(const std::string &name, const std::string &value, long num_keys, long iters) {
+    // clearing first drops the previous run's slabs, so they are not reused
+    cache.clear();
+    cache = LRUCache(num_keys, num_keys);
+    std::vector<std::string> keys = make_keys(num_keys);
+
+    std::vector<std::string> sets, gets;
+    for (auto &key : keys) {
+        sets.emplace_back("set " + key + " " + value);
+        gets.emplace_back("get " + key);
+    }
+
+    // the index is sized up front, so this only counts what each key adds
+    size_t bytes_before = total_bytes();
+    size_t allocs_before = total_allocations();
+    for (long i = 0; i < num_keys; i++) {
+        cache.add(keys[i], str_to_value(value));
+    }
+    double bytes = (double) (total_bytes() - bytes_before) / num_keys;
+    double allocs = (double) (total_allocations() - allocs_before) / num_keys;
+
+    double set_ns = ns_per_op(iters, [&](long i) {
+        Command set { sets[i % num_keys] };
+        do_not_optimize(set.parse_cmd());
+    });
+    double get_ns = ns_per_op(iters, [&](long i) {
+        Command get { gets[i % num_keys] };
+        do_not_optimize(get.parse_cmd());
+    });
+    double add_ns = ns_per_op(iters, [&](long i) {
+        cache.add(keys[i % num_keys], str_to_value(value));
+    });
+    double lookup_ns = ns_per_op(iters, [&](long i) {
+        do_not_optimize(cache.get(keys[i % num_keys]));
+    });
+
+    report(name + " memory", bytes, "bytes/key");
+    report(name + " allocations", allocs, "allocs/key");
+    report(name + " SET command", set_ns);
+    report(name + " GET command", get_ns);
+    report(name + " cache add", add_ns);
+    report(name + " cache get", lookup_ns);
+}
+
+// cache memory and lookups for keys padded to key_size bytes, with a small value.
+// memory includes the index, since its slots are part of what a key costs
+void bench_key(long key_size, long num_keys, long iters) {
+    std::vector<std::string> keys = make_keys(num_keys);
+    for (auto &key : keys) {
+        key.resize(key_size, 'k');
+    }
+
+    cache.clear();
+    size_t bytes_before = total_bytes();
+    cache = LRUCache(num_keys, num_keys);
+    for (long i = 0; i < num_keys; i++) {
+        cache.add(keys[i], Value("v"));
+    }
+    double bytes = (double) (total_bytes() - bytes_before) / num_keys;
+
+    double lookup_ns = ns_per_op(iters, [&](long i) {
+        do_not_optimize(cache.get(keys[i % num_keys]));
+    });
+
+    std::string name = std::to_string(key_size) + " byte key";
+    report(name + " memory", bytes, "bytes/key");
+    report(name + " cache get", lookup_ns);
+}
+
+int main() {
+    const long num_keys = 100000;
+    const long iters = 1000000;
+
+    bench_value("int", "12345", num_keys, iters);
+    bench_value("short string", "value", num_keys, iters);
+    bench_value("20 byte string", std::string(20, 'v'), num_keys, iters);
+    bench_value("64 byte string", std::string(64, 'v'), num_keys, iters);
+
+    for (long key_size : {16, 32, 64}) {
+        bench_key(key_size, num_keys, iters);
+    }
+
+    return EXIT_SUCCESS;
+}
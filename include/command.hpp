@@ -2,33 +2,86 @@
 #define COMMAND_H
 
 #include <string>
-#include <vector>
-#include <map>
+#include <string_view>
+#include <cstdint>
 
-#include "entries/base_entry.hpp"
+#include "entries/value.hpp"
+#include "tokens.hpp"
+#include "resp.hpp"
+#include "globals.hpp"
+
+class Command;
 
 namespace cmd {
-    std::string extract_name(const std::string& str);
-    std::string extract_key(const std::string& str);
+    std::string extract_name(std::string_view str);
+    std::string extract_key(std::string_view str);
+
+    // how the leader serves a command
+    enum class Routing : uint8_t {
+        Key,       // sent to the node that owns its key
+        Keys,      // every arg is a key. split by owning node, replies merged in key order
+        Pairs,     // args are key value pairs, split like Keys
+        Local,     // run by the node that received it
+        Sum,       // run on every node, replies added
+        Concat,    // run on every node, replies joined
+        Broadcast, // run on every node, the leader's reply returned
+        Node       // starts or stops nodes, handled by the leader only
+    };
+
+    // command flags
+    constexpr uint8_t READ = 1 << 0;  // reads keys
+    constexpr uint8_t WRITE = 1 << 1; // modifies keys
+    constexpr uint8_t ADMIN = 1 << 2; // changes the server, not keys
+
+    struct Spec {
+        std::string_view name;
+        // nullptr for node commands, which Command does not run
+        std::string (Command::*handler)();
+        // fewest args including the name. with fewer, the error too_few is replied
+        // without running handler, or nil if too_few is nullptr
+        size_t arity;
+        const char *too_few;
+        Routing routing;
+        uint8_t flags;
+    };
 
-    bool addAll(const std::string& str);
-    bool concatAll(const std::string& str);
-    bool askAll(const std::string& str);
+    // finds a command by name, ignoring case. nullptr if there is none
+    const Spec *lookup(std::string_view name);
+
+    bool addAll(std::string_view name);
+    bool concatAll(std::string_view name);
+    bool askAll(std::string_view name);
 
     enum class NodeCMDType {
         Not,
         Nodes,
         Create,
-        Kill
+        Kill,
+        Ring,
+        Skew
     };
 
-    NodeCMDType nodeCmds(const std::string& str);
+    NodeCMDType nodeCmds(std::string_view name);
 
 }
 
 class Command {
 private:
-    std::vector<std::string> args;
+    // views into the request, which must outlive the Command
+    Tokens args;
+    // how replies are formatted
+    resp::Protocol protocol = resp::Protocol::Text;
+    // the node's cache, or the shard of it this thread owns
+    LRUCache &cache = ::cache;
+
+    // replies formatted for protocol. ok() is "SUCCESS" in text and "+OK" in RESP
+    std::string ok();
+    std::string status(std::string_view str);
+    std::string error(std::string_view msg);
+    std::string integer(int64_t num);
+    std::string bulk(std::string_view str);
+    std::string nil();
+    std::string array(const std::vector<std::string> &strs);
 
     std::string echo();
     std::string ping();
@@ -39,6 +92,8 @@ private:
     std::string flushall();
     std::string get();
     std::string set();
+    std::string mget();
+    std::string mset();
     std::string rename();
     std::string del();
     std::string exists();
@@ -54,46 +109,26 @@ private:
     std::string llen();
     std::string hash();
     std::string dist();
+    std::string info();
+    std::string memory();
+    std::string slabs();
+    std::string hello();
 
-    std::map<
-        std::string, 
-        std::function<const std::string()>
-    > cmdMap = {
-        {"echo", std::bind(&Command::echo, this)},
-        {"ping", std::bind(&Command::ping, this)},
-        {"monitor", std::bind(&Command::monitor, this)},
-        {"shutdown", std::bind(&Command::shutdown, this)},
-        {"keys", std::bind(&Command::keys, this)},
-        {"benchmark", std::bind(&Command::benchmark, this)},
-        {"flushall", std::bind(&Command::flushall, this)},
-        {"get", std::bind(&Command::get, this)},
-        {"set", std::bind(&Command::set, this)},
-        {"rename", std::bind(&Command::rename, this)},
-        {"del", std::bind(&Command::del, this)},
-        {"exists", std::bind(&Command::exists, this)},
-        {"dbsize", std::bind(&Command::dbsize, this)},
-        {"type", std::bind(&Command::type, this)},
-        {"expire", std::bind(&Command::expire, this)},
-        {"expireat", std::bind(&Command::expireat, this)},
-        {"persist", std::bind(&Command::persist, this)},
-        {"incr", std::bind(&Command::incrementer, this)},
-        {"incrby", std::bind(&Command::incrementer, this)},
-        {"decr", std::bind(&Command::incrementer, this)},
-        {"decrby", std::bind(&Command::incrementer, this)},
-        {"lpush", std::bind(&Command::list_push, this)},
-        {"rpush", std::bind(&Command::list_push, this)},
-        {"lpop", std::bind(&Command::list_pop, this)},
-        {"rpop", std::bind(&Command::list_pop, this)},
-        {"lrange", std::bind(&Command::lrange, this)},
-        {"llen", std::bind(&Command::llen, this)},
-        {"hash", std::bind(&Command::hash, this)},
-        {"dist", std::bind(&Command::dist, this)}
-    };
-
+    // handlers are private, and only reachable through the command table
+    friend const cmd::Spec *cmd::lookup(std::string_view name);
 
 public:
-    Command(const std::string& str);
+    explicit Command(std::string_view str): args(str) {}
+    explicit Command(const char *str): args(str) {}
+    explicit Command(const Tokens &tokens, resp::Protocol protocol = resp::Protocol::Text, LRUCache &cache = ::cache):
+        args(tokens), protocol(protocol), cache(cache) {}
+    // args would be views into a destroyed string
+    Command(std::string&&) = delete;
     std::string parse_cmd();
+
+    // the reply protocol, which HELLO may have changed. front ends that keep
+    // connections use it for the connection's later replies
+    resp::Protocol get_protocol() const { return protocol; }
 };
 
 
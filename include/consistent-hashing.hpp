@@ -3,14 +3,35 @@
 
 #include <set>
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <zmq.hpp>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <functional>
 
 #include "unix_times.hpp"
+#include "lru_cache.hpp"
+#include "placement.hpp"
 
 constexpr milliseconds::rep ACCEPTABLE_TIME = 2000;
-
-int hash_function(const std::string &str);
+// points each node has on the ring unless --vnodes is given
+constexpr int DEFAULT_VNODES = 16;
+// most points a node may have on the ring
+constexpr int MAX_VNODES = 1024;
+// greatest capacity weight a node may have
+constexpr int MAX_WEIGHT = 100;
+// hashes looked up to find each node's share of the ring
+constexpr uint64_t OWNERSHIP_SAMPLES = 1 << 16;
+
+// where keys and nodes are on the ring, which is every 64-bit value. wyhash, so it is the same on every node
+uint64_t hash_function(std::string_view str);
+// where a node's ith point is on the ring. the first is the hash of pid + endpoint, so a node
+// with one point is placed as before virtual nodes
+uint64_t vnode_hash(const std::string &pid, const std::string &endpoint, int index);
 bool pid_greater(std::string a, std::string b);
 
 
@@ -24,10 +45,15 @@ public:
     std::string pid;
     std::string endpoint;
 
-    int hash;
+    // the node's first point on the ring
+    uint64_t hash;
     bool is_leader;
+    // points the node has on the ring for each unit of weight
+    int vnodes;
+    // the node's capacity relative to others, which its share of keys is in proportion to
+    int weight;
 
-    ServerNode(std::string pid, std::string endpoint, bool is_leader);
+    ServerNode(std::string pid, std::string endpoint, bool is_leader, int vnodes = 1, int weight = 1);
     ~ServerNode();
 
     bool send(const std::string &str);
@@ -39,29 +65,60 @@ public:
 };
 
 
+// orders nodes by hash then pid, given by raw or shared pointer
 struct Compare {
     using is_transparent = void;
 
-    bool operator()(ServerNode* const &node1, ServerNode* const &node2) const {
-        if (node1->hash == node2->hash) {
-            return node1->pid < node2->pid;
+    template <typename A, typename B>
+    bool operator()(const A &a, const B &b) const {
+        const ServerNode &node1 = *a;
+        const ServerNode &node2 = *b;
+        if (node1.hash == node2.hash) {
+            return node1.pid < node2.pid;
         }
         
-        return node1->hash < node2->hash;
-    }
-
-    bool operator()(ServerNode* const &node, const std::string &str) const {
-        return node->hash < hash_function(str);
-    }
-
-    bool operator()(const std::string &str, ServerNode* const&node) const {
-        return hash_function(str) < node->hash;
+        return node1.hash < node2.hash;
     }
 };
 
+// Nodes are placed on the ring at many points, virtual nodes, so each owns many small ranges
+// spread around it instead of one large one. Keys spread more evenly, and a node joining or
+// leaving moves keys from and to every node rather than only its neighbour. Other placements
+// may be chosen at cluster start, see Placement, and are sent to workers with the ring.
+// Lookups don't lock. Changes to the nodes are made under the mutex, then published as a new
+// immutable table behind an atomic pointer, RCU style. get() hashes the key once and looks it
+// up in whichever table is published. A replaced table is freed once no lookup is running,
+// checked after each publish, so a lookup never waits on a change. Nodes are shared by the
+// tables and the callers get() returned them to, so a node removed from the ring is only
+// deleted once nothing holds it.
 class ConsistentHashing {
 private:
-    std::set<ServerNode*, Compare> connected;
+    // a placement of the nodes, and the nodes its indexes are of
+    struct Table {
+        std::vector<std::shared_ptr<ServerNode>> nodes;
+        std::unique_ptr<Placement> placement;
+    };
+
+    using Nodes = std::set<std::shared_ptr<ServerNode>, Compare>;
+
+    // the physical nodes, ordered by their first point
+    Nodes connected;
+    PlacementType placement_type = PlacementType::Ring;
+
+    // the table lookups use
+    std::atomic<const Table*> table { nullptr };
+    // lookups running, and tables replaced while some were
+    std::atomic<int> readers { 0 };
+    std::vector<std::unique_ptr<const Table>> retired;
+
+    // publishes a table of the connected nodes to lookups, which the mutex must be held for
+    void publish();
+
+    // adds a node to connected, or removes one, deleting it once no table or caller holds it and
+    // returning the next node in connected. neither publishes, so a change of many nodes is published
+    // once. the mutex must be held
+    ServerNode *insert(std::string pid, std::string endpoint, bool is_leader, int vnodes, int weight);
+    Nodes::iterator erase(Nodes::iterator it);
     bool dealer_active = false;
     std::string this_pid;
 public:
@@ -71,15 +128,30 @@ public:
     zmq::socket_t *dealer_socket;
     int dealer_connected;
 
+    // takes the entries in groups out of this node's cache for other nodes, see LRUCache::extract.
+    // set by nodes that shard their cache across threads, otherwise the global cache is used
+    std::function<std::vector<std::string>(const LRUCache::Group &group, size_t groups)> extract;
+
     // param mainly used to pass in controlled var for test cases, otherwise just use default
     ConsistentHashing(std::string pid = std::to_string(getpid()));
     ~ConsistentHashing();
+
+    ConsistentHashing(const ConsistentHashing&) = delete;
+    ConsistentHashing& operator=(const ConsistentHashing&) = delete;
     
-    ServerNode *add(std::string pid, std::string endpoint, bool is_leader);
+    ServerNode *add(std::string pid, std::string endpoint, bool is_leader, int vnodes = 1, int weight = 1);
 
-    ServerNode *get(const std::string &str);
+    // how keys are placed on the nodes. set on the leader before nodes join, workers get it with the ring
+    PlacementType placement() { return placement_type; }
+    void set_placement(PlacementType type);
+
+    // the node owning a key, or null if there are no nodes. safe from any thread without the mutex,
+    // and the node stays valid while it is held even if it leaves the ring
+    std::shared_ptr<ServerNode> get(std::string_view str);
     ServerNode *get_next_node(ServerNode *node);
     ServerNode *get_by_pid(const std::string &str);
+    // the node with pid at endpoint, or nullptr if it isn't on the ring
+    ServerNode *find(const std::string &pid, const std::string &endpoint);
 
     void set_up_dealer();
     bool dealer_send(const std::string &msg);
@@ -87,10 +159,19 @@ public:
     std::string to_user_string();
     std::string to_internal_string();
     void update(std::string internal_string);
-    void send_extracted_cache(ServerNode *left, ServerNode *right, bool wrap_around);
+    // extracts the entries this node has that are now owned by other nodes and sends them their entries
+    void send_extracted_cache();
+
+    // the fraction of keys each node owns, by pid, from a sample of hashes
+    std::unordered_map<std::string, double> ownership();
+    // the keys each node has, by pid, and its share of the ring, with the max over the mean of both
+    // per unit of weight
+    std::string skew_report(const std::unordered_map<std::string, int64_t> &keys);
 
     int size() { return connected.size(); }
-    bool is_begin(ServerNode *node) { return size() > 0 && node == *connected.begin(); }
+    // points on the ring, the sum of every node's virtual nodes times its weight
+    int point_count();
+    bool is_begin(ServerNode *node) { return size() > 0 && node == connected.begin()->get(); }
 
     void clean_up_old_nodes();
 
@@ -1,23 +1,59 @@
 #ifndef CACHE_ENTRY_H
 #define CACHE_ENTRY_H
 
-#include "base_entry.hpp"
+#include <cstdint>
 
-class CacheEntry: public BaseEntry {
+#include "value.hpp"
+#include "unix_times.hpp"
+#include "slab_pool.hpp"
+
+class CacheEntry {
 public:
-    EntryType get_type() { return EntryType::cache; }
     std::string key;
-    BaseEntry *cached;
+    Value value;
     seconds::rep expiration = 0; //0 = won't expire
 
+    // footprint last accounted for by the LRUCache
+    size_t memory = 0;
+
+    // intrusive links for the LRU queue (see EntryList)
+    CacheEntry *prev = nullptr;
+    CacheEntry *next = nullptr;
+
+    // intrusive links for the expiration TimingWheel. wheel_slot is -1 when not scheduled
+    CacheEntry *wheel_prev = nullptr;
+    CacheEntry *wheel_next = nullptr;
+    int wheel_slot = -1;
+
+    // recency or reference state owned by the cache's EvictionPolicy
+    uint32_t access = 0;
+
     bool expired() {
         return (expiration > 0 && expiration <= time_secs());
     }
 
-    std::string to_string() { return key; }
+    // approximate bytes used by this entry, including anything it owns on the heap
+    size_t memory_usage() {
+        return sizeof(CacheEntry) + heap_string_size(key) + value.memory_usage();
+    }
+
+    CacheEntry(std::string_view key, Value &&value = Value()): key(key), value(std::move(value)) {}
+
+    // entries are allocated from a slab pool. it is never destroyed, so entries in a
+    // global cache can still be freed while the program exits
+    static SlabPool &pool() {
+        static SlabPool *entries = new SlabPool("entries", sizeof(CacheEntry), alignof(CacheEntry));
+        SlabPool *own = thread_pool();
+        return own ? *own : *entries;
+    }
+    // the calling thread's own pool, see LRUCache::use_thread_pools, or nullptr to share the global one
+    static SlabPool *&thread_pool() {
+        thread_local SlabPool *own = nullptr;
+        return own;
+    }
 
-    CacheEntry(std::string key, BaseEntry *cached): key(key), cached(cached) {}
-    ~CacheEntry() { }
+    static void *operator new(size_t size) { return pool().allocate(); }
+    static void operator delete(void *ptr) { pool().deallocate(ptr); }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,30 +0,0 @@
-#ifndef LIST_ENTRY_H
-#define LIST_ENTRY_H
-
-#include "base_entry.hpp"
-#include "linked_list.hpp"
-
-class ListEntry: public BaseEntry {
-public:
-    EntryType get_type() { return EntryType::list; }
-    LinkedList *list;
-
-    std::string to_string() { 
-        std::vector<std::string> str = list->values(0, -1, false, true);
-        if (str.size() == 0) {
-            return "";
-        }
-
-        return str[0];
-    }
-    
-    ListEntry() {
-        list = new LinkedList();
-    }
-    
-    ~ListEntry() {
-        delete list;
-    }
-};
-
-#endif
\ No newline at end of file
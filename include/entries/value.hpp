@@ -0,0 +1,112 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+class QuickList;
+
+enum class EntryType {
+    none,
+    str,
+    integer,
+    list
+};
+
+// bytes a string owns on the heap, 0 if it fits in the small string buffer
+inline size_t heap_string_size(const std::string &str) {
+    const char *data = str.data();
+    const char *self = reinterpret_cast<const char*>(&str);
+    if (data >= self && data < self + sizeof(std::string)) {
+        return 0;
+    }
+
+    return str.capacity() + 1;
+}
+
+// A cached value: a string, a 64 bit int or a list, in 24 bytes with no vtable.
+// Ints and strings of up to SMALL_CAPACITY bytes are stored inline, so they never allocate.
+// Longer strings own a heap buffer and lists own a QuickList.
+// Values are move only, and a moved from value is none.
+class Value {
+public:
+    static constexpr size_t SMALL_CAPACITY = 22;
+
+private:
+    // the payload: small string bytes, HeapString, int64_t or QuickList*
+    alignas(8) char bytes[SMALL_CAPACITY + 1];
+    // EntryType in the top 2 bits, SMALL_FLAG, and a small string's length in the low 5 bits
+    uint8_t tag = 0;
+
+    static constexpr uint8_t SMALL_FLAG = 0x20;
+    static constexpr uint8_t SIZE_MASK = 0x1F;
+
+    struct HeapString {
+        char *data;
+        size_t size;
+    };
+
+    template <typename T>
+    T load() const {
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void store(T value) { std::memcpy(bytes, &value, sizeof(T)); }
+
+    bool is_small() const { return tag & SMALL_FLAG; }
+    void set_tag(EntryType type, uint8_t flags = 0) { tag = (static_cast<uint8_t>(type) << 6) | flags; }
+    // frees anything owned and becomes none
+    void reset();
+
+public:
+    Value() {}
+    explicit Value(std::string_view str);
+    explicit Value(int64_t integer) { set_tag(EntryType::integer); store(integer); }
+    explicit Value(int integer): Value(static_cast<int64_t>(integer)) {}
+    Value(std::nullptr_t) = delete;
+    // takes ownership of list
+    explicit Value(QuickList *list) { set_tag(EntryType::list); store(list); }
+
+    ~Value() { reset(); }
+
+    Value(const Value&) = delete;
+    Value& operator=(const Value&) = delete;
+    Value(Value &&other) noexcept;
+    Value& operator=(Value &&other) noexcept;
+
+    // a value holding a new empty list
+    static Value new_list();
+
+    EntryType type() const { return static_cast<EntryType>(tag >> 6); }
+    bool is_none() const { return type() == EntryType::none; }
+    bool is_str() const { return type() == EntryType::str; }
+    bool is_int() const { return type() == EntryType::integer; }
+    bool is_list() const { return type() == EntryType::list; }
+
+    // only valid for the matching type
+    std::string_view str() const;
+    int64_t integer() const { return load<int64_t>(); }
+    void set_integer(int64_t integer) { store(integer); }
+    QuickList *list() const { return load<QuickList*>(); }
+
+    // lists are their values separated by spaces
+    std::string to_string() const;
+    // bytes owned outside of the Value itself
+    size_t memory_usage() const;
+};
+
+// parses a value sent by a client: values with spaces are lists of values,
+// digit only values that fit in 64 bits are ints, and everything else is a string
+Value str_to_value(std::string_view str);
+
+// parses a single argument: digit only values that fit in 64 bits are ints, and everything else
+// is a string, spaces included. used for binary safe values, which are never split into lists
+Value arg_to_value(std::string_view str);
+
+#endif
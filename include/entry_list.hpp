@@ -0,0 +1,52 @@
+#ifndef ENTRY_LIST_H
+#define ENTRY_LIST_H
+
+#include <vector>
+#include <string>
+
+#include "entries/cache_entry.hpp"
+
+// Intrusive doubly linked list of CacheEntry used as the LRU queue.
+// The prev/next links live inside the entries, so moving an entry never allocates.
+// The list owns its entries: clear() deletes them, but remove() only unlinks.
+class EntryList {
+private:
+    long size = 0;
+    CacheEntry *head = nullptr;
+    CacheEntry *tail = nullptr;
+
+public:
+    EntryList() {}
+    ~EntryList() { clear(); }
+
+    EntryList(const EntryList&) = delete;
+    EntryList& operator=(const EntryList&) = delete;
+    EntryList(EntryList &&other);
+    EntryList& operator=(EntryList &&other);
+
+    long get_size() { return size; }
+    CacheEntry *front() { return head; }
+    CacheEntry *back() { return tail; }
+
+    void add_end(CacheEntry *entry);
+    void add_front(CacheEntry *entry);
+
+    // unlinks the entry without freeing it
+    CacheEntry *remove(CacheEntry *entry);
+    // unlinks and returns the head, or nullptr if empty
+    CacheEntry *remove_front();
+
+    void move_to_end(CacheEntry *entry);
+    void move_to_front(CacheEntry *entry);
+
+    // deletes every entry
+    void clear();
+    // forgets every entry without freeing them, for when they are freed in bulk
+    void release() { size = 0; head = nullptr; tail = nullptr; }
+
+    // returns the keys of unexpired entries from head to tail
+    // if single_str is true, will return one string at index 0 representing the keys
+    std::vector<std::string> keys(bool single_str = false);
+};
+
+#endif
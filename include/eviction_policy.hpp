@@ -0,0 +1,162 @@
+#ifndef EVICTION_POLICY_H
+#define EVICTION_POLICY_H
+
+#include <memory>
+#include <vector>
+#include <string>
+
+#include "entries/cache_entry.hpp"
+#include "entry_list.hpp"
+#include "key_index.hpp"
+#include "frequency_sketch.hpp"
+
+// keys examined per eviction by SampledPolicy, like Redis' maxmemory-samples
+constexpr int EVICTION_SAMPLES = 5;
+
+// share of the entries TinyLFUPolicy keeps in its admission window, and of the rest in its protected segment
+constexpr int TINYLFU_WINDOW_PERCENT = 1;
+constexpr int TINYLFU_PROTECTED_PERCENT = 80;
+// largest number of keys the sketch is sized for up front
+constexpr long TINYLFU_MAX_SKETCH_KEYS = 1 << 24;
+
+// Decides which entry an LRUCache evicts next. The policy owns the cache's entries:
+// clear() and the destructor delete them, while remove() and release() only unlink.
+class EvictionPolicy {
+public:
+    virtual ~EvictionPolicy() {}
+
+    virtual std::string name() = 0;
+    // the cache will hold at most max_entries entries
+    virtual void reserve(long max_entries) {}
+
+    // a new entry was added to the cache
+    virtual void insert(CacheEntry *entry) = 0;
+    // an existing entry was read or written
+    virtual void access(CacheEntry *entry) = 0;
+    // a key that is not in the cache was looked up
+    virtual void miss(std::string_view key) {}
+    // unlinks an entry that is leaving the cache without freeing it
+    virtual void remove(CacheEntry *entry) = 0;
+    // marks an entry to be evicted before the others
+    virtual void demote(CacheEntry *entry) = 0;
+
+    // returns the next entry to evict without unlinking it, never returning keep.
+    // returns nullptr if there is no other entry. index holds every entry in the cache
+    virtual CacheEntry *victim(const KeyIndex &index, CacheEntry *keep) = 0;
+
+    // returns the keys of unexpired entries, in eviction order when the policy keeps one
+    // if single_str is true, will return one string at index 0 representing the keys
+    virtual std::vector<std::string> keys(bool single_str = false) = 0;
+
+    // deletes every entry
+    virtual void clear() = 0;
+    // forgets every entry without freeing them, for when the cache frees them in bulk
+    virtual void release() = 0;
+};
+
+// Exact LRU. Every access moves the entry to the end of the queue
+class LRUPolicy: public EvictionPolicy {
+private:
+    // least recently used at the front
+    EntryList entries;
+public:
+    std::string name() { return "lru"; }
+
+    void insert(CacheEntry *entry) { entries.add_end(entry); }
+    void access(CacheEntry *entry) { entries.move_to_end(entry); }
+    void remove(CacheEntry *entry) { entries.remove(entry); }
+    void demote(CacheEntry *entry) { entries.move_to_front(entry); }
+    CacheEntry *victim(const KeyIndex &index, CacheEntry *keep);
+
+    std::vector<std::string> keys(bool single_str = false) { return entries.keys(single_str); }
+    void clear() { entries.clear(); }
+    void release() { entries.release(); }
+};
+
+// Approximate LRU in the style of Redis. An access only stamps the entry with a logical clock,
+// and eviction picks the oldest of EVICTION_SAMPLES random entries from the index
+class SampledPolicy: public EvictionPolicy {
+private:
+    // insertion order, only used to own and list the entries
+    EntryList entries;
+    // ticks once per access. ages are compared with unsigned wrap around
+    uint32_t clock = 0;
+    uint64_t rand_state = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t next_rand();
+public:
+    std::string name() { return "sampled"; }
+
+    void insert(CacheEntry *entry) { entry->access = ++clock; entries.add_end(entry); }
+    void access(CacheEntry *entry) { entry->access = ++clock; }
+    void remove(CacheEntry *entry) { entries.remove(entry); }
+    void demote(CacheEntry *entry) { entry->access = clock - (UINT32_MAX >> 1); }
+    CacheEntry *victim(const KeyIndex &index, CacheEntry *keep);
+
+    std::vector<std::string> keys(bool single_str = false) { return entries.keys(single_str); }
+    void clear() { entries.clear(); }
+    void release() { entries.release(); }
+};
+
+// CLOCK (second chance). An access only sets the entry's reference bit. Eviction sweeps
+// from the front, moving referenced entries to the end with their bit cleared
+class ClockPolicy: public EvictionPolicy {
+private:
+    // front of the list is the clock hand
+    EntryList entries;
+public:
+    std::string name() { return "clock"; }
+
+    void insert(CacheEntry *entry) { entry->access = 0; entries.add_end(entry); }
+    void access(CacheEntry *entry) { entry->access = 1; }
+    void remove(CacheEntry *entry) { entries.remove(entry); }
+    void demote(CacheEntry *entry) { entry->access = 0; entries.move_to_front(entry); }
+    CacheEntry *victim(const KeyIndex &index, CacheEntry *keep);
+
+    std::vector<std::string> keys(bool single_str = false) { return entries.keys(single_str); }
+    void clear() { entries.clear(); }
+    void release() { entries.release(); }
+};
+
+// W-TinyLFU. New entries enter a small LRU admission window. When the cache is full, the window's
+// LRU entry only moves into the main region if a count-min sketch says it has been requested more
+// often than the main region's victim, so a scan of one-off keys cannot flush frequently used keys.
+// The main region is a segmented LRU: entries start on probation and are protected once hit again.
+// An entry's access field holds the segment it is in
+class TinyLFUPolicy: public EvictionPolicy {
+private:
+    enum Segment { window = 0, probation = 1, protect = 2 };
+
+    EntryList window_entries;
+    EntryList probation_entries;
+    EntryList protected_entries;
+    FrequencySketch sketch;
+
+    long total() { return window_entries.get_size() + probation_entries.get_size() + protected_entries.get_size(); }
+    long window_max();
+    long protected_max();
+
+    EntryList &segment(CacheEntry *entry);
+    void move(CacheEntry *entry, Segment to);
+    uint8_t frequency(CacheEntry *entry) { return sketch.frequency(KeyIndex::hash_key(entry->key)); }
+public:
+    std::string name() { return "tinylfu"; }
+    void reserve(long max_entries);
+
+    void insert(CacheEntry *entry);
+    void access(CacheEntry *entry);
+    void miss(std::string_view key) { sketch.increment(KeyIndex::hash_key(key)); }
+    void remove(CacheEntry *entry) { segment(entry).remove(entry); }
+    void demote(CacheEntry *entry);
+    CacheEntry *victim(const KeyIndex &index, CacheEntry *keep);
+
+    // probation, then protected, then window
+    std::vector<std::string> keys(bool single_str = false);
+    void clear();
+    void release();
+};
+
+// returns the policy with the given name (lru, sampled, clock or tinylfu), or nullptr if there is none
+std::unique_ptr<EvictionPolicy> make_eviction_policy(const std::string &name);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef FREQUENCY_SKETCH_H
+#define FREQUENCY_SKETCH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+constexpr int SKETCH_DEPTH = 4;
+// counters per row for each key the sketch is sized for. more columns mean fewer collisions
+constexpr int SKETCH_COLUMNS_PER_KEY = 4;
+constexpr uint8_t SKETCH_MAX_COUNT = 15;
+// counters are halved after this many increments per key the sketch is sized for
+constexpr int SKETCH_SAMPLE_FACTOR = 10;
+
+// Count-min sketch estimating how often a key hash has been seen recently, as used by TinyLFU.
+// Each of the SKETCH_DEPTH rows has one 4 bit saturating counter per column, packed two to a byte,
+// and a key's estimate is the minimum of its counter in each row. Every SKETCH_SAMPLE_FACTOR * capacity
+// increments all counters are halved, so old popularity fades.
+class FrequencySketch {
+private:
+    std::vector<uint8_t> table; // SKETCH_DEPTH rows of width counters
+    size_t width = 0; // always a power of 2
+    size_t additions = 0;
+
+    // index of the counter for hash in row
+    size_t index(uint64_t hash, int row) const;
+    uint8_t get(size_t i) const { return (table[i / 2] >> (i % 2 * 4)) & 0xF; }
+    void age();
+
+public:
+    FrequencySketch(size_t capacity = 16) { resize(capacity); }
+
+    // sizes the sketch for about capacity distinct keys. resets all counts if the width changes
+    void resize(size_t capacity);
+    size_t get_width() const { return width; }
+    // distinct keys the sketch is sized for
+    size_t get_capacity() const { return width / SKETCH_COLUMNS_PER_KEY; }
+    size_t memory_usage() const { return table.size(); }
+
+    void increment(uint64_t hash);
+    uint8_t frequency(uint64_t hash) const;
+
+    void clear();
+};
+
+#endif
@@ -4,9 +4,19 @@
 #include "lru_cache.hpp"
 #include "consistent-hashing.hpp"
 
-// global vars used by the nodes
+// global vars used by the nodes, defined once in src/globals.cpp
 extern int client_port;
 extern int internal_port;
+// port for RESP clients over plain TCP, or -1 if not served
+extern int tcp_port;
+// executor threads a node runs its cache's shards on, or 1 to run commands on the request thread
+extern int worker_threads;
+// whether each executor thread is pinned to its own core
+extern bool pin_threads;
+// points each node has on the hash ring
+extern int virtual_nodes;
+// this node's capacity relative to others, which its share of keys is in proportion to
+extern int node_weight;
 extern ConsistentHashing ring;
 
 extern bool monitoring;
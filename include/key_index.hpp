@@ -0,0 +1,113 @@
+#ifndef KEY_INDEX_H
+#define KEY_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+class CacheEntry;
+
+// Open addressing hash index from key to CacheEntry, in the style of a Swiss table.
+// Each slot has a control byte that is either EMPTY, DELETED, or the low 7 bits of the key's hash.
+// Lookups compare 16 control bytes at a time (with SSE2 when available) and only
+// touch a slot's key when its control byte matches. Slots only hold the full hash and the entry:
+// keys are stored once, in their CacheEntry, so an entry's key must not change while it is indexed.
+class KeyIndex {
+public:
+    struct Slot {
+        uint64_t hash;
+        CacheEntry *value;
+    };
+
+    static constexpr size_t GROUP_SIZE = 16;
+
+    class iterator {
+    private:
+        const KeyIndex *index;
+        size_t i;
+
+        void skip_empty();
+    public:
+        iterator(const KeyIndex *index, size_t i): index(index), i(i) { skip_empty(); }
+
+        Slot &operator*() const { return index->slots[i]; }
+        Slot *operator->() const { return &index->slots[i]; }
+        iterator &operator++() { i++; skip_empty(); return *this; }
+        bool operator==(const iterator &other) const { return i == other.i; }
+        bool operator!=(const iterator &other) const { return i != other.i; }
+
+        friend class KeyIndex;
+    };
+
+private:
+    // control bytes. Full slots are in [0, 127]
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    // capacity + GROUP_SIZE control bytes. The first GROUP_SIZE bytes are mirrored
+    // at the end so a group load starting near the end never needs to wrap
+    int8_t *ctrl = nullptr;
+    Slot *slots = nullptr;
+
+    size_t capacity = 0; // always 0 or a power of 2 >= GROUP_SIZE
+    size_t used = 0;
+    size_t tombstones = 0;
+
+    static uint64_t h1(uint64_t hash) { return hash >> 7; }
+    static int8_t h2(uint64_t hash) { return hash & 0x7F; }
+
+    void set_ctrl(size_t i, int8_t value);
+    void rehash(size_t new_capacity);
+
+    // returns the slot index holding key, or capacity if not found
+    size_t find_index(std::string_view key, uint64_t hash) const;
+    // returns an EMPTY or DELETED slot index for a key known not to be present
+    size_t find_insert_index(uint64_t hash) const;
+
+    // bitmask of the positions in the group starting at pos whose control byte equals value
+    uint32_t match(size_t pos, int8_t value) const;
+    uint32_t match_empty_or_deleted(size_t pos) const;
+
+public:
+    KeyIndex() {}
+    ~KeyIndex();
+
+    KeyIndex(const KeyIndex&) = delete;
+    KeyIndex& operator=(const KeyIndex&) = delete;
+    KeyIndex(KeyIndex &&other);
+    KeyIndex& operator=(KeyIndex &&other);
+
+    static uint64_t hash_key(std::string_view key);
+    // bytes a key costs in the index: its slot and control byte
+    static size_t slot_memory() { return sizeof(Slot) + 1; }
+
+    size_t size() const { return used; }
+    size_t max_size() const { return SIZE_MAX / sizeof(Slot); }
+    size_t bucket_count() const { return capacity; }
+    // bytes owned by the table
+    size_t memory_usage() const;
+
+    // makes room for n keys without rehashing
+    void reserve(size_t n);
+    void clear();
+
+    // returns nullptr if the key is not present
+    CacheEntry *find(std::string_view key) const;
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+    // indexes entry under entry->key, which the index reads from the entry from then on.
+    // returns false and leaves the index unchanged if the key is already present
+    bool insert(CacheEntry *entry);
+    // returns false if the key was not present
+    bool erase(std::string_view key);
+
+    // returns the first entry at or after slot r % bucket_count(), or nullptr if empty.
+    // used to pick random eviction candidates without keeping a separate structure
+    CacheEntry *sample(uint64_t r) const;
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, capacity); }
+};
+
+#endif
@@ -2,11 +2,136 @@
 #define LEADER_H
 
 #include <zmq.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
 #include "consistent-hashing.hpp"
+#include "tcp_server.hpp"
+#include "unix_times.hpp"
+#include "shards.hpp"
+#include "tokens.hpp"
+
+// how long a worker has to reply to a forwarded request before the client is told it failed
+constexpr milliseconds::rep FORWARD_TIMEOUT_MS = ACCEPTABLE_TIME;
+
+class ClientRequests;
 
 void start_leader();
 void handle_internal_requests();
-void handle_client_requests();
+void handle_client_requests(ClientRequests &clients);
 void handle_nodes_cleanup();
 
-#endif
\ No newline at end of file
+// Serves clients on the leader without waiting on workers. ZMQ clients connect to a ROUTER socket and
+// TCP clients to a TcpServer, both served from one loop. Requests for keys on other nodes are sent through
+// one ROUTER socket connected to every worker, tagged with a request id. Workers' REP sockets queue requests
+// and send the id back with the reply, so many requests can be in flight to each worker and replies are
+// passed on as they arrive, in any order. Commands that ask every node still wait for all of them.
+// A ZMQ message may hold many RESP requests back to back, a batch. Its requests are split by owning node
+// and each worker is sent one BATCH message of its requests, then the replies are put back in order.
+// A request that asks every node waits for the requests before it, so each node runs them in order.
+// Multi-key commands such as MGET are split the same way, one command per node for its keys, and the
+// replies merged in key order.
+// With --threads, the leader's own keys are served by Shards on executor threads, which are submitted to
+// and replied from like workers, so one process can serve the whole keyspace on every core.
+class ClientRequests {
+private:
+    struct Batch;
+
+    // a request or sub-batch forwarded to a worker, waiting for its reply
+    struct Pending {
+        // the ZMQ client's routing frames, or empty for a TCP client or a batch
+        std::vector<zmq::message_t> envelope;
+        TcpServer::Ticket ticket;
+        // the batch the requests are part of, and where their replies go in it
+        std::shared_ptr<Batch> batch;
+        std::vector<size_t> indexes;
+        resp::Protocol protocol;
+        milliseconds::rep deadline;
+    };
+
+    // requests split across nodes, replied to once every node has replied
+    struct Batch {
+        // who is waiting for the batch's reply, which may be another batch
+        Pending origin;
+        std::vector<std::string> replies;
+        // parts forwarded to workers that haven't replied
+        size_t waiting = 0;
+        // for a multi-key command, where each part's keys were in the command. empty for a batch
+        std::vector<std::vector<size_t>> keys;
+        size_t key_count = 0;
+        // for a batch, its message, its requests as views into it, and how many have been served
+        std::string msg;
+        std::vector<Tokens> requests;
+        size_t served = 0;
+    };
+
+    std::string leader_pid;
+
+    zmq::context_t context{1};
+    zmq::socket_t client_socket;
+    zmq::socket_t worker_socket;
+    TcpServer tcp_server;
+    // the leader's cache split across executor threads, or null to run commands on this thread
+    std::unique_ptr<Shards> shards;
+
+    std::unordered_map<uint64_t, Pending> pending;
+    // request ids in the order they were sent, which is also the order they time out
+    std::deque<uint64_t> pending_order;
+    uint64_t next_request_id = 0;
+    // endpoints worker_socket is connected to, by pid
+    std::unordered_map<std::string, std::string> worker_endpoints;
+
+    // routes a request through the cluster. returns true with its reply appended to reply, or false
+    // if it was forwarded to a worker, taking origin to reply to once the worker does.
+    // protocol is the client's, which HELLO may change
+    bool serve_request(const Tokens &tokens, resp::Protocol &protocol, std::string &reply, Pending &origin);
+    // splits a batch by owning node. returns false if a request in it is malformed
+    bool serve_batch(std::string_view msg, std::vector<zmq::message_t> &&envelope);
+    // serves a batch's requests from the first not yet served. stops before a request that must see
+    // the replies to those before it, and is called again once they are in
+    void continue_batch(std::shared_ptr<Batch> batch);
+    // sends each node the part of a multi-key command for its keys, with step args per key.
+    // returns like serve_request
+    bool serve_keys(const Tokens &tokens, size_t step, resp::Protocol protocol, std::string &reply, Pending &origin);
+    // runs a command for a key the leader owns. returns like serve_request
+    bool serve_local(const Tokens &tokens, resp::Protocol protocol, std::string &reply, Pending &origin);
+    // runs a COMMAND or BATCH message on the shards, replying to origin once they do
+    void submit(const std::string &msg, Pending &origin);
+    // sends a message to the worker with pid at endpoint. returns false if it can't be sent
+    bool forward(const std::string &pid, const std::string &endpoint, const std::string &msg, Pending &origin);
+
+    // sends msg to every worker and returns their replies, once all have replied or the dealer times out.
+    // for the rare commands that ask every node
+    std::vector<std::string> ask_workers(const std::string &msg);
+    // runs a message on this node, on its shards if it has them
+    std::string ask_local(const Tokens &tokens, resp::Protocol protocol);
+
+    // sends a worker's reply to the client that is waiting for it
+    void send_reply(Pending &origin, zmq::message_t &reply);
+    // puts a worker's replies to a sub-batch in their places, sending the batch's reply if it was the last
+    void complete_batch(Pending &origin, std::string_view replies);
+    // sends a batch's replies in the order of its requests, or a multi-key command's merged reply
+    void send_batch(Batch &batch);
+
+    void serve_clients();
+    void serve_worker_replies();
+    // fails forwarded requests whose worker hasn't replied in time
+    void expire_pending();
+    // disconnects from workers that have left the ring
+    void disconnect_old_workers();
+
+public:
+    ClientRequests();
+
+    ClientRequests(const ClientRequests&) = delete;
+    ClientRequests& operator=(const ClientRequests&) = delete;
+
+    // serves clients until the node is stopped
+    void run();
+};
+
+#endif
@@ -2,52 +2,130 @@
 #define LRU_CACHE_H
 
 #include <vector>
-#include <unordered_map>
 #include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <cstdint>
 
-#include "entries/base_entry.hpp"
 #include "entries/cache_entry.hpp"
-#include "linked_list.hpp"
+#include "eviction_policy.hpp"
+#include "key_index.hpp"
+#include "timing_wheel.hpp"
 
 constexpr long DEFAULT_INITIAL_SIZE = 100;
 constexpr long DEFAULT_MAX_SIZE = 5000;
+constexpr long DEFAULT_MAX_MEMORY = 0; // 0 = no byte limit
+
+// active expiration runs for at most this long between requests
+constexpr long ACTIVE_EXPIRE_BUDGET_US = 1000;
+// nodes wait at most this long for a request before running active expiration
+constexpr int ACTIVE_EXPIRE_INTERVAL_MS = 100;
+// seconds of history used for expired_per_sec()
+constexpr int EXPIRE_STATS_WINDOW = 10;
 
 class LRUCache {
+public:
+    // which of extract's groups the entry with a key's hash goes in, or -1 to keep it
+    using Group = std::function<int(uint64_t hash)>;
+
 private:
-    std::unordered_map<std::string, Node*> keyMap;
+    KeyIndex keyMap;
+
+    // owns the entries and picks which to evict. exact LRU unless changed with set_eviction()
+    std::unique_ptr<EvictionPolicy> policy;
+
+    // entries with an expiration, for active expiration
+    TimingWheel expirations;
+
+    // bytes used by all entries, their keys and their index slots
+    long used_memory = 0;
+
+    // total keys expired, and keys expired in each of the last EXPIRE_STATS_WINDOW seconds
+    long expired_total = 0;
+    long expired_window[EXPIRE_STATS_WINDOW] = {};
+    seconds::rep expired_window_secs[EXPIRE_STATS_WINDOW] = {};
+    void count_expired(long num);
 
-    //LinkedList of CacheEntry
-    LinkedList entries; 
+    // footprint of an entry including its slot in keyMap
+    size_t entry_memory(CacheEntry *entry);
+    // unlinks an entry from keyMap and the eviction policy and frees it
+    void delete_entry(CacheEntry *entry);
+    // evicts the policy's victims until used_memory fits in max_memory, never evicting keep
+    void evict_to_fit(CacheEntry *keep);
 public:
-    LRUCache(long initial_size = DEFAULT_INITIAL_SIZE, long max_map_size = DEFAULT_MAX_SIZE);
-    LRUCache(const std::string &import_str, long initial_size = DEFAULT_INITIAL_SIZE, long max_map_size = DEFAULT_MAX_SIZE);
+    LRUCache(long initial_size = DEFAULT_INITIAL_SIZE, long max_map_size = DEFAULT_MAX_SIZE, long max_map_memory = DEFAULT_MAX_MEMORY);
+    LRUCache(const std::string &import_str, long initial_size = DEFAULT_INITIAL_SIZE, long max_map_size = DEFAULT_MAX_SIZE, long max_map_memory = DEFAULT_MAX_MEMORY);
 
     ~LRUCache() { clear(); }
+
+    // gives the calling thread its own slab pools for entries and lists. a cache only used by
+    // one thread, such as a worker's shard, then allocates without sharing pools with others
+    static void use_thread_pools();
+    // frees the calling thread's pools, once every cache using them is destroyed
+    static void release_thread_pools();
+
+    LRUCache(LRUCache&&) = default;
+    LRUCache& operator=(LRUCache&&) = default;
     
     long max_size;
     long size() { return keyMap.size(); }
 
-    // adds an entry, deleting the entry at the start of the LRU queue if full
-    void add(const std::string& key, BaseEntry *value);
-    BaseEntry *remove(const std::string& key);
+    // max bytes before evicting, 0 = unlimited
+    long max_memory;
+    long memory() { return used_memory; }
+
+    // adds an entry, evicting the policy's victim if full
+    // returns the entry now holding value
+    CacheEntry *add(std::string_view key, Value &&value);
+    // returns the removed value, or a none value if key was not found
+    Value remove(std::string_view key);
+
+    // returns nullptr if key was not found
+    Value *get(std::string_view key);
+    CacheEntry *get_cache_entry(std::string_view key);
 
-    BaseEntry *get(const std::string& key);
-    CacheEntry *get_cache_entry(const std::string& key);
+    // recompute an entry's footprint after its value was modified in place.
+    // may evict other entries to stay within max_memory
+    void update_memory(CacheEntry *entry);
+    // bytes used by key, or -1 if not found
+    long memory_usage(std::string_view key);
 
     std::vector<std::string> key_set(bool single_str = false);
 
-    bool set_expire(const std::string& key, std::time_t time);
+    // replaces the eviction policy, moving every entry over. recency is not carried over,
+    // so this is meant to be called before the cache fills up
+    void set_eviction(std::unique_ptr<EvictionPolicy> new_policy);
+    std::string eviction() { return policy->name(); }
+
+    bool set_expire(std::string_view key, std::time_t time);
+
+    // deletes expired keys in small steps until none are due or max_us microseconds pass.
+    // returns the number of keys deleted
+    long active_expire(long max_us = ACTIVE_EXPIRE_BUDGET_US);
+    // number of keys waiting in the expiration wheel
+    long expires_scheduled() { return expirations.size(); }
+
+    long expired_keys() { return expired_total; }
+    // average keys expired per second over the last EXPIRE_STATS_WINDOW seconds
+    double expired_per_sec();
 
     void clear();
 
-    // returns import_strs for all entries grouped based on the specified bounds: [prev_bound, cur_bound)
-    // also moves all grouped entries to the start of the LRU queue for imminent deletion
-    // for example: given [50, 100, 200] and start = 0, partitions the cache into hashes of values [50, 100), [100, 200).
-    // If an element is negative, it will wrap around. e.g.[-300, 50, 100] -> the first bound would be [300, 360) U [0, 50).
-    std::vector<std::string> extract(std::vector<int> upper_bounds);
+    // returns import_strs, as RESP key and value arrays, for all entries grouped based on the specified bounds: [prev_bound, cur_bound)
+    // also demotes all grouped entries in the eviction policy for imminent deletion
+    // for example: given [50, 100, 200], partitions the cache into hashes of values [50, 100), [100, 200).
+    // A bound below the one before wraps around the ring, e.g. [300, 50] is [300, 2^64) U [0, 50),
+    // and a bound equal to the one before is the whole ring, so [0, 0] extracts every entry.
+    std::vector<std::string> extract(const std::vector<uint64_t> &upper_bounds);
+    // the same for any grouping of hashes into groups, such as by the node that now owns them
+    std::vector<std::string> extract(const Group &group, size_t groups);
+    // groups hashes by which range between consecutive upper_bounds they are in, as the bounds overload does
+    static Group by_ranges(const std::vector<uint64_t> &upper_bounds);
 
-    // import entries from another LRU cache from extract()
-    bool import(const std::string& import_str);
+    // import entries from another LRU cache from extract(). returns false if import_str is malformed,
+    // keeping the entries before the malformed one
+    bool import(std::string_view import_str);
 };
 
 #endif
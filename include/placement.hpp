@@ -0,0 +1,119 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// how keys are placed on nodes, chosen when the leader starts with --placement
+enum class PlacementType {
+    // consistent hashing with virtual nodes
+    Ring,
+    // jump consistent hash
+    Jump,
+    // rendezvous, or highest random weight, hashing
+    Rendezvous,
+    // consistent hashing with bounded loads
+    Bounded
+};
+
+// parses a placement's name. returns false if it isn't one
+bool parse_placement(std::string_view name, PlacementType &type);
+const char *placement_name(PlacementType type);
+
+// bounded placement caps each node at 1 + BOUNDED_LOAD_EPSILON times its weight's share of keys
+constexpr double BOUNDED_LOAD_EPSILON = 0.25;
+// bounded placement splits the ring into 2^BOUNDED_SLOT_BITS slots, which are what it balances
+constexpr int BOUNDED_SLOT_BITS = 16;
+
+// An immutable lookup from a key's hash to the node that owns it, built from the nodes whenever
+// they change. Each node owns a share of hashes in proportion to its weight. Every node builds the same placement from the same nodes in any order, so they and
+// smart clients agree on owners.
+class Placement {
+public:
+    struct Node {
+        std::string pid;
+        std::string endpoint;
+        // points on the ring for each unit of weight, for placements that use one
+        int vnodes;
+        // the node's capacity relative to others, which its share of hashes is in proportion to
+        int weight = 1;
+    };
+
+    virtual ~Placement() = default;
+
+    // the index in nodes of the node owning hash. nodes must not be empty
+    virtual size_t get(uint64_t hash) const = 0;
+
+    static std::unique_ptr<Placement> make(PlacementType type, const std::vector<Node> &nodes);
+};
+
+// Each node is at vnodes times weight points on the ring, and owns the hashes from each of its points
+// up to the next. A lookup is a binary search of the points. A node joining takes keys only from the nodes
+// before its points, but shares are only as even as the points are many.
+class RingPlacement : public Placement {
+protected:
+    struct Point {
+        uint64_t hash;
+        int index;
+        size_t node;
+    };
+
+    std::vector<Point> points;
+
+    // the index in points of the point owning hash
+    size_t point_of(uint64_t hash) const;
+
+public:
+    explicit RingPlacement(const std::vector<Node> &nodes);
+    size_t get(uint64_t hash) const override;
+};
+
+// Jump consistent hash (Lamping and Veach) picks one of n buckets from the hash in O(log n) with no
+// table, and moves the fewest keys when a bucket is added at the end. Buckets are nodes in pid order,
+// so a node started later, which usually has a greater pid, is added at the end. A node has as many
+// consecutive buckets as its weight. Removing any node other than the last renumbers the ones after
+// it, moving many keys.
+class JumpPlacement : public Placement {
+private:
+    // the node of each bucket, weight buckets per node
+    std::vector<size_t> buckets;
+
+public:
+    explicit JumpPlacement(const std::vector<Node> &nodes);
+    size_t get(uint64_t hash) const override;
+};
+
+// Rendezvous hashing scores every node for a key and picks the highest. Shares are even without
+// virtual nodes and a node joining or leaving moves only its own keys, but lookups are O(n). Scores
+// are weight / -ln(u) for a uniform u from the hashes (Schindelhauer and Schomaker), so a node wins
+// in proportion to its weight.
+class RendezvousPlacement : public Placement {
+private:
+    // each node's hash, mixed with the key's to score it
+    std::vector<uint64_t> seeds;
+    std::vector<double> weights;
+
+public:
+    explicit RendezvousPlacement(const std::vector<Node> &nodes);
+    size_t get(uint64_t hash) const override;
+};
+
+// Consistent hashing with bounded loads (Mirrokni, Thorup and Zadimoghaddam) over the ring's slots.
+// Each slot goes to the node owning it on the ring unless that node already has its cap of slots,
+// 1 + BOUNDED_LOAD_EPSILON times its weight's share, and then to the next node along the ring with room.
+// No node gets much more than the average even with few points, at the cost of a join moving
+// some slots between other nodes. Lookups index a table of slots.
+class BoundedPlacement : public RingPlacement {
+private:
+    // the node of each slot
+    std::vector<uint32_t> slots;
+
+public:
+    explicit BoundedPlacement(const std::vector<Node> &nodes);
+    size_t get(uint64_t hash) const override;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef QUICK_LIST_H
+#define QUICK_LIST_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "entries/value.hpp"
+#include "slab_pool.hpp"
+
+// bytes per chunk, including its header
+constexpr size_t QUICKLIST_CHUNK_SIZE = 512;
+// strings longer than this are kept in their own heap buffer, with only a pointer in the chunk
+constexpr size_t QUICKLIST_INLINE_MAX = 64;
+
+// List of values in the style of Redis' quicklist: a doubly linked list of fixed size chunks,
+// each packing many elements back to back. An element is a tag byte, its payload, and a trailing
+// byte with its total size so chunks can be walked in both directions:
+// - ints use the fewest of 1, 2, 4 or 8 bytes that hold them
+// - strings of up to QUICKLIST_INLINE_MAX bytes are a length byte and the string
+// - longer strings are a pointer and size of a heap buffer owned by the list
+// Lists can not hold lists, so a list value is added as the string of its values.
+// Pushing and popping at either end is O(1), and indexing walks chunk counts before elements.
+class QuickList {
+private:
+    struct Chunk {
+        Chunk *prev = nullptr;
+        Chunk *next = nullptr;
+        uint16_t bytes = 0; // used bytes of data
+        uint16_t count = 0; // elements in data
+        char data[QUICKLIST_CHUNK_SIZE - 2 * sizeof(Chunk*) - 2 * sizeof(uint16_t)];
+
+        static SlabPool &pool() {
+            static SlabPool *chunks = new SlabPool("chunks", sizeof(Chunk), alignof(Chunk));
+            SlabPool *own = thread_pool();
+            return own ? *own : *chunks;
+        }
+        static SlabPool *&thread_pool() {
+            thread_local SlabPool *own = nullptr;
+            return own;
+        }
+
+        static void *operator new(size_t size) { return pool().allocate(); }
+        static void operator delete(void *ptr) { pool().deallocate(ptr); }
+    };
+
+    // an element's position
+    struct Cursor {
+        Chunk *chunk;
+        size_t offset;
+    };
+
+    int size = 0;
+    long chunks = 0;
+    // bytes of heap buffers owned by long strings
+    size_t heap_bytes = 0;
+    Chunk *head = nullptr;
+    Chunk *tail = nullptr;
+
+    // bytes needed to encode value, which must be a string or an int
+    static size_t encoded_size(const Value &value);
+    static void encode(const Value &value, char *dest, size_t size);
+    static Value decode(const char *src);
+    // appends the element at src to out as a string
+    static void append_string(const char *src, std::string &out);
+
+    // size of the element starting at src, or ending right before end
+    static size_t size_at(const char *src);
+    static size_t size_before(const char *end) { return static_cast<uint8_t>(end[-1]); }
+
+    // frees an element's heap buffer, if it has one
+    void free_element(const char *src);
+
+    Chunk *new_chunk(Chunk *prev, Chunk *next);
+    void delete_chunk(Chunk *chunk);
+
+    // returns the position of element i, which must be in range
+    Cursor find(int i);
+    // removes the element at cursor, returning it
+    Value remove_at(Cursor cursor);
+
+    // turns a list value into the string of its values
+    static Value flatten(Value &&value);
+
+public:
+    QuickList() {}
+    ~QuickList() { clear(); }
+
+    QuickList(const QuickList&) = delete;
+    QuickList& operator=(const QuickList&) = delete;
+
+    int get_size() { return size; }
+    long chunk_count() { return chunks; }
+    // bytes used by the chunks and long strings
+    size_t memory_usage() { return chunks * sizeof(Chunk) + heap_bytes; }
+    void clear();
+
+    // returns a copy of element i, or a none value if i is out of range
+    Value get(int i);
+
+    // a none value is not added. returns false if nothing was added
+    bool add_end(Value &&value);
+    bool add_front(Value &&value);
+
+    // removes and returns an element, which is none if there was no element
+    Value remove_end();
+    Value remove_front();
+    Value remove(int i);
+
+    // returns elements between start and stop inclusive.
+    // if stop < 0, goes to the end of the list
+    // if reverse is true, will traverse the list in reverse
+    // if single_str is true, will return one string at index 0 representing the values
+    std::vector<std::string> values(int start = 0, int stop = -1,
+        bool reverse = false, bool single_str = false);
+
+    static SlabPool &pool() {
+        static SlabPool *lists = new SlabPool("lists", sizeof(QuickList), alignof(QuickList));
+        SlabPool *own = thread_pool();
+        return own ? *own : *lists;
+    }
+    // the calling thread's own pools, see LRUCache::use_thread_pools, or nullptr to share the global ones
+    static SlabPool *&thread_pool() {
+        thread_local SlabPool *own = nullptr;
+        return own;
+    }
+
+    static SlabPool &chunk_pool() { return Chunk::pool(); }
+    // gives the calling thread its own pools for lists and chunks
+    static void use_thread_pools();
+    static void release_thread_pools();
+
+    static void *operator new(size_t size) { return pool().allocate(); }
+    static void operator delete(void *ptr) { pool().deallocate(ptr); }
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef RESP_H
+#define RESP_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "tokens.hpp"
+#include "entries/value.hpp"
+
+// Redis serialization protocol (RESP), so keys and values are length prefixed and may hold any bytes.
+// Requests are arrays of bulk strings: "*2\r\n$3\r\nget\r\n$1\r\na\r\n". Inline requests, a line of
+// whitespace separated args, are still accepted and get the plain text replies the client prints.
+namespace resp {
+    // reply formats. the value is the byte sent in internal COMMAND messages
+    enum class Protocol : char {
+        Text = 'T',
+        RESP2 = '2',
+        RESP3 = '3'
+    };
+
+    enum class Status {
+        Complete,
+        Incomplete, // more bytes are needed
+        Error       // malformed, the connection can't be parsed further
+    };
+
+    // longest bulk string and largest array accepted from a client
+    constexpr size_t MAX_BULK = 512 * 1024 * 1024;
+    constexpr size_t MAX_ARRAY = 1024 * 1024;
+
+    // parses the request at the start of buf into args, which are views into buf.
+    // a request is a RESP array of bulk strings, or an inline request ending in \n.
+    // if Complete, consumed is set to the request's length so the next one can be parsed after it
+    Status parse_request(std::string_view buf, Tokens &args, size_t &consumed);
+
+    // parses a message holding exactly one request. inline requests need no \n.
+    // sets protocol to RESP2 for RESP requests and Text for inline ones. returns false if malformed
+    bool parse_message(std::string_view msg, Tokens &args, Protocol &protocol);
+
+    // appends args as a RESP array of bulk strings
+    void write_request(const Tokens &args, std::string &out);
+
+    // finds the end of the RESP2 or RESP3 reply at the start of buf, including every element of
+    // an aggregate, so pipelined replies can be split. if Complete, consumed is set to its length
+    Status parse_reply(std::string_view buf, size_t &consumed);
+
+    // Appends replies to out in a protocol. Text is what the client prints: values as plain strings,
+    // separated by spaces, with "(NIL)" for null, so array elements are joined into one line.
+    class Writer {
+    private:
+        std::string &out;
+        Protocol protocol;
+        bool first = true;
+
+        // starts a value, adding a space between text values
+        void separate();
+        void header(char type, int64_t num);
+
+    public:
+        Writer(std::string &out, Protocol protocol): out(out), protocol(protocol) {}
+
+        Protocol get_protocol() const { return protocol; }
+
+        void simple(std::string_view str);
+        void error(std::string_view msg);
+        void integer(int64_t num);
+        void bulk(std::string_view str);
+        void null();
+        // followed by size values
+        void array(size_t size);
+        // followed by size key value pairs. a flat array in RESP2
+        void map(size_t size);
+        // ints as integers, strings as bulk strings and lists as arrays
+        void value(const Value &value);
+    };
+
+    // Reads RESP values one at a time. Every read returns false and reads nothing
+    // if the next value is not of that type or is cut off.
+    class Reader {
+    private:
+        std::string_view buf;
+        size_t pos = 0;
+
+        // reads a type byte and a number ending in \r\n
+        bool read_header(char type, int64_t &num);
+
+    public:
+        explicit Reader(std::string_view buf): buf(buf) {}
+
+        bool done() const { return pos >= buf.size(); }
+        // type byte of the next value, or 0 if done
+        char peek() const { return done() ? 0 : buf[pos]; }
+
+        bool read_array(size_t &size);
+        bool read_integer(int64_t &num);
+        // str is a view into the buffer
+        bool read_bulk(std::string_view &str);
+        // reads what Writer::value wrote. list elements are parsed like args, see arg_to_value
+        bool read_value(Value &value);
+    };
+
+    // appends an entry to a cache dump, as a key and value array, see LRUCache::extract
+    void write_entry(std::string_view key, const Value &value, std::string &out);
+
+    // joins replies of the same command from several nodes into one array.
+    // array replies contribute their elements, and any other reply is one element
+    std::string merge_arrays(const std::vector<std::string> &replies);
+
+    // joins the RESP2 replies of a multi-key command split by node into the reply to the whole command,
+    // appended to out in protocol. keys[i] holds where the keys sent for replies[i] were in the command.
+    // integers are added, arrays are put back in key order, and an error from any node is the reply
+    void merge_keys(const std::vector<std::string> &replies, const std::vector<std::vector<size_t>> &keys,
+        size_t key_count, Protocol protocol, std::string &out);
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+#include "lru_cache.hpp"
+#include "spsc_queue.hpp"
+
+// most executor threads a node may run
+constexpr int MAX_THREADS = 64;
+// messages a shard may have queued or in progress from the dispatcher. more wait in a backlog
+constexpr size_t SHARD_QUEUE_SIZE = 4096;
+
+// A node's cache split into shards by key hash, each an LRUCache owned by one executor thread, so commands
+// on different shards run in parallel with no locking on the data path. Shards share nothing: the thread
+// that owns the Shards dispatches, and submit() sends each request to the shards it touches over lock-free
+// SPSC queues, tagged, waking them with a Doorbell. collect() passes on replies once every part of a request
+// is in. Single-key commands go to one shard, multi-key commands are split by shard and merged like the leader
+// merges nodes, and commands on the whole cache go to every shard. call() may be used from any thread, and
+// waits for its reply over separate queues.
+class Shards {
+public:
+    // called from collect() with a request's reply
+    using Done = std::function<void(std::string &&reply)>;
+    // joins the replies of a request's parts into its reply
+    using Merge = std::function<std::string(std::vector<std::string> &parts)>;
+
+private:
+    // a request waiting on shards
+    struct Gather {
+        std::vector<std::string> parts;
+        size_t waiting = 0;
+        Merge merge;
+        Done done;
+    };
+
+    struct Part {
+        std::shared_ptr<Gather> gather;
+        size_t index;
+    };
+
+    struct Message {
+        uint64_t tag;
+        std::string data;
+    };
+
+    struct Shard {
+        // from the dispatcher, and its replies back
+        SpscQueue<Message> requests { SHARD_QUEUE_SIZE };
+        SpscQueue<Message> replies { SHARD_QUEUE_SIZE };
+        // from call(), one at a time
+        SpscQueue<std::string> calls { 1 };
+        SpscQueue<std::string> call_replies { 1 };
+        // rung when the shard has messages
+        Doorbell wake;
+        std::atomic<bool> stopping { false };
+        // how the extract call() being run groups entries, set before its message is queued
+        const LRUCache::Group *group = nullptr;
+
+        // the dispatcher's requests sent and not replied to, and those waiting for room in the queue
+        size_t in_flight = 0;
+        std::deque<Message> backlog;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    // rung by shards when they reply to the dispatcher, and to call()
+    Doorbell replied;
+    Doorbell called;
+
+    std::unordered_map<uint64_t, Part> waiting;
+    uint64_t next_tag = 0;
+    std::mutex call_mutex;
+
+    // splits msg into a message for each shard it touches and how their replies are merged.
+    // a malformed message has no parts and merges to its error. returns false for other messages
+    bool plan(std::string_view msg, std::vector<std::pair<size_t, std::string>> &messages, Merge &merge) const;
+    // starts a request on the shards given their messages, one per part
+    void dispatch(std::vector<std::pair<size_t, std::string>> &messages, Merge merge, Done done);
+    // queues a message for a shard, or backlogs it if the shard's queue is full. returns true if queued
+    bool send(Shard &shard, Message &&msg);
+    // sends each shard its message and waits for their replies, which call_mutex must be held for
+    std::vector<std::string> call_parts(std::vector<std::pair<size_t, std::string>> &messages);
+
+    // runs a shard's messages on its own cache until told to stop
+    static void run(Shard &shard, Doorbell &replied, Doorbell &called, long max_size, long max_memory, std::string eviction);
+    // the shard's loop, with its cache destroyed before the thread's pools are
+    static void serve(Shard &shard, Doorbell &replied, Doorbell &called, LRUCache &&cache, const std::string &eviction);
+    // a shard's reply to one message. group is for extract messages
+    static std::string handle(std::string_view msg, LRUCache &cache, const LRUCache::Group *group = nullptr);
+
+public:
+    // starts count shards, each with a share of config's limits and the same eviction policy.
+    // with pin, shard i's thread only runs on core i, wrapping around if there are more shards than cores
+    Shards(size_t count, LRUCache &config, bool pin = false);
+    ~Shards();
+
+    Shards(const Shards&) = delete;
+    Shards& operator=(const Shards&) = delete;
+
+    size_t size() const { return shards.size(); }
+    size_t shard_of(std::string_view key) const;
+
+    // runs a COMMAND, BATCH or CACHE_UPDATE message on the shards it touches, calling done from
+    // collect() with what a single threaded node would reply. returns false for other messages
+    bool submit(std::string_view msg, Done done);
+
+    // readable when replies have arrived, for the dispatcher to poll
+    int fd() const { return replied.fd(); }
+    // reads every reply that has arrived, finishing the requests that have all their parts
+    void collect();
+
+    // runs a message like submit but waits for its reply, for threads other than the dispatcher
+    // and the dispatcher's rare commands that must reply right away. returns false for other messages
+    bool call(std::string_view msg, std::string &reply);
+
+    // takes the entries within bounds, or in each group, out of every shard, see LRUCache::extract.
+    // waits for the shards
+    std::vector<std::string> extract(const std::vector<uint64_t> &upper_bounds);
+    std::vector<std::string> extract(const LRUCache::Group &group, size_t groups);
+};
+
+#endif
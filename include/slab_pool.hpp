@@ -0,0 +1,84 @@
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+// bytes per slab. each slab is one malloc holding many objects
+constexpr size_t SLAB_SIZE = 64 * 1024;
+
+// Allocator for fixed size objects, carving them out of SLAB_SIZE slabs instead of calling malloc
+// for each one. Freed objects go on a free list and are reused before the newest slab is carved further.
+// Classes opt in by routing their operator new and delete to a pool, so new and delete work as usual.
+class SlabPool {
+private:
+    struct FreeSlot {
+        FreeSlot *next;
+    };
+
+    std::string name;
+    size_t object_size;
+
+    std::vector<char*> slabs;
+    FreeSlot *free_list = nullptr;
+    // part of the newest slab that has never been handed out
+    char *unused = nullptr;
+    char *unused_end = nullptr;
+
+    size_t in_use = 0;
+
+public:
+    SlabPool(const std::string &name, size_t object_size, size_t alignment = alignof(std::max_align_t));
+    ~SlabPool();
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    void *allocate();
+    void deallocate(void *ptr);
+
+    // frees every slab at once. objects still in use must not be touched again,
+    // so callers must have destroyed them or know they own nothing
+    void release();
+
+    // calls fn with every object in use, walking each slab in address order
+    template <typename F>
+    void for_each_in_use(F &&fn);
+
+    const std::string &get_name() const { return name; }
+    size_t get_object_size() const { return object_size; }
+    size_t get_in_use() const { return in_use; }
+    size_t get_slab_count() const { return slabs.size(); }
+    // bytes held in slabs, including free slots
+    size_t memory_usage() const { return slabs.size() * SLAB_SIZE; }
+
+    // usage formatted for the slabs command, e.g. "entries(size=112 used=10 slabs=1 bytes=65536)"
+    std::string stats() const;
+};
+
+template <typename F>
+void SlabPool::for_each_in_use(F &&fn) {
+    std::vector<char*> free_slots;
+    for (FreeSlot *slot = free_list; slot; slot = slot->next) {
+        free_slots.push_back(reinterpret_cast<char*>(slot));
+    }
+    std::sort(free_slots.begin(), free_slots.end());
+
+    for (char *slab : slabs) {
+        // only the newest slab has a part that was never handed out
+        char *end = slab == slabs.back() ? unused : slab + SLAB_SIZE / object_size * object_size;
+        auto next_free = std::lower_bound(free_slots.begin(), free_slots.end(), slab);
+
+        for (char *slot = slab; slot < end; slot += object_size) {
+            if (next_free != free_slots.end() && *next_free == slot) {
+                ++next_free;
+            } else {
+                fn(slot);
+            }
+        }
+    }
+}
+
+#endif
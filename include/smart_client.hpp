@@ -0,0 +1,82 @@
+#ifndef SMART_CLIENT_H
+#define SMART_CLIENT_H
+
+#include <zmq.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+#include "tokens.hpp"
+#include "resp.hpp"
+#include "placement.hpp"
+
+// times a request is retried after a MOVED reply before it is sent through the leader
+constexpr int SMART_MAX_REDIRECTS = 3;
+
+// Client that sends requests for a key straight to the worker owning it, instead of through the leader.
+// It keeps a copy of the ring, fetched from the leader with RING, and places keys on it with the
+// leader's placement. A worker that doesn't own the key, because the ring changed, replies MOVED and the
+// ring is fetched again. Commands on many nodes or keys, node commands, and keys the leader owns are
+// still sent to the leader, which owns its keys but serves them on its client port.
+class SmartClient {
+public:
+    // a node on the client's copy of the ring
+    struct Node {
+        uint64_t hash;
+        std::string pid;
+        std::string endpoint;
+        bool is_leader;
+        int vnodes;
+        int weight;
+    };
+
+private:
+    zmq::context_t context{1};
+    std::string leader_endpoint;
+    int timeout_ms;
+    zmq::socket_t leader;
+
+    // sorted like ConsistentHashing, by hash then pid
+    std::vector<Node> nodes;
+    // the leader's placement of nodes, or null if there are none
+    std::unique_ptr<Placement> placement;
+    // REQ sockets to workers, by endpoint
+    std::unordered_map<std::string, zmq::socket_t> workers;
+
+    uint64_t direct = 0;
+    uint64_t redirects = 0;
+
+    zmq::socket_t connect(const std::string &endpoint);
+    // sends msg on socket and waits for the reply. returns false if none came in time,
+    // and the socket is replaced since a REQ socket can't send again until it has a reply
+    bool send_recv(zmq::socket_t &socket, const std::string &endpoint, const std::string &msg, std::string &reply);
+
+public:
+    // leader_endpoint is the leader's client port, such as tcp://localhost:5555
+    explicit SmartClient(const std::string &leader_endpoint, int timeout_ms = 1000);
+
+    SmartClient(const SmartClient&) = delete;
+    SmartClient& operator=(const SmartClient&) = delete;
+
+    // fetches the ring from the leader. returns false if it didn't reply
+    bool refresh();
+    // replaces the ring with one in ConsistentHashing::to_internal_string's format
+    void set_ring(std::string_view internal);
+
+    // the node owning key, as ConsistentHashing::get finds it, or nullptr if the ring is empty
+    const Node *owner(std::string_view key) const;
+
+    // sends a request to the node that should serve it and returns the reply in protocol,
+    // Text or RESP2 as the leader's client port replies in
+    std::string request(const Tokens &args, resp::Protocol protocol);
+
+    const std::vector<Node> &ring_nodes() const { return nodes; }
+    // requests sent straight to a worker, and MOVED replies received
+    uint64_t direct_count() const { return direct; }
+    uint64_t redirect_count() const { return redirects; }
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// size of a cache line, so indexes written by different threads don't share one
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread. Slots are a
+// power of two ring, the producer only writes tail and the consumer only writes head, so neither
+// locks or waits. Each side keeps its last view of the other's index and only reloads it when
+// the ring looks full or empty, so the shared cache lines move between cores once per burst.
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0};
+    // the producer's view of head
+    size_t cached_head = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+    // the consumer's view of tail
+    size_t cached_tail = 0;
+
+    static size_t round_up(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity): slots(round_up(capacity)), mask(slots.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // producer only. returns false if the queue is full, leaving item as it was
+    bool push(T &&item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head == slots.size()) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head == slots.size()) {
+                return false;
+            }
+        }
+
+        slots[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only. returns false if the queue is empty
+    bool pop(T &item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail) {
+                return false;
+            }
+        }
+
+        item = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Wakes a thread waiting in poll or epoll on fd(), such as the consumer of an SpscQueue once
+// items are pushed. Rings before the waiter clears it are coalesced into one wake up, so a waiter
+// clears it before draining its queues and anything pushed after is rung again.
+class Doorbell {
+private:
+    int efd;
+
+public:
+    Doorbell(): efd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+    ~Doorbell() { close(efd); }
+
+    Doorbell(const Doorbell&) = delete;
+    Doorbell& operator=(const Doorbell&) = delete;
+
+    int fd() const { return efd; }
+
+    // safe from any thread
+    void ring() {
+        uint64_t one = 1;
+        ssize_t written = write(efd, &one, sizeof(one));
+        (void)written;
+    }
+
+    void clear() {
+        uint64_t count;
+        ssize_t got = read(efd, &count, sizeof(count));
+        (void)got;
+    }
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef TCP_SERVER_H
+#define TCP_SERVER_H
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+#include "tokens.hpp"
+#include "resp.hpp"
+
+// bytes read from a socket at a time
+constexpr size_t TCP_READ_SIZE = 16 * 1024;
+// longest inline request line, like Redis' limit, so a client can't send a line that never ends
+constexpr size_t TCP_MAX_INLINE = 64 * 1024;
+// a connection isn't read from while this many reply bytes are waiting, so clients that send
+// without reading replies can't make the server buffer without bound
+constexpr size_t TCP_MAX_PENDING = 16 * 1024 * 1024;
+// requests a connection may have waiting on deferred replies before it isn't read from
+constexpr size_t TCP_MAX_QUEUED = 1024;
+// events taken from epoll per poll
+constexpr int TCP_MAX_EVENTS = 256;
+
+// Non-blocking epoll reactor serving RESP clients over plain TCP, so many clients can be connected at once
+// instead of one request at a time. Each connection has its own read and write buffers: requests may arrive
+// in pieces or many per read (pipelined), and replies are queued until the socket takes them.
+// Connections start in RESP2 and can switch to RESP3 with HELLO. Inline requests are accepted for tools
+// like telnet, but get RESP replies as in Redis.
+// A handler may reply later, such as once a worker answers, with complete(). Replies are still sent
+// in the order of the connection's requests, with later ones held until the earlier ones complete.
+// Everything runs on the thread calling poll(), so handlers need no locking. Other fds, such as
+// a ZMQ socket's, can be watched by the same loop.
+class TcpServer {
+public:
+    // identifies a request whose reply was deferred
+    struct Ticket {
+        int fd;
+        uint64_t connection;
+        uint64_t seq;
+    };
+
+    // serves one request. returns true after appending its reply to out, or false to reply later by
+    // passing ticket to complete(). protocol is the connection's, and may be changed by the request
+    using Handler = std::function<bool(const Tokens &args, resp::Protocol &protocol,
+        std::string &out, const Ticket &ticket)>;
+
+private:
+    struct Reply {
+        bool ready = false;
+        std::string data;
+    };
+
+    struct Connection {
+        // fds are reused, so tickets are matched to connections by id
+        uint64_t id;
+        std::string in;
+        std::string out;
+        // bytes of out already sent
+        size_t sent = 0;
+        // replies after the oldest deferred one, which can't be sent yet
+        std::deque<Reply> queued;
+        // seq of the next request
+        uint64_t next_seq = 0;
+        resp::Protocol protocol = resp::Protocol::RESP2;
+        // events registered with epoll
+        uint32_t events = 0;
+        // the client closed its end, so the connection closes once every reply is sent
+        bool eof = false;
+        // serving stopped at a limit with requests left in
+        bool blocked = false;
+    };
+
+    Handler handler;
+    int epoll_fd = -1;
+    int listen_fd = -1;
+    int port = -1;
+    uint64_t next_connection_id = 0;
+
+    std::unordered_map<int, Connection> connections;
+    std::unordered_map<int, std::function<void()>> watched;
+
+    void accept_all();
+    // reads everything available. returns false if the connection was closed
+    bool read_all(int fd, Connection &conn);
+    // serves the complete requests in conn.in, appending their replies to conn.out or conn.queued.
+    // returns false if a request was malformed and the connection must be closed after its error is sent
+    bool serve(int fd, Connection &conn);
+    // writes as much of conn.out as the socket takes. returns false on error
+    bool flush(int fd, Connection &conn);
+    // closes conn if ok is false or it has nothing left to do, otherwise registers the events it waits for
+    void finish(int fd, Connection &conn, bool ok);
+    void update_events(int fd, Connection &conn);
+    void close_connection(int fd);
+
+public:
+    explicit TcpServer(Handler handler);
+    ~TcpServer();
+
+    TcpServer(const TcpServer&) = delete;
+    TcpServer& operator=(const TcpServer&) = delete;
+
+    // listens on port, or any free port if 0. returns false if the port can't be used
+    bool listen(int port);
+    // the port listened on, or -1 if not listening
+    int get_port() const { return port; }
+
+    // calls on_ready from poll() whenever fd is readable
+    void watch(int fd, std::function<void()> on_ready);
+
+    // sends the deferred reply for ticket, once the replies before it are sent.
+    // does nothing if the connection has closed
+    void complete(const Ticket &ticket, std::string_view reply);
+
+    // waits up to timeout_ms for events, or forever if negative, and handles them.
+    // returns the number of events handled
+    int poll(int timeout_ms);
+
+    size_t connection_count() const { return connections.size(); }
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include "entries/cache_entry.hpp"
+#include "unix_times.hpp"
+
+constexpr int WHEEL_LEVELS = 4;
+constexpr int WHEEL_BITS = 6;
+constexpr int WHEEL_SLOTS = 1 << WHEEL_BITS; // slots per level
+
+// Hierarchical timing wheel of CacheEntry indexed by expiration (unix seconds).
+// Level 0 has one slot per second, and each level above covers 64x the time of the one below,
+// so 4 levels span 64^4 seconds (~194 days). Entries further out sit in the last level and are
+// rescheduled when it cascades. Entries are linked intrusively, so scheduling never allocates.
+class TimingWheel {
+private:
+    // circular lists of entries. a slot is identified by level * WHEEL_SLOTS + index
+    CacheEntry *slots[WHEEL_LEVELS * WHEEL_SLOTS] = {};
+    long count = 0;
+
+    // next second to be processed
+    seconds::rep current;
+    // whether the higher levels have already been cascaded for current
+    bool cascaded = false;
+
+    void link(CacheEntry *entry, int slot);
+    void unlink(CacheEntry *entry);
+
+    // picks the slot for an expiration relative to current
+    int slot_for(seconds::rep expiration);
+    // reschedules every entry in the current slot of a level, moving them to lower levels.
+    // returns the number of entries moved
+    long cascade(int level);
+
+public:
+    TimingWheel(seconds::rep now = time_secs()): current(now) {}
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+    TimingWheel(TimingWheel &&other);
+    TimingWheel& operator=(TimingWheel &&other);
+
+    long size() { return count; }
+
+    // schedules an entry with expiration > 0. reschedules it if already scheduled
+    void add(CacheEntry *entry);
+    // unschedules an entry. does nothing if it is not scheduled
+    void remove(CacheEntry *entry);
+
+    // unlinks and returns one entry with expiration <= now, or nullptr if none are due.
+    // work is incremented by the seconds and entries processed, including cascades.
+    // returns nullptr early once work reaches max_work, so a call can resume where the last one stopped
+    CacheEntry *pop_expired(seconds::rep now, long &work, long max_work);
+
+    // forgets every entry without freeing them
+    void clear(seconds::rep now = time_secs());
+};
+
+#endif
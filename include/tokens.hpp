@@ -0,0 +1,44 @@
+#ifndef TOKENS_H
+#define TOKENS_H
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// args kept inline before spilling to the heap. covers every command but long multi key ones
+constexpr size_t TOKENS_INLINE = 16;
+
+// A request split on whitespace in a single pass, or built from a RESP request with push(). Tokens are views into the request,
+// which must outlive them, and the first TOKENS_INLINE are stored inline so most
+// requests are tokenized without allocating.
+class Tokens {
+private:
+    std::string_view inline_tokens[TOKENS_INLINE];
+    std::vector<std::string_view> more;
+    size_t count = 0;
+
+public:
+    Tokens() {}
+    explicit Tokens(std::string_view str);
+
+    // adds a token, which must outlive these Tokens
+    void push(std::string_view token);
+    void clear() { count = 0; more.clear(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    std::string_view operator[](size_t i) const {
+        return i < TOKENS_INLINE ? inline_tokens[i] : more[i - TOKENS_INLINE];
+    }
+
+    // the command name, or an empty view if there are no tokens
+    std::string_view name() const { return count > 0 ? inline_tokens[0] : std::string_view(); }
+    // the key the command acts on, or an empty view if there is none.
+    // commands with a subcommand, such as "memory usage key", have the key one token later
+    std::string_view key() const;
+};
+
+// compares ascii strings ignoring case
+bool equals_ignore_case(std::string_view a, std::string_view b);
+
+#endif
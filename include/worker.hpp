@@ -3,7 +3,9 @@
 
 #include <zmq.hpp>
 #include "consistent-hashing.hpp"
+#include "lru_cache.hpp"
 #include <mutex>
+#include <string_view>
 
 extern std::string endpoint;
 extern std::mutex endpoint_mutex;
@@ -15,11 +17,21 @@ void handle_pings();
 
 void leader_election();
 
+// runs a COMMAND, DIRECT_COMMAND or BATCH message's requests on cache, returning their replies back to back
+std::string serve_commands(std::string_view msg, LRUCache &cache);
+
+// followed by the reply's resp::Protocol byte and the request as a RESP array
 constexpr char COMMAND = '0';
 constexpr char NODE_COMMAND = '1';
 constexpr char RING_UPDATE= '2';
 constexpr char CACHE_UPDATE = '3';
 constexpr char ELECTION_MSG = '4';
 constexpr char ELECTION_VICTORY = '5';
+// followed by the replies' resp::Protocol byte and RESP requests back to back, replied to with their replies back to back
+constexpr char BATCH = '6';
+// a COMMAND sent straight to a worker by a SmartClient, replied to with COMMAND and the reply. a request
+// for a key the worker doesn't own is replied to with MOVED, the owner's hash, a space and its endpoint
+constexpr char DIRECT_COMMAND = '7';
+constexpr char MOVED = '8';
 
 #endif
\ No newline at end of file
@@ -5,8 +5,17 @@
 #include <zmq.hpp>
 #include <getopt.h>
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <random>
+#include <algorithm>
+
+#include "tokens.hpp"
+#include "resp.hpp"
+#include "smart_client.hpp"
+
+// requests sent per message when filling or loading
+constexpr int BATCH_SIZE = 1000;
 
 std::string randomStr() {
     int minLength = 2;
@@ -28,9 +37,70 @@ std::string randomStr() {
     return result;
 }
 
+// sends count RESP requests in one message and waits for their replies, adding how many were errors to errors
+void send_batch(zmq::socket_t &socket, std::string &batch, int count, long &errors) {
+    if (count == 0) {
+        return;
+    }
+
+    socket.send(zmq::buffer(batch), zmq::send_flags::none);
+    batch.clear();
+
+    while (true) {
+        zmq::message_t reply;
+        zmq::recv_result_t res = socket.recv(reply, zmq::recv_flags::none);
+        if (!res.has_value()) {
+            std::cout << "Error communicating with server: " << std::strerror(errno) << std::endl;
+            continue;
+        }
+
+        std::string_view replies = reply.to_string_view();
+        for (int i = 0; i < count; i++) {
+            size_t consumed;
+            if (resp::parse_reply(replies, consumed) != resp::Status::Complete) {
+                errors += count - i;
+                break;
+            }
+
+            if (replies[0] == '-') {
+                errors++;
+            }
+            replies.remove_prefix(consumed);
+        }
+        return;
+    }
+}
+
+// sends every command in input, one per line, in batches. returns the number of errors
+long load(zmq::socket_t &socket, std::istream &input, long &loaded) {
+    std::string batch;
+    int count = 0;
+    long errors = 0;
+
+    std::string line;
+    while (std::getline(input, line)) {
+        Tokens args { line };
+        if (args.empty()) {
+            continue;
+        }
+
+        resp::write_request(args, batch);
+        loaded++;
+        if (++count == BATCH_SIZE) {
+            send_batch(socket, batch, count, errors);
+            count = 0;
+        }
+    }
+
+    send_batch(socket, batch, count, errors);
+    return errors;
+}
+
 int main(int argc, char *argv[]) {
     int server_port = 5555;
     int fill = 0;
+    std::string load_file;
+    bool smart = false;
 
     while (true) {
         int option_index = 0;
@@ -38,9 +108,11 @@ int main(int argc, char *argv[]) {
             {"help", no_argument, 0, 'h'},
             {"port", required_argument, 0, 'p'},
             {"fill", required_argument, 0, 'f'},
+            {"load", required_argument, 0, 'l'},
+            {"smart", no_argument, 0, 's'},
             {0, 0, 0, 0}
         };
-        int c = getopt_long(argc, argv, "-hp:f:", long_options, &option_index);
+        int c = getopt_long(argc, argv, "-hp:f:l:s", long_options, &option_index);
         if (c == -1) {
             break;
         }
@@ -55,7 +127,9 @@ int main(int argc, char *argv[]) {
                     << "\n"
                     << "-h, --help: displays this menu!\n"
                     << "-p, --port: port used by server for client connections. Default is 5555\n"
-                    << "-f, --fill: prefill the cache with random keys and values. Default is 0"
+                    << "-f, --fill: prefill the cache with random keys and values, sent in batches. Default is 0\n"
+                    << "-l, --load: sends the commands in a file, one per line, in batches then exits. - reads stdin\n"
+                    << "-s, --smart: sends requests for a key straight to the worker that owns it, using the leader's ring"
                     << std::endl;
 
                 return EXIT_SUCCESS;
@@ -81,6 +155,16 @@ int main(int argc, char *argv[]) {
                     return EXIT_FAILURE;
                 }
                 break;   
+            case 'l':
+                if (!optarg) {
+                    std::cout << "Must enter a file!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                load_file = optarg;
+                break;
+            case 's':
+                smart = true;
+                break;
             default:
                 return EXIT_FAILURE;
         }
@@ -90,8 +174,55 @@ int main(int argc, char *argv[]) {
     zmq::socket_t socket{context, zmq::socket_type::req};
     socket.connect("tcp://localhost:" + std::to_string(server_port));
     socket.set(zmq::sockopt::rcvtimeo, 1000);
+
+    if (!load_file.empty()) {
+        std::ifstream file;
+        if (load_file != "-") {
+            file.open(load_file);
+            if (!file) {
+                std::cout << "Could not open " << load_file << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        long loaded = 0;
+        long errors = load(socket, load_file == "-" ? std::cin : file, loaded);
+        std::cout << "Loaded " << loaded << " commands, " << errors << " errors" << std::endl;
+        return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     std::cout << "Client started!" << std::endl;
 
+    if (fill > 0) {
+        std::string batch;
+        long errors = 0;
+        for (int i = 0; i < fill; i += BATCH_SIZE) {
+            int count = std::min(BATCH_SIZE, fill - i);
+            for (int j = 0; j < count; j++) {
+                std::string set = "set " + randomStr() + " " + randomStr();
+                resp::write_request(Tokens { set }, batch);
+            }
+            send_batch(socket, batch, count, errors);
+        }
+
+        std::cout << "Filled " << fill << " keys, " << errors << " errors" << std::endl;
+    }
+
+    if (smart) {
+        SmartClient client { "tcp://localhost:" + std::to_string(server_port) };
+        if (!client.refresh()) {
+            std::cout << "Could not get the ring from the leader" << std::endl;
+        }
+
+        std::string input;
+        while (std::cout << "> " << std::flush && std::getline(std::cin, input)) {
+            Tokens args { input };
+            std::cout << client.request(args, resp::Protocol::Text) << std::endl;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
     while (true) {
         bool got_reply = false;
 
@@ -99,13 +230,7 @@ int main(int argc, char *argv[]) {
         std::flush(std::cout);
 
         std::string input;
-
-        if (fill > 0) {
-            input = "set " + randomStr() + " " + randomStr() + "\n";
-            fill--;
-        } else {
-            std::getline(std::cin, input);
-        }
+        std::getline(std::cin, input);
     
         socket.send(zmq::buffer(input), zmq::send_flags::none);
         
@@ -1,18 +1,38 @@
 #include <getopt.h>
+#include <algorithm>
+#include <thread>
 
 #include "leader.hpp"
 #include "worker.hpp"
 #include "globals.hpp"
 #include "consistent-hashing.hpp"
+#include "shards.hpp"
 
-bool monitoring = false;
-bool stop = false;
-LRUCache cache {};
-int secs_offset = 0;
-int ms_offset = 0;
-int client_port = 5555;
-int internal_port = -1;
-ConsistentHashing ring;
+// parses a byte count with an optional k/kb, m/mb or g/gb suffix. returns -1 if invalid
+long parse_bytes(const std::string &str) {
+    size_t end = 0;
+    long num;
+    try {
+        num = std::stol(str, &end);
+    } catch (...) {
+        return -1;
+    }
+
+    std::string unit = str.substr(end);
+    std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+
+    if (unit == "" || unit == "b") {
+        return num;
+    } else if (unit == "k" || unit == "kb") {
+        return num * 1024;
+    } else if (unit == "m" || unit == "mb") {
+        return num * 1024 * 1024;
+    } else if (unit == "g" || unit == "gb") {
+        return num * 1024 * 1024 * 1024;
+    }
+
+    return -1;
+}
 
 int main(int argc, char *argv[]) {
     bool leader = false;
@@ -24,11 +44,19 @@ int main(int argc, char *argv[]) {
             {"help", no_argument, 0, 'h'},
             {"client-port", required_argument, 0, 'c'},
             {"internal-port", required_argument, 0, 'i'},
+            {"tcp-port", required_argument, 0, 't'},
             {"worker", no_argument, 0, 'w'},
             {"leader", no_argument, 0, 'l'},
+            {"maxmemory", required_argument, 0, 'm'},
+            {"eviction", required_argument, 0, 'e'},
+            {"threads", required_argument, 0, 'n'},
+            {"pin", no_argument, 0, 'p'},
+            {"vnodes", required_argument, 0, 'v'},
+            {"placement", required_argument, 0, 'P'},
+            {"weight", required_argument, 0, 'W'},
             {0, 0, 0, 0}
         };
-        int c = getopt_long(argc, argv, "-hc:i:wl", long_options, &option_index);
+        int c = getopt_long(argc, argv, "-hc:i:t:wlm:e:n:pv:P:W:", long_options, &option_index);
         if (c == -1) {
             break;
         }
@@ -46,7 +74,15 @@ int main(int argc, char *argv[]) {
                     << "-w, --worker: flag to specify a node is a worker node.\n"
                     << "-l, --leader: flag to specify a node is a leader node.\n"
                     << "-c, --client-port: port used for client connections. Default is 5555\n"
-                    << "-i, --internal-port: port used by nodes for internal communication. Default is the client port + 10000"
+                    << "-i, --internal-port: port used by nodes for internal communication. Default is the client port + 10000\n"
+                    << "-t, --tcp-port: port for RESP clients over plain TCP, such as redis-cli or redis-benchmark, served alongside the client port. 0 picks any free port. Default is not to listen\n"
+                    << "-m, --maxmemory: max bytes used by this node's cache before evicting, e.g. 100mb. Default is 0 (no limit)\n"
+                    << "-e, --eviction: eviction policy used when the cache is full. lru (exact), sampled (approximate LRU), clock, or tinylfu (scan resistant W-TinyLFU). Default is lru\n"
+                    << "-n, --threads: threads a node runs commands on, each owning a shard of its cache split by key hash, or cores for one per core. Workers created by the leader use the same number. Default is 1\n"
+                    << "-p, --pin: pins each of the node's threads to its own core. A leader with --threads cores --pin serves the whole keyspace from one process\n"
+                    << "-v, --vnodes: points the leader gives each node on the hash ring. More points spread keys more evenly and move keys from every node when one joins. Workers created by the leader use the same number. Default is " << DEFAULT_VNODES << "\n"
+                    << "-P, --placement: how the leader places keys on nodes. ring (consistent hashing with --vnodes points per node), jump (jump consistent hash, even and fast but a node leaving moves many keys), rendezvous (highest random weight, even without points but lookups scan every node), or bounded (the ring with each node capped near the average share). Workers get it from the leader. Default is ring\n"
+                    << "-W, --weight: this node's capacity relative to other nodes, such as its RAM or cores. The node owns a share of keys in proportion to it, under every placement. Workers created by the leader have weight 1. Between 1 and " << MAX_WEIGHT << ", default is 1"
                     << std::endl;
 
                 return EXIT_SUCCESS;
@@ -72,6 +108,17 @@ int main(int argc, char *argv[]) {
                     return EXIT_FAILURE;
                 }
                 break;
+            case 't':
+                if (!optarg) {
+                    std::cout << "Must enter a value" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                tcp_port = atoi(optarg);
+                if (tcp_port < 0) {
+                    std::cout << "TCP port must not be negative!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
             case 'w':
                 if (leader) {
                     std::cout << "Can not be both a leader and worker!" << std::endl;
@@ -88,6 +135,79 @@ int main(int argc, char *argv[]) {
 
                 leader = true;
                 break;
+            case 'm':
+                if (!optarg) {
+                    std::cout << "Must enter a value" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                cache.max_memory = parse_bytes(optarg);
+                if (cache.max_memory < 0) {
+                    std::cout << "Max memory must be a non negative number of bytes, optionally ending in kb, mb, or gb!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'e': {
+                if (!optarg) {
+                    std::cout << "Must enter a value" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                std::unique_ptr<EvictionPolicy> policy = make_eviction_policy(optarg);
+                if (!policy) {
+                    std::cout << "Eviction policy must be lru, sampled, clock, or tinylfu!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                cache.set_eviction(std::move(policy));
+                break;
+            }
+            case 'n':
+                if (!optarg) {
+                    std::cout << "Must enter a value" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                worker_threads = std::string(optarg) == "cores" ? std::thread::hardware_concurrency() : atoi(optarg);
+                if (worker_threads < 1 || worker_threads > MAX_THREADS) {
+                    std::cout << "Threads must be between 1 and " << MAX_THREADS << "!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                pin_threads = true;
+                break;
+            case 'v':
+                if (!optarg) {
+                    std::cout << "Must enter a value" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                virtual_nodes = atoi(optarg);
+                if (virtual_nodes < 1 || virtual_nodes > MAX_VNODES) {
+                    std::cout << "Virtual nodes must be between 1 and " << MAX_VNODES << "!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'W':
+                if (!optarg) {
+                    std::cout << "Must enter a value" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                node_weight = atoi(optarg);
+                if (node_weight < 1 || node_weight > MAX_WEIGHT) {
+                    std::cout << "Weight must be between 1 and " << MAX_WEIGHT << "!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'P': {
+                if (!optarg) {
+                    std::cout << "Must enter a value" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                PlacementType type;
+                if (!parse_placement(optarg, type)) {
+                    std::cout << "Placement must be ring, jump, rendezvous, or bounded!" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                ring.set_placement(type);
+                break;
+            }
             default:
                 return EXIT_FAILURE;
         }
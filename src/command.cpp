@@ -1,104 +1,146 @@
-#include <iterator>
 #include <sstream>
-#include <unordered_set>
-#include <unordered_map>
-
-#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <iomanip>
 
 #include "command.hpp"
 #include "lru_cache.hpp"
 #include "globals.hpp"
 #include "unix_times.hpp"
-#include "entries/base_entry.hpp"
-#include "entries/list_entry.hpp"
+#include "entries/value.hpp"
+#include "quick_list.hpp"
 #include "consistent-hashing.hpp"
+#include "resp.hpp"
 
 namespace cmd {
-    std::string extract_name(const std::string& str) {
-        std::istringstream iss(str);
-        std::istream_iterator<std::string> it(iss);
-        if (it != std::istream_iterator<std::string>() && !(*it).empty()) {
-            return *it;
+    std::string extract_name(std::string_view str) {
+        return std::string(Tokens(str).name());
+    }
+
+    std::string extract_key(std::string_view str) {
+        return std::string(Tokens(str).key());
+    }
+
+    const Spec *lookup(std::string_view name) {
+        // sorted by name for binary search
+        static constexpr Spec table[] = {
+            {"benchmark", &Command::benchmark, 2, "FAILURE", Routing::Local, WRITE},
+            {"create", nullptr, 1, nullptr, Routing::Node, ADMIN},
+            {"dbsize", &Command::dbsize, 1, nullptr, Routing::Sum, READ},
+            {"decr", &Command::incrementer, 2, "FAILURE", Routing::Key, WRITE},
+            {"decrby", &Command::incrementer, 3, "FAILURE", Routing::Key, WRITE},
+            {"del", &Command::del, 1, nullptr, Routing::Keys, WRITE},
+            {"dist", &Command::dist, 1, nullptr, Routing::Concat, READ},
+            {"echo", &Command::echo, 1, nullptr, Routing::Local, 0},
+            {"exists", &Command::exists, 1, nullptr, Routing::Keys, READ},
+            {"expire", &Command::expire, 3, "FAILURE", Routing::Key, WRITE},
+            {"expireat", &Command::expireat, 3, "FAILURE", Routing::Key, WRITE},
+            {"flushall", &Command::flushall, 1, nullptr, Routing::Broadcast, WRITE},
+            {"get", &Command::get, 2, nullptr, Routing::Key, READ},
+            {"hash", &Command::hash, 2, "FAILURE", Routing::Local, 0},
+            {"hello", &Command::hello, 1, nullptr, Routing::Local, 0},
+            {"incr", &Command::incrementer, 2, "FAILURE", Routing::Key, WRITE},
+            {"incrby", &Command::incrementer, 3, "FAILURE", Routing::Key, WRITE},
+            {"info", &Command::info, 1, nullptr, Routing::Concat, READ},
+            {"keys", &Command::keys, 1, nullptr, Routing::Concat, READ},
+            {"kill", nullptr, 2, nullptr, Routing::Node, ADMIN},
+            {"llen", &Command::llen, 2, "FAILURE", Routing::Key, READ},
+            {"lpop", &Command::list_pop, 2, "FAILURE", Routing::Key, WRITE},
+            {"lpush", &Command::list_push, 3, "FAILURE", Routing::Key, WRITE},
+            {"lrange", &Command::lrange, 2, "FAILURE", Routing::Key, READ},
+            {"memory", &Command::memory, 3, "FAILURE", Routing::Key, READ},
+            {"mget", &Command::mget, 2, "FAILURE", Routing::Keys, READ},
+            {"monitor", &Command::monitor, 1, nullptr, Routing::Local, ADMIN},
+            {"mset", &Command::mset, 3, "FAILURE", Routing::Pairs, WRITE},
+            {"nodes", nullptr, 1, nullptr, Routing::Node, ADMIN},
+            {"persist", &Command::persist, 2, "FAILURE", Routing::Key, WRITE},
+            {"ping", &Command::ping, 1, nullptr, Routing::Local, 0},
+            {"rename", &Command::rename, 3, "FAILURE", Routing::Key, WRITE},
+            {"ring", nullptr, 1, nullptr, Routing::Node, ADMIN},
+            {"rpop", &Command::list_pop, 2, "FAILURE", Routing::Key, WRITE},
+            {"rpush", &Command::list_push, 3, "FAILURE", Routing::Key, WRITE},
+            {"set", &Command::set, 3, "FAILURE", Routing::Key, WRITE},
+            {"shutdown", &Command::shutdown, 1, nullptr, Routing::Broadcast, ADMIN},
+            {"skew", nullptr, 1, nullptr, Routing::Node, ADMIN},
+            {"slabs", &Command::slabs, 1, nullptr, Routing::Concat, READ},
+            {"type", &Command::type, 2, "FAILURE", Routing::Key, READ},
+        };
+
+        static_assert(std::is_sorted(std::begin(table), std::end(table),
+            [](const Spec &a, const Spec &b) { return a.name < b.name; }));
+
+        // names are lowercased into a buffer, so anything longer can't be a command
+        constexpr size_t max_name = 16;
+        if (name.size() > max_name) {
+            return nullptr;
         }
 
-        return "";
-    }
-    std::string extract_key(const std::string& str) {
-        std::istringstream iss(str);
-        std::istream_iterator<std::string> it(iss);
-        
-        ++it;
+        char lower[max_name];
+        for (size_t i = 0; i < name.size(); i++) {
+            char ch = name[i];
+            lower[i] = ch >= 'A' && ch <= 'Z' ? ch + 32 : ch;
+        }
+        std::string_view key { lower, name.size() };
 
-        std::string key = "";
+        const Spec *it = std::lower_bound(std::begin(table), std::end(table), key,
+            [](const Spec &spec, std::string_view key) { return spec.name < key; });
 
-        if (it != std::istream_iterator<std::string>() && !(*it).empty()) {
-            key = *it;
+        if (it == std::end(table) || it->name != key) {
+            return nullptr;
         }
 
-        return key;
-    }
-    bool addAll(const std::string& str) {
-        std::unordered_set<std::string> cmds = {
-            "dbsize",
-            "exists"
-        };
-        return cmds.find(str) != cmds.end();
+        return it;
     }
 
-    bool concatAll(const std::string& str) {
-         std::unordered_set<std::string> cmds = {
-            "keys",
-            "dist"
-        };
-        return cmds.find(str) != cmds.end();
+    static bool routed(std::string_view name, Routing routing) {
+        const Spec *spec = lookup(name);
+        return spec && spec->routing == routing;
     }
 
-    bool askAll(const std::string& str) {
-        std::unordered_set<std::string> cmds = {
-            "flushall",
-            "shutdown"
-        };
-        return cmds.find(str) != cmds.end();
+    bool addAll(std::string_view name) {
+        return routed(name, Routing::Sum);
     }
 
-    
+    bool concatAll(std::string_view name) {
+        return routed(name, Routing::Concat);
+    }
 
-    NodeCMDType nodeCmds(const std::string& str) {
-         std::unordered_map<std::string, NodeCMDType> cmds = {
-            {"nodes", NodeCMDType::Nodes},
-            {"create", NodeCMDType::Create},
-            {"kill", NodeCMDType::Kill}
-        };
+    bool askAll(std::string_view name) {
+        return routed(name, Routing::Broadcast);
+    }
 
-        auto it = cmds.find(str);
-        if (it == cmds.end()) {
-            return NodeCMDType::Not;
+    NodeCMDType nodeCmds(std::string_view name) {
+        if (equals_ignore_case(name, "nodes")) {
+            return NodeCMDType::Nodes;
+        } else if (equals_ignore_case(name, "create")) {
+            return NodeCMDType::Create;
+        } else if (equals_ignore_case(name, "kill")) {
+            return NodeCMDType::Kill;
+        } else if (equals_ignore_case(name, "ring")) {
+            return NodeCMDType::Ring;
+        } else if (equals_ignore_case(name, "skew")) {
+            return NodeCMDType::Skew;
         }
 
-        return it->second;
+        return NodeCMDType::Not;
     }
 }
 
-Command::Command(const std::string& str) {
-    std::stringstream ss (str);
-    std::istream_iterator<std::string> begin (ss), end;
-    args = std::vector<std::string> (begin, end);
-};
-
 std::string Command::parse_cmd() {
     if (args.size() == 0) {
-        return "No Command Entered";
+        return error("No Command Entered");
     }
 
-    std::string cmd = args[0];
-    std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
+    const cmd::Spec *spec = cmd::lookup(args[0]);
+    if (!spec || !spec->handler) {
+        return error("Invalid Command");
+    }
 
-    auto it = cmdMap.find(cmd);
-    if (it != cmdMap.end()) {
-        return it->second();
-    } else {
-        return "Invalid Command";
+    if (args.size() < spec->arity) {
+        return spec->too_few ? error(spec->too_few) : nil();
     }
+
+    return (this->*spec->handler)();
 }
 
 
@@ -113,39 +155,34 @@ std::string Command::echo() {
         ss << args[i];
     }
 
-    return ss.str();
+    return bulk(ss.str());
 }
 
 std::string Command::ping() {
-    return "PONG";
+    return status("PONG");
 }
 
 std::string Command::monitor() {
     monitoring = !monitoring;
-    return monitoring ? "ACTIVE" : "INACTIVE";
+    return status(monitoring ? "ACTIVE" : "INACTIVE");
 }
 
 std::string Command::shutdown() {
     stop = true;
-    return "Stopping server...";
+    return status("Stopping server...");
 }
 
 
 std::string Command::keys() {
-    std::vector<std::string> keys = cache.key_set(true);
-    return keys[0];
+    return array(cache.key_set());
 }
 
 std::string Command::benchmark() {
     long num = 0;
     try {
-        if (args.size() < 2) {
-            throw "No num provided";
-        }
-
-        num = stol(args[1]);
+        num = stol(std::string(args[1]));
     } catch(...) {
-        return "FAILURE";
+        return error("FAILURE");
     }
     
     std::srand(std::time(nullptr));
@@ -155,72 +192,90 @@ std::string Command::benchmark() {
     const int key_limit = 1000;
     for (long i = 0; i < num; i++) {
         if(i % 2) {
-            Command set { "set " + std::to_string(std::rand() % key_limit) + " " + std::to_string(std::rand()) };
+            std::string request = "set " + std::to_string(std::rand() % key_limit) + " " + std::to_string(std::rand());
+            Command set { Tokens { request }, resp::Protocol::Text, cache };
             set.parse_cmd();
         } else {
-            Command get { "get " + std::to_string(std::rand() % key_limit)};
+            std::string request = "get " + std::to_string(std::rand() % key_limit);
+            Command get { Tokens { request }, resp::Protocol::Text, cache };
             get.parse_cmd();
         }
     }
     milliseconds::rep time_taken = time_ms() - start;
-    return std::to_string(time_taken) + " ms";
+    return status(std::to_string(time_taken) + " ms");
 }
 
 
 std::string Command::flushall() {
     cache.clear();
-    return "Cache cleared";
+    return status("Cache cleared");
 }
 
 std::string Command::get() {
-    if (args.size() < 2) {
-        return "(NIL)";
+    Value *value = cache.get(args[1]);
+    if (!value) {
+        return nil();
     }
 
-    BaseEntry *entry = cache.get(args[1]);
-    if (!entry) {
-        return "(NIL)";
-    }
-
-    return entry->to_string();
+    return bulk(value->to_string());
 }
 
 std::string Command::set() {
-    if (args.size() < 3) {
-        return "FAILURE";
-    }
+    cache.add(args[1], arg_to_value(args[2]));
 
-    cache.add(args[1], str_to_base_entry(args[2]));
+    return ok();
+}
+
+
+std::string Command::mget() {
+    std::string out;
+    resp::Writer writer { out, protocol };
+    writer.array(args.size() - 1);
+
+    for (size_t i = 1; i < args.size(); i++) {
+        Value *value = cache.get(args[i]);
+        if (value) {
+            writer.bulk(value->to_string());
+        } else {
+            writer.null();
+        }
+    }
 
-    return "SUCCESS";
+    return out;
 }
 
+std::string Command::mset() {
+    // a key without a value
+    if (args.size() % 2 == 0) {
+        return error("FAILURE");
+    }
 
-std::string Command::rename() {
-    if (args.size() < 3) {
-        return "FAILURE";
+    for (size_t i = 1; i < args.size(); i += 2) {
+        cache.add(args[i], arg_to_value(args[i + 1]));
     }
 
-    BaseEntry *entry = cache.remove(args[1]);
-    if (!entry) {
-        return "FAILURE";
+    return ok();
+}
+
+std::string Command::rename() {
+    Value value = cache.remove(args[1]);
+    if (value.is_none()) {
+        return error("FAILURE");
     }
 
-    cache.add(args[2], entry);
-    return "SUCCESS";
+    cache.add(args[2], std::move(value));
+    return ok();
 }
 
 std::string Command::del() {
     int count = 0;
     for (int i = 1; i < args.size(); i++) {
-        BaseEntry *rem = cache.remove(args[i]);
-        if (rem) {
-            delete rem;
+        if (!cache.remove(args[i]).is_none()) {
             count++;
         }
     }
 
-    return std::to_string(count);
+    return integer(count);
 }
 
 std::string Command::exists() {    
@@ -231,33 +286,54 @@ std::string Command::exists() {
         }
     }
 
-    return std::to_string(count);
+    return integer(count);
 }
 
 std::string Command::dbsize() {    
-    return std::to_string(cache.size());
+    return integer(cache.size());
 }
 
 std::string Command::dist() {
     // similar to dbsize but formatted and strs are concatenated instead of added
-    return "[node " + std::to_string(getpid()) + ": " + dbsize() + "]";
+    return bulk("[node " + std::to_string(getpid()) + ": " + std::to_string(cache.size()) + "]");
+}
+
+std::string Command::info() {
+    // per node stats, concatenated by the leader like dist
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1)
+        << "[node " << getpid() << ":"
+        << " keys=" << cache.size()
+        << " memory=" << cache.memory()
+        << " eviction=" << cache.eviction()
+        << " expires=" << cache.expires_scheduled()
+        << " expired_keys=" << cache.expired_keys()
+        << " expired_per_sec=" << cache.expired_per_sec()
+        << "]";
+
+    return bulk(ss.str());
+}
+
+std::string Command::slabs() {
+    // per node slab pool usage, concatenated by the leader like info
+    return bulk("[node " + std::to_string(getpid()) + ": "
+        + CacheEntry::pool().stats() + " "
+        + QuickList::chunk_pool().stats() + " "
+        + QuickList::pool().stats() + "]");
 }
 
 std::string Command::type() {    
-    if (args.size() < 2) {
-        return "FAILURE";
-    }
 
-    BaseEntry *entry = cache.get(args[1]);
-    if (!entry) {
-        return "(NIL)";
+    Value *value = cache.get(args[1]);
+    if (!value) {
+        return nil();
     }
 
-    switch (entry->get_type()) {
-        case EntryType::str: return "string";
-        case EntryType::integer: return "int";
-        case EntryType::list: return "list";
-        default: return "?";
+    switch (value->type()) {
+        case EntryType::str: return status("string");
+        case EntryType::integer: return status("int");
+        case EntryType::list: return status("list");
+        default: return status("?");
     }
 }
 
@@ -266,192 +342,146 @@ std::string Command::expire() {
     
     long secs = 0;
     try {
-        if (args.size() < 3) {
-            throw "No args provided";
-        }
-
-        time += std::stol(args[2]);
+        time += std::stol(std::string(args[2]));
     } catch(...) {
-        return "FAILURE";
+        return error("FAILURE");
     }
     
     bool res = cache.set_expire(args[1], time);
-    return res ? std::to_string(time) : "FAILURE";
+    return res ? integer(time) : error("FAILURE");
 }
 
 std::string Command::expireat() {
     try {
-        if (args.size() < 3) {
-            throw "No args provided";
-        }
-
-        uint64_t unix_times = std::stol(args[2]);
+        uint64_t unix_times = std::stol(std::string(args[2]));
 
         bool res = cache.set_expire(args[1], unix_times);
-        return res ? "SUCCESS" : "FAILURE";
+        return res ? ok() : error("FAILURE");
     } catch(...) {
-        return "FAILURE";
+        return error("FAILURE");
     }
 }
 
 
 std::string Command::persist() {
-    seconds::rep time = time_secs();
-    
-    if (args.size() < 2) {
-        throw "No args provided";
-    }
-
     bool res = cache.set_expire(args[1], 0);
-    return res ? "SUCCESS": "FAILURE";
+    return res ? ok() : error("FAILURE");
 }
 
 
 std::string Command::incrementer() {
-    int change = 1;
+    int64_t change = 1;
     try {
-        if (args.size() < 2) {
-            throw "No key provided";
-        }
-
-        if ((args[0] == "incrby" || args[0] == "decrby") && args.size() < 3) {
-            throw "No amount provided";
-        }
-
-        if (args[0] == "incrby" || args[0] == "decrby") {
-            change = std::stoi(args[2]);
+        if (equals_ignore_case(args[0], "incrby") || equals_ignore_case(args[0], "decrby")) {
+            change = std::stoll(std::string(args[2]));
         }
 
     } catch (...) {
-        return "FAILURE";
+        return error("FAILURE");
     }
 
-    if (args[0] == "decr" || args[0] == "decrby") {
+    if (equals_ignore_case(args[0], "decr") || equals_ignore_case(args[0], "decrby")) {
         change *= -1;
     }
 
-    BaseEntry *entry = cache.get(args[1]);
-    if (!entry) {
-        cache.add(args[1], new IntEntry(change));
-        return std::to_string(change);
+    Value *value = cache.get(args[1]);
+    if (!value) {
+        cache.add(args[1], Value(change));
+        return integer(change);
     }
 
-    if (entry->get_type() != EntryType::integer) {
-        return "NOT AN INT";
+    if (!value->is_int()) {
+        return error("NOT AN INT");
     }
 
-    IntEntry *val = dynamic_cast<IntEntry *>(entry);
-    val->value += change;
+    value->set_integer(value->integer() + change);
 
-    return std::to_string(val->value);
+    return integer(value->integer());
 }
 
 
 std::string Command::list_push() {
-    if (args.size() < 3) {
-        return "FAILURE";
+    CacheEntry *cache_entry = cache.get_cache_entry(args[1]);
+    
+    if (!cache_entry) {
+        cache_entry = cache.add(args[1], Value::new_list());
+    } else if (!cache_entry->value.is_list()) {
+        return error("NOT A LIST");
     }
 
-    BaseEntry *entry = cache.get(args[1]);
-    LinkedList *list;
-    
-    ListEntry *list_entry;
-    if (!entry) {
-        list_entry = new ListEntry();
-        cache.add(args[1], list_entry);
-    } else if (entry->get_type() != EntryType::list) {
-        return "NOT A LIST";
-    } else {
-        list_entry = dynamic_cast<ListEntry*>(entry);
-    }
-
-    list = list_entry->list;
-    bool lpush = args[0] == "lpush";
+    QuickList *list = cache_entry->value.list();
+    bool lpush = equals_ignore_case(args[0], "lpush");
     
     for (int i = 2; i < args.size(); i++) {
         if (lpush) {
-            list->add_front(str_to_base_entry(args[i]));
+            list->add_front(arg_to_value(args[i]));
         } else {
-            list->add_end(str_to_base_entry(args[i]));
+            list->add_end(arg_to_value(args[i]));
         }
     }
 
-    return std::to_string(list->get_size());
+    cache.update_memory(cache_entry);
+    return integer(list->get_size());
 }
 
 
 std::string Command::list_pop() {
-    if (args.size() < 2) {
-        return "FAILURE";
-    }
     int num = 1;
     if (args.size() > 2) {
         try {
-            num = stoi(args[2]);
+            num = stoi(std::string(args[2]));
 
             if (num == 0) {
-                return "";
+                return array({});
             } else if (num < 0) {
-                return "ERROR";
+                return error("ERROR");
             }
         } catch (...) {
             num = 1;
         }
     }
 
-    BaseEntry *entry = cache.get(args[1]);
+    CacheEntry *cache_entry = cache.get_cache_entry(args[1]);
     
-    if (!entry) {
-        return "(NIL)";
+    if (!cache_entry) {
+        return nil();
     } 
 
-    if (entry->get_type() != EntryType::list) {
-        return "NOT A LIST";
+    if (!cache_entry->value.is_list()) {
+        return error("NOT A LIST");
     }
 
-    ListEntry *list_entry = dynamic_cast<ListEntry*>(entry);
-    LinkedList *list = list_entry->list;
-    bool rpop = args[0] == "rpop";
+    QuickList *list = cache_entry->value.list();
+    bool rpop = equals_ignore_case(args[0], "rpop");
 
-    std::stringstream ss;
+    std::vector<std::string> popped;
 
     num = std::min(num, list->get_size());
-    bool first_entry = true;
     while (num > 0) {
-        if (!first_entry) {
-            ss << " ";
-        } else {
-            first_entry = false;
-        }
-        
-        BaseEntry* rem;
-        if (rpop) {
-            rem = list->remove_end();
-        } else {
-            rem = list->remove_front();
-        }
-
-        ss << rem->to_string();
+        Value rem = rpop ? list->remove_end() : list->remove_front();
+        popped.push_back(rem.to_string());
         num--;
+    }
+
+    cache.update_memory(cache_entry);
 
-        delete rem;
+    // a count replies with an array, even of one element
+    if (args.size() <= 2 && popped.size() == 1) {
+        return bulk(popped[0]);
     }
 
-    return ss.str();
+    return array(popped);
 }
 
 std::string Command::lrange() {
-    if (args.size() < 2) {
-        return "FAILURE";
-    }
     int start = 0;
     int stop = -1;
     if (args.size() > 2) {
         try {
-            start = stoi(args[2]);
+            start = stoi(std::string(args[2]));
 
             if (start < -1) {
-                return "ERROR";
+                return error("ERROR");
             }
         } catch (...) {
             start = 0;
@@ -460,34 +490,33 @@ std::string Command::lrange() {
 
     if (args.size() > 3) {
         try {
-            stop = stoi(args[3]);
+            stop = stoi(std::string(args[3]));
 
             if (stop < -1) {
-                return "ERROR";
+                return error("ERROR");
             }
         } catch (...) {
             stop = -1;
         }
     }
 
-    BaseEntry *entry = cache.get(args[1]);
+    Value *value = cache.get(args[1]);
     
-    if (!entry) {
-        return "(NIL)";
+    if (!value) {
+        return nil();
     } 
 
-    if (entry->get_type() != EntryType::list) {
-        return "NOT A LIST";
+    if (!value->is_list()) {
+        return error("NOT A LIST");
     }
 
-    ListEntry *list_entry = dynamic_cast<ListEntry*>(entry);
-    LinkedList *list = list_entry->list;
+    QuickList *list = value->list();
 
     int lim = list->get_size() - 1;
     stop = std::min(stop, lim);
 
     if (start > lim) {
-        return "";
+        return array({});
     }
 
     if (start == -1) {
@@ -497,40 +526,106 @@ std::string Command::lrange() {
         stop = lim;
     }
 
-    std::vector<std::string> str = list->values(start, stop, false, true);
+    return array(list->values(start, stop));
+}
+
+std::string Command::llen() {
+    Value *value = cache.get(args[1]);
+    
+    if (!value) {
+        return integer(0);
+    } 
 
-    if (str.size() == 0) {
-        return "ERROR";
+    if (!value->is_list()) {
+        return error("NOT A LIST");
     }
 
-    return str[0];
+    QuickList *list = value->list();
+
+    return integer(list->get_size());
 }
 
-std::string Command::llen() {
-    if (args.size() < 2) {
-        return "FAILURE";
+std::string Command::memory() {
+    std::string subcommand { args[1] };
+    std::transform(subcommand.begin(), subcommand.end(), subcommand.begin(), ::tolower);
+    if (subcommand != "usage") {
+        return error("FAILURE");
     }
 
-    BaseEntry *entry = cache.get(args[1]);
-    
-    if (!entry) {
-        return "0";
-    } 
+    long bytes = cache.memory_usage(args[2]);
+    if (bytes < 0) {
+        return nil();
+    }
+
+    return integer(bytes);
+}
 
-    if (entry->get_type() != EntryType::list) {
-        return "NOT A LIST";
+std::string Command::hash() {
+    // a bulk string, since RESP integers are signed and the hash is any 64-bit value
+    return bulk(std::to_string(hash_function(args[1])));
+}
+std::string Command::hello() {
+    if (args.size() > 1) {
+        if (args[1] == "2") {
+            protocol = resp::Protocol::RESP2;
+        } else if (args[1] == "3") {
+            protocol = resp::Protocol::RESP3;
+        } else {
+            return error("NOPROTO unsupported protocol version");
+        }
     }
 
-    ListEntry *list_entry = dynamic_cast<ListEntry*>(entry);
-    LinkedList *list = list_entry->list;
+    std::string out;
+    resp::Writer writer { out, protocol };
+    writer.map(2);
+    writer.bulk("server");
+    writer.bulk("redis-clone");
+    writer.bulk("proto");
+    writer.integer(protocol == resp::Protocol::RESP3 ? 3 : 2);
+    return out;
+}
+
+std::string Command::ok() {
+    return protocol == resp::Protocol::Text ? "SUCCESS" : "+OK\r\n";
+}
 
-    return std::to_string(list->get_size());
+std::string Command::status(std::string_view str) {
+    std::string out;
+    resp::Writer { out, protocol }.simple(str);
+    return out;
 }
 
-std::string Command::hash() {
-    if (args.size() < 2) {
-        return "FAILURE";
+std::string Command::error(std::string_view msg) {
+    std::string out;
+    resp::Writer { out, protocol }.error(msg);
+    return out;
+}
+
+std::string Command::integer(int64_t num) {
+    std::string out;
+    resp::Writer { out, protocol }.integer(num);
+    return out;
+}
+
+std::string Command::bulk(std::string_view str) {
+    std::string out;
+    resp::Writer { out, protocol }.bulk(str);
+    return out;
+}
+
+std::string Command::nil() {
+    std::string out;
+    resp::Writer { out, protocol }.null();
+    return out;
+}
+
+std::string Command::array(const std::vector<std::string> &strs) {
+    std::string out;
+    resp::Writer writer { out, protocol };
+    writer.array(strs.size());
+    for (const std::string &str : strs) {
+        writer.bulk(str);
     }
 
-    return std::to_string(hash_function(args[1]));
-}
\ No newline at end of file
+    return out;
+}
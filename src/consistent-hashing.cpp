@@ -1,25 +1,40 @@
 
 #include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <iomanip>
 
 #include "consistent-hashing.hpp"
+#include "wyhash.hpp"
 #include "globals.hpp"
 #include "worker.hpp"
 #include "unix_times.hpp"
 
-int hash_function(const std::string &str) {
-    return std::hash<std::string>()(str) % 360;
+uint64_t hash_function(std::string_view str) {
+    return wyhash::hash(str.data(), str.size());
 }
 
-ServerNode::ServerNode(std::string pid, std::string endpoint, bool is_leader) :
+uint64_t vnode_hash(const std::string &pid, const std::string &endpoint, int index) {
+    if (index == 0) {
+        return hash_function(pid + endpoint);
+    }
+    return hash_function(pid + endpoint + "#" + std::to_string(index));
+}
+
+ServerNode::ServerNode(std::string pid, std::string endpoint, bool is_leader, int vnodes, int weight) :
     last_ping(time_ms()),
     pid(pid), 
     endpoint(endpoint),
     hash(hash_function(pid + endpoint)),
-    is_leader(is_leader) {
+    is_leader(is_leader),
+    vnodes(std::max(vnodes, 1)),
+    weight(std::max(weight, 1)) {
 
     if (std::to_string(getpid()) != pid) {
         context = new zmq::context_t(1);
         socket = new zmq::socket_t(*context, zmq::socket_type::req);
+        // the last holder of a node deletes it, maybe at exit, which must not wait on a node that is gone
+        socket->set(zmq::sockopt::linger, 0);
         socket->connect(endpoint);
     } else {
         context = nullptr;
@@ -67,6 +82,7 @@ bool ServerNode::recv(zmq::message_t &request) {
 ConsistentHashing::ConsistentHashing(std::string pid) : this_pid(pid) { }
 
 ConsistentHashing::~ConsistentHashing() {
+    delete table.load();
     if (dealer_active) {
         delete dealer_socket;
         delete dealer_context;
@@ -90,9 +106,17 @@ void ConsistentHashing::set_up_dealer() {
     }
 }
 
-ServerNode *ConsistentHashing::add(std::string pid, std::string endpoint, bool is_leader) {
+ServerNode *ConsistentHashing::add(std::string pid, std::string endpoint, bool is_leader, int vnodes, int weight) {
     mutex.lock();
-    ServerNode *node = new ServerNode(pid, endpoint, is_leader); 
+    ServerNode *node = insert(pid, endpoint, is_leader, vnodes, weight);
+    publish();
+
+    mutex.unlock();
+    return node;
+}
+
+ServerNode *ConsistentHashing::insert(std::string pid, std::string endpoint, bool is_leader, int vnodes, int weight) {
+    auto node = std::make_shared<ServerNode>(pid, endpoint, is_leader, vnodes, weight);
     connected.insert(node);
 
     if (dealer_active && this_pid != pid) {
@@ -100,32 +124,77 @@ ServerNode *ConsistentHashing::add(std::string pid, std::string endpoint, bool i
         dealer_connected++;
     }
 
-    mutex.unlock();
-    return node;
+    return node.get();
 }
 
 
-ServerNode *ConsistentHashing::get(const std::string &str) {
-    if (connected.size() == 0) {
-        return nullptr;
+ConsistentHashing::Nodes::iterator ConsistentHashing::erase(Nodes::iterator it) {
+    // the tables that have the node hold it until they are freed
+    return connected.erase(it);
+}
+
+
+void ConsistentHashing::publish() {
+    Table *next = new Table();
+    std::vector<Placement::Node> nodes;
+    for (const auto &node : connected) {
+        next->nodes.push_back(node);
+        nodes.push_back({ node->pid, node->endpoint, node->vnodes, node->weight });
+    }
+    if (nodes.size() > 0) {
+        next->placement = Placement::make(placement_type, nodes);
+    }
+
+    const Table *old = table.exchange(next);
+    if (old) {
+        retired.emplace_back(old);
+    }
+
+    // a lookup that started after the exchange sees the new table, so with none running
+    // now, no lookup can still be searching a replaced one
+    if (readers.load() == 0) {
+        retired.clear();
+    }
+}
+
+std::shared_ptr<ServerNode> ConsistentHashing::get(std::string_view str) {
+    uint64_t hash = hash_function(str);
+
+    readers.fetch_add(1);
+    const Table *current = table.load();
+    // copied while the table can't be freed, so the node outlives it if need be
+    std::shared_ptr<ServerNode> node;
+    if (current && current->placement) {
+        node = current->nodes[current->placement->get(hash)];
     }
 
+    readers.fetch_sub(1);
+    return node;
+}
+
+void ConsistentHashing::set_placement(PlacementType type) {
     mutex.lock();
-    ServerNode *node = nullptr;
-    
-    auto it = connected.lower_bound(str);
-    if (it == connected.end()) {
-        node = *(--connected.end());
-    } else if ((*it)->hash == hash_function(str)) {
-        node = *it;
-    } else if (it == connected.begin()) { // is before but not equal to begin
-        node = *(--connected.end());
-    } else {
-        node = *(--it);
+    if (type != placement_type) {
+        placement_type = type;
+        publish();
+    }
+    mutex.unlock();
+}
+
+int ConsistentHashing::point_count() {
+    mutex.lock();
+    int count = 0;
+    for (const auto &node : connected) {
+        count += node->vnodes * node->weight;
     }
 
     mutex.unlock();
-    return node;
+    return count;
+}
+
+ServerNode *ConsistentHashing::find(const std::string &pid, const std::string &endpoint) {
+    ServerNode *node = get_by_pid(pid);
+    return node && node->endpoint == endpoint ? node : nullptr;
 }
 
 
@@ -135,7 +204,7 @@ ServerNode *ConsistentHashing::get_by_pid(const std::string &target) {
     }
     mutex.lock();
     for (auto it = connected.begin(); it != connected.end(); ++it) {
-        ServerNode *node = *it;
+        ServerNode *node = it->get();
         if (node->pid == target) {
             mutex.unlock();
             return node;
@@ -156,10 +225,10 @@ ServerNode *ConsistentHashing::get_next_node(ServerNode *node) {
     }
 
     if (++next_it == connected.end()) { 
-        return *connected.begin();
+        return connected.begin()->get();
     }
 
-    return  *next_it;
+    return next_it->get();
 }
 bool ConsistentHashing::dealer_send(const std::string &msg) {
     if (dealer_active && dealer_socket) {
@@ -180,10 +249,10 @@ std::string ConsistentHashing::to_user_string() {
 
     mutex.lock();
     for (auto it = connected.begin(); it != connected.end(); ++it) {
-        ServerNode *node = *it;
+        ServerNode *node = it->get();
         std::string type = node->is_leader ? "Leader" : "Worker";
 
-        ss << type << " pid: " << node->pid << ". Hash: " << node->hash << "\n";
+        ss << type << " pid: " << node->pid << ". Hash: " << node->hash << ". Virtual nodes: " << node->vnodes << ". Weight: " << node->weight << "\n";
     }
 
     mutex.unlock();
@@ -194,13 +263,15 @@ std::string ConsistentHashing::to_internal_string() {
     std::stringstream ss;
     mutex.lock();
 
+    // the placement first, for workers to place keys like the leader
+    ss << "@" << placement_name(placement_type) << " ";
     for (auto it = connected.begin(); it != connected.end(); ++it) {
-        ServerNode *node = *it;
+        ServerNode *node = it->get();
         if (node->is_leader) {
             ss << "*";
         }
 
-        ss << node->pid << "," << node->endpoint << " ";
+        ss << node->pid << "," << node->endpoint << "," << node->vnodes << "," << node->weight << " ";
     }
 
     mutex.unlock();
@@ -213,6 +284,8 @@ void ConsistentHashing::update(std::string internal_string) {
     mutex.lock();
 
     bool first_run = connected.size() == 0;
+    PlacementType old_placement = placement_type;
+    bool removed = false;
 
     std::istringstream iss(internal_string);
     std::istream_iterator<std::string> it(iss);
@@ -220,19 +293,34 @@ void ConsistentHashing::update(std::string internal_string) {
     std::unordered_set<ServerNode *> existing_nodes;
     std::unordered_set<ServerNode *> new_nodes;
 
-    // find the immediate next node, or wrap around if last one
-    ServerNode *this_node = get_by_pid(this_pid);
-    ServerNode *next_node = get_next_node(this_node);
-    bool wrap_around = is_begin(next_node);
-
-    
-    // parse internal string
+    // parse internal string, the placement then pid,endpoint,vnodes,weight for each node
     while (it != std::istream_iterator<std::string>()) {
+        PlacementType type;
+        if ((*it).at(0) == '@') {
+            if (parse_placement(std::string_view(*it).substr(1), type)) {
+                placement_type = type;
+            }
+            ++it;
+            continue;
+        }
+
         int sep = (*it).find(",");
         bool leader = false; 
         
         std::string endpoint = (*it).substr(sep + 1);
         std::string pid;
+        int vnodes = 1;
+        int weight = 1;
+
+        size_t vnodes_sep = endpoint.find(",");
+        if (vnodes_sep != std::string::npos) {
+            vnodes = atoi(endpoint.c_str() + vnodes_sep + 1);
+            size_t weight_sep = endpoint.find(",", vnodes_sep + 1);
+            if (weight_sep != std::string::npos) {
+                weight = atoi(endpoint.c_str() + weight_sep + 1);
+            }
+            endpoint.resize(vnodes_sep);
+        }
         
         if ((*it).at(0) == '*') {
             leader = true;
@@ -241,150 +329,209 @@ void ConsistentHashing::update(std::string internal_string) {
             pid = (*it).substr(0, sep);
         }
 
-        ServerNode *existing = get(pid + endpoint);
+        ServerNode *existing = find(pid, endpoint);
 
-        if (existing &&
-            existing->pid == pid &&
-            existing->endpoint == endpoint) {
+        if (existing) {
             existing_nodes.insert(existing);
         } else {
-            new_nodes.insert(add(pid, endpoint, leader));
+            new_nodes.insert(insert(pid, endpoint, leader, vnodes, weight));
         }
 
         ++it;
     }
 
     if (first_run) {
+        publish();
         mutex.unlock();
         return;
     }
 
-    // extract cache in this node's range intersecting with newly added ones
-    if (new_nodes.size() > 0 && this_node && next_node) {
-        send_extracted_cache(this_node, next_node, wrap_around);
-    }
-
     // remove nodes that were not in the latest update
     auto it2 = connected.begin();
     while (it2 != connected.end()) {
-        ServerNode *cur = *it2;
+        ServerNode *cur = it2->get();
         bool old = new_nodes.find(cur) == new_nodes.end() 
             && existing_nodes.find(cur) == existing_nodes.end();
 
         if (old) {
-            it2 = connected.erase(it2);
-            delete cur;
+            it2 = erase(it2);
+            removed = true;
         } else {
             it2++;
         }
     }
 
+    // the whole update is published as one table, so the placement is built once
+    if (new_nodes.size() > 0 || removed || placement_type != old_placement) {
+        publish();
+    }
+
+    // send other nodes the keys they now own. with ring placement, nodes leaving don't move any
+    if (new_nodes.size() > 0 || placement_type != old_placement || (removed && placement_type != PlacementType::Ring)) {
+        send_extracted_cache();
+    }
+
     mutex.unlock();
 }
 
-// extract and send cache to nodes between left and right (exclusive of bounds)
-void ConsistentHashing::send_extracted_cache(ServerNode *left, ServerNode *right, bool wrap_around) {
-    if (!left || !right || connected.size() < 2) {
+// extract the entries owned by other nodes under the current table, grouped by owner, and send them.
+// with ring placement these are only in ranges taken by added nodes, but other placements move keys
+// between nodes that stay too
+void ConsistentHashing::send_extracted_cache() {
+    mutex.lock();
+
+    ServerNode *this_node = get_by_pid(this_pid);
+    const Table *current = table.load();
+    if (!this_node || !current || !current->placement || connected.size() < 2) {
+        mutex.unlock();
         return;
     }
-    mutex.lock();
 
-    std::vector<int> upper_bounds;
-    std::vector<ServerNode*> nodes_to_update;
+    // the table can't be replaced while the mutex is held
+    const std::vector<std::shared_ptr<ServerNode>> &nodes_to_update = current->nodes;
+    LRUCache::Group owner = [current, this_node](uint64_t hash) {
+        size_t index = current->placement->get(hash);
+        return current->nodes[index].get() == this_node ? -1 : static_cast<int>(index);
+    };
 
-    auto it = connected.find(left);
-    if (it == connected.end()) {
-        std::cout << "???" << std::endl;
+    //extract from LRU cache
+    std::vector<std::string> import_strs = extract
+        ? extract(owner, nodes_to_update.size())
+        : cache.extract(owner, nodes_to_update.size());
+    if (import_strs.size() != nodes_to_update.size()) {
+        std::cout << "Error extracting cache" << std::endl;
         mutex.unlock();
         return;
     }
 
-    //start at node after this one
-    it++; 
+    // dealer socket to send cache partitions to appropriate nodes
+    zmq::context_t context(1);
+    zmq::socket_t socket(context, zmq::socket_type::dealer); 
+    socket.set(zmq::sockopt::rcvtimeo, 200);
 
-    // wrap around
-    if (wrap_around) {
-        // all new nodes after this to 360
-        while (it != connected.end()) {
-            nodes_to_update.emplace_back(*it);
-            upper_bounds.emplace_back((*it)->hash);
-            it++;
+    size_t sent = 0;
+    for (size_t i = 0; i < nodes_to_update.size(); i++) {
+        if (import_strs[i].size() > 0) {
+            socket.connect(nodes_to_update[i]->endpoint);
+            sent++;
         }
-
-        it = connected.begin();
     }
-    //take new nodes between this (or begin for wrap around) and right
-    while (it != connected.end() && *it != right) {
-        nodes_to_update.emplace_back(*it);
-        upper_bounds.emplace_back((*it)->hash);
-        it++;
+    for (size_t i = 0; i < nodes_to_update.size(); i++) {
+        if (import_strs[i].size() > 0) {
+            std::string updated = CACHE_UPDATE + import_strs[i];
+            socket.send(zmq::message_t(), zmq::send_flags::sndmore);
+            socket.send(zmq::buffer(updated), zmq::send_flags::none);
+        }
     }
 
-    if (upper_bounds.size() > 0) {
-        upper_bounds.emplace_back(right->hash);
-
-        //extract from LRU cache
-        std::vector<std::string> import_strs = cache.extract(upper_bounds);
-        if (import_strs.size() != nodes_to_update.size()) {
-            std::cout << "Error extracting cache" << std::endl;
-            mutex.unlock();
-            return;
+    size_t count = 0;
+    while (count < sent) {
+        try {
+            zmq::message_t request;
+            // empty envelope
+            zmq::recv_result_t res = socket.recv(request, zmq::recv_flags::none);
+            // actual result
+            res = socket.recv(request, zmq::recv_flags::none);
+            count++;
+        } catch (...) {
+            std::cout << "Recv " << count << " out of " << sent << std::endl;
         }
+    }
 
-        // dealer socket to send cache partitions to appropriate nodes
-        zmq::context_t context(1);
-        zmq::socket_t socket(context, zmq::socket_type::dealer); 
-        socket.set(zmq::sockopt::rcvtimeo, 200);
+    mutex.unlock();
+}
 
-        for (int i = 0; i < nodes_to_update.size(); i++) {
-            if (import_strs[i].size() > 0) {
-                socket.connect(nodes_to_update[i]->endpoint);
-            }
-        }
-        for (int i = 0; i < nodes_to_update.size(); i++) {
-            if (import_strs[i].size() > 0) {
-                std::string updated = CACHE_UPDATE + import_strs[i];
-                socket.send(zmq::message_t(), zmq::send_flags::sndmore);
-                socket.send(zmq::buffer(updated), zmq::send_flags::none);
-            }
-        }
+std::unordered_map<std::string, double> ConsistentHashing::ownership() {
+    mutex.lock();
+    std::unordered_map<std::string, double> owned;
 
-        int count = 0;
-        while (count < nodes_to_update.size()) {
-            try {
-                zmq::message_t request;
-                // empty envelope
-                zmq::recv_result_t res = socket.recv(request, zmq::recv_flags::none);
-                // actual result
-                res = socket.recv(request, zmq::recv_flags::none);
-                count++;
-            } catch (...) {
-                std::cout << "Recv " << count << " out of " << nodes_to_update.size() << std::endl;
-            }
+    for (const auto &node : connected) {
+        owned[node->pid] = 0;
+    }
+
+    // placements other than the ring have no ranges to add up, so hashes spread evenly over
+    // the ring are looked up instead
+    const Table *current = table.load();
+    if (current && current->placement) {
+        for (uint64_t i = 0; i < OWNERSHIP_SAMPLES; i++) {
+            uint64_t hash = i * (UINT64_MAX / OWNERSHIP_SAMPLES + 1);
+            owned[current->nodes[current->placement->get(hash)]->pid] += 1.0 / OWNERSHIP_SAMPLES;
         }
     }
 
     mutex.unlock();
+    return owned;
+}
+
+// the largest value over the mean, 1 when perfectly even
+template <typename T>
+static double max_over_mean(const std::vector<T> &values) {
+    if (values.size() == 0) {
+        return 0;
+    }
+
+    double total = 0;
+    double max = 0;
+    for (T value : values) {
+        total += value;
+        max = std::max(max, static_cast<double>(value));
+    }
+
+    return total > 0 ? max / (total / values.size()) : 0;
+}
+
+std::string ConsistentHashing::skew_report(const std::unordered_map<std::string, int64_t> &keys) {
+    std::unordered_map<std::string, double> owned = ownership();
+    // keys and shares per unit of weight, which are even when each node has its weight's share
+    std::vector<double> key_counts;
+    std::vector<double> shares;
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+
+    mutex.lock();
+    for (const auto &node : connected) {
+        auto found = keys.find(node->pid);
+        int64_t count = found != keys.end() ? found->second : 0;
+        key_counts.push_back(static_cast<double>(count) / node->weight);
+        shares.push_back(owned[node->pid] / node->weight);
+
+        ss << "[node " << node->pid << ": " << count << " keys, weight " << node->weight << ", "
+            << 100.0 * owned[node->pid] << "% of ring] ";
+    }
+    mutex.unlock();
+
+    ss << "keys max/mean: " << max_over_mean(key_counts) << ", ring max/mean: " << max_over_mean(shares);
+    return ss.str();
 }
 
 void ConsistentHashing::clean_up_old_nodes() {
     mutex.lock();
+    bool removed = false;
 
     auto it = connected.begin();
     while (it != connected.end()) {
-        ServerNode *cur = *it;
+        ServerNode *cur = it->get();
         if (!cur->is_leader && cur->pid != this_pid && cur->too_long_since_ping()) {
             if (dealer_active) {
                 dealer_socket->disconnect(cur->endpoint);
                 dealer_connected--;
             }
-            it = connected.erase(it);
-            delete cur;
+            it = erase(it);
+            removed = true;
         } else {
             it++;
         }
     }
 
+    if (removed) {
+        publish();
+    }
+
+    // placements other than the ring may move this node's keys to the nodes that stay
+    if (removed && placement_type != PlacementType::Ring) {
+        send_extracted_cache();
+    }
+
     mutex.unlock();
 }
 
@@ -402,7 +549,7 @@ std::vector<ServerNode*> ConsistentHashing::election_candidates() {
     std::vector<ServerNode*> candidates;
 
     for (auto it = connected.begin(); it != connected.end(); it++) {
-        ServerNode *cur = *it;
+        ServerNode *cur = it->get();
         if (!cur->is_leader && pid_greater(cur->pid, this_pid)) {
             candidates.emplace_back(cur);
         }
@@ -418,17 +565,17 @@ void ConsistentHashing::election_cleanup() {
         
     auto it = connected.begin();
     while (it != connected.end()) {
-        ServerNode *cur = *it;
+        ServerNode *cur = it->get();
         // remove old leader and this worker node
         // will get readded once promoted to leader
         if (cur->is_leader || cur->pid == this_pid)  {
-            it = connected.erase(it);
-            delete cur;
+            it = erase(it);
         } else {
             cur->refresh_last_ping();
             it++;
         }
     }
+    publish();
 
     mutex.unlock();
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <sstream>
+
+#include "entry_list.hpp"
+
+EntryList::EntryList(EntryList &&other): size(other.size), head(other.head), tail(other.tail) {
+    other.size = 0;
+    other.head = nullptr;
+    other.tail = nullptr;
+}
+
+EntryList& EntryList::operator=(EntryList &&other) {
+    if (this != &other) {
+        clear();
+
+        size = other.size;
+        head = other.head;
+        tail = other.tail;
+
+        other.size = 0;
+        other.head = nullptr;
+        other.tail = nullptr;
+    }
+
+    return *this;
+}
+
+void EntryList::add_end(CacheEntry *entry) {
+    if (!entry) {
+        return;
+    }
+
+    entry->next = nullptr;
+    entry->prev = tail;
+
+    if (tail) {
+        tail->next = entry;
+    } else {
+        head = entry;
+    }
+
+    tail = entry;
+    size++;
+}
+
+void EntryList::add_front(CacheEntry *entry) {
+    if (!entry) {
+        return;
+    }
+
+    entry->prev = nullptr;
+    entry->next = head;
+
+    if (head) {
+        head->prev = entry;
+    } else {
+        tail = entry;
+    }
+
+    head = entry;
+    size++;
+}
+
+CacheEntry *EntryList::remove(CacheEntry *entry) {
+    if (!entry || size == 0) {
+        return nullptr;
+    }
+
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        head = entry->next;
+    }
+
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        tail = entry->prev;
+    }
+
+    entry->prev = nullptr;
+    entry->next = nullptr;
+    size--;
+
+    return entry;
+}
+
+CacheEntry *EntryList::remove_front() {
+    return remove(head);
+}
+
+void EntryList::move_to_end(CacheEntry *entry) {
+    if (!entry || entry == tail) {
+        return;
+    }
+
+    remove(entry);
+    add_end(entry);
+}
+
+void EntryList::move_to_front(CacheEntry *entry) {
+    if (!entry || entry == head) {
+        return;
+    }
+
+    remove(entry);
+    add_front(entry);
+}
+
+void EntryList::clear() {
+    CacheEntry *cur = head;
+
+    while (cur) {
+        CacheEntry *next = cur->next;
+        delete cur;
+        cur = next;
+    }
+
+    size = 0;
+    head = nullptr;
+    tail = nullptr;
+}
+
+std::vector<std::string> EntryList::keys(bool single_str) {
+    std::stringstream ss;
+    std::vector<std::string> keys;
+
+    bool first_entry = true;
+    for (CacheEntry *cur = head; cur; cur = cur->next) {
+        if (cur->expired()) {
+            continue;
+        }
+
+        if (single_str) {
+            if (!first_entry) {
+                ss << " ";
+            } else {
+                first_entry = false;
+            }
+
+            ss << cur->key;
+        } else {
+            keys.emplace_back(cur->key);
+        }
+    }
+
+    if (single_str) {
+        return { ss.str() };
+    } else {
+        return keys;
+    }
+}
@@ -0,0 +1,219 @@
+#include <sstream>
+#include <algorithm>
+
+#include "eviction_policy.hpp"
+
+CacheEntry *LRUPolicy::victim(const KeyIndex &index, CacheEntry *keep) {
+    CacheEntry *lru = entries.front();
+    if (lru && lru == keep) {
+        lru = lru->next;
+    }
+
+    return lru;
+}
+
+uint64_t SampledPolicy::next_rand() {
+    // xorshift64
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+CacheEntry *SampledPolicy::victim(const KeyIndex &index, CacheEntry *keep) {
+    CacheEntry *oldest = nullptr;
+    uint32_t oldest_age = 0;
+
+    // each sample probes an independent random slot
+    for (int i = 0; i < EVICTION_SAMPLES; i++) {
+        CacheEntry *entry = index.sample(next_rand());
+        if (!entry || entry == keep) {
+            continue;
+        }
+
+        uint32_t age = clock - entry->access;
+        if (!oldest || age > oldest_age) {
+            oldest = entry;
+            oldest_age = age;
+        }
+    }
+
+    if (!oldest && index.size() > 1) {
+        // every sample hit keep. fall back to the first inserted entry
+        oldest = entries.front() == keep ? keep->next : entries.front();
+    }
+
+    return oldest;
+}
+
+CacheEntry *ClockPolicy::victim(const KeyIndex &index, CacheEntry *keep) {
+    // every entry is passed over at most once before its bit is clear, so two laps always find one
+    for (long i = 0; i < 2 * entries.get_size(); i++) {
+        CacheEntry *hand = entries.front();
+
+        if (hand != keep && !hand->access) {
+            return hand;
+        }
+
+        hand->access = 0;
+        entries.move_to_end(hand);
+    }
+
+    return nullptr;
+}
+
+long TinyLFUPolicy::window_max() {
+    return std::max(1L, total() * TINYLFU_WINDOW_PERCENT / 100);
+}
+
+long TinyLFUPolicy::protected_max() {
+    return (total() - window_max()) * TINYLFU_PROTECTED_PERCENT / 100;
+}
+
+EntryList &TinyLFUPolicy::segment(CacheEntry *entry) {
+    switch (entry->access) {
+        case window: return window_entries;
+        case probation: return probation_entries;
+        default: return protected_entries;
+    }
+}
+
+void TinyLFUPolicy::move(CacheEntry *entry, Segment to) {
+    segment(entry).remove(entry);
+    entry->access = to;
+    segment(entry).add_end(entry);
+}
+
+void TinyLFUPolicy::reserve(long max_entries) {
+    // resizing clears the counts, so size the sketch for a full cache from the start
+    if (max_entries > (long) sketch.get_capacity()) {
+        sketch.resize(std::min(max_entries, TINYLFU_MAX_SKETCH_KEYS));
+    }
+}
+
+void TinyLFUPolicy::insert(CacheEntry *entry) {
+    entry->access = window;
+    window_entries.add_end(entry);
+
+    // the sketch needs to be sized for at least every entry to tell keys apart
+    if (total() > (long) sketch.get_capacity()) {
+        sketch.resize(total() * 2);
+    }
+
+    // while the cache has room, entries leave the window without competing for admission
+    while (window_entries.get_size() > window_max()) {
+        move(window_entries.front(), probation);
+    }
+}
+
+void TinyLFUPolicy::access(CacheEntry *entry) {
+    sketch.increment(KeyIndex::hash_key(entry->key));
+
+    switch (entry->access) {
+        case window:
+            window_entries.move_to_end(entry);
+            break;
+        case probation:
+            move(entry, protect);
+
+            if (protected_entries.get_size() > protected_max()) {
+                move(protected_entries.front(), probation);
+            }
+            break;
+        default:
+            protected_entries.move_to_end(entry);
+            break;
+    }
+}
+
+void TinyLFUPolicy::demote(CacheEntry *entry) {
+    segment(entry).remove(entry);
+    entry->access = probation;
+    probation_entries.add_front(entry);
+}
+
+// returns the front of list, or the entry after it if the front is keep
+static CacheEntry *front_except(EntryList &list, CacheEntry *keep) {
+    CacheEntry *front = list.front();
+    if (front && front == keep) {
+        front = front->next;
+    }
+
+    return front;
+}
+
+CacheEntry *TinyLFUPolicy::victim(const KeyIndex &index, CacheEntry *keep) {
+    CacheEntry *main_victim = front_except(probation_entries, keep);
+    if (!main_victim) {
+        main_victim = front_except(protected_entries, keep);
+    }
+
+    // the entry about to be inserted will push the window's LRU entry out, so it competes now
+    CacheEntry *candidate = nullptr;
+    if (window_entries.get_size() >= window_max()) {
+        candidate = front_except(window_entries, keep);
+    }
+
+    if (!candidate) {
+        return main_victim ? main_victim : front_except(window_entries, keep);
+    } else if (!main_victim) {
+        return candidate;
+    }
+
+    if (frequency(candidate) > frequency(main_victim)) {
+        move(candidate, probation);
+        return main_victim;
+    }
+
+    return candidate;
+}
+
+std::vector<std::string> TinyLFUPolicy::keys(bool single_str) {
+    std::vector<std::string> keys;
+    for (EntryList *list : {&probation_entries, &protected_entries, &window_entries}) {
+        std::vector<std::string> segment_keys = list->keys();
+        keys.insert(keys.end(), segment_keys.begin(), segment_keys.end());
+    }
+
+    if (!single_str) {
+        return keys;
+    }
+
+    std::stringstream ss;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i > 0) {
+            ss << " ";
+        }
+        ss << keys[i];
+    }
+
+    return { ss.str() };
+}
+
+void TinyLFUPolicy::clear() {
+    window_entries.clear();
+    probation_entries.clear();
+    protected_entries.clear();
+    sketch.clear();
+}
+
+void TinyLFUPolicy::release() {
+    window_entries.release();
+    probation_entries.release();
+    protected_entries.release();
+    sketch.clear();
+}
+
+std::unique_ptr<EvictionPolicy> make_eviction_policy(const std::string &name) {
+    if (name == "lru") {
+        return std::make_unique<LRUPolicy>();
+    } else if (name == "sampled") {
+        return std::make_unique<SampledPolicy>();
+    } else if (name == "clock") {
+        return std::make_unique<ClockPolicy>();
+    } else if (name == "tinylfu") {
+        return std::make_unique<TinyLFUPolicy>();
+    }
+
+    return nullptr;
+}
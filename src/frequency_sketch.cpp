@@ -0,0 +1,72 @@
+#include <algorithm>
+
+#include "frequency_sketch.hpp"
+
+// odd multipliers giving each row an independent column for the same hash
+static const uint64_t ROW_SEEDS[SKETCH_DEPTH] = {
+    0x9E3779B97F4A7C15ULL,
+    0xC2B2AE3D27D4EB4FULL,
+    0x165667B19E3779F9ULL,
+    0xD6E8FEB86659FD93ULL
+};
+
+size_t FrequencySketch::index(uint64_t hash, int row) const {
+    uint64_t h = (hash + ROW_SEEDS[row]) * ROW_SEEDS[row];
+    h ^= h >> 32;
+    return row * width + (h & (width - 1));
+}
+
+void FrequencySketch::resize(size_t capacity) {
+    size_t new_width = 16;
+    while (new_width < capacity * SKETCH_COLUMNS_PER_KEY) {
+        new_width *= 2;
+    }
+
+    if (new_width == width) {
+        return;
+    }
+
+    width = new_width;
+    table.assign(SKETCH_DEPTH * width / 2, 0);
+    additions = 0;
+}
+
+void FrequencySketch::age() {
+    // halves both counters in each byte at once
+    for (uint8_t &counts : table) {
+        counts = (counts >> 1) & 0x77;
+    }
+
+    additions /= 2;
+}
+
+void FrequencySketch::increment(uint64_t hash) {
+    bool added = false;
+
+    for (int row = 0; row < SKETCH_DEPTH; row++) {
+        size_t i = index(hash, row);
+        if (get(i) < SKETCH_MAX_COUNT) {
+            table[i / 2] += 1 << (i % 2 * 4);
+            added = true;
+        }
+    }
+
+    if (added && ++additions >= SKETCH_SAMPLE_FACTOR * get_capacity()) {
+        age();
+    }
+}
+
+uint8_t FrequencySketch::frequency(uint64_t hash) const {
+    uint8_t freq = SKETCH_MAX_COUNT;
+
+    for (int row = 0; row < SKETCH_DEPTH; row++) {
+        freq = std::min(freq, get(index(hash, row)));
+    }
+
+    return freq;
+}
+
+void FrequencySketch::clear() {
+    std::fill(table.begin(), table.end(), 0);
+    additions = 0;
+}
@@ -0,0 +1,16 @@
+#include "globals.hpp"
+
+// the node's globals, set from its options. programs, tests and benchmarks share these defaults
+bool monitoring = false;
+bool stop = false;
+LRUCache cache {};
+int secs_offset = 0;
+int ms_offset = 0;
+int client_port = 5555;
+int internal_port = -1;
+int tcp_port = -1;
+int worker_threads = 1;
+bool pin_threads = false;
+int virtual_nodes = DEFAULT_VNODES;
+int node_weight = 1;
+ConsistentHashing ring;
@@ -0,0 +1,283 @@
+#include <functional>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "key_index.hpp"
+#include "entries/cache_entry.hpp"
+
+void KeyIndex::iterator::skip_empty() {
+    while (i < index->capacity && index->ctrl[i] < 0) {
+        i++;
+    }
+}
+
+KeyIndex::~KeyIndex() {
+    delete[] ctrl;
+    delete[] slots;
+}
+
+KeyIndex::KeyIndex(KeyIndex &&other):
+    ctrl(other.ctrl),
+    slots(other.slots),
+    capacity(other.capacity),
+    used(other.used),
+    tombstones(other.tombstones) {
+
+    other.ctrl = nullptr;
+    other.slots = nullptr;
+    other.capacity = 0;
+    other.used = 0;
+    other.tombstones = 0;
+}
+
+KeyIndex& KeyIndex::operator=(KeyIndex &&other) {
+    if (this != &other) {
+        delete[] ctrl;
+        delete[] slots;
+
+        ctrl = other.ctrl;
+        slots = other.slots;
+        capacity = other.capacity;
+        used = other.used;
+        tombstones = other.tombstones;
+
+        other.ctrl = nullptr;
+        other.slots = nullptr;
+        other.capacity = 0;
+        other.used = 0;
+        other.tombstones = 0;
+    }
+
+    return *this;
+}
+
+uint64_t KeyIndex::hash_key(std::string_view key) {
+    return std::hash<std::string_view>()(key);
+}
+
+size_t KeyIndex::memory_usage() const {
+    if (capacity == 0) {
+        return 0;
+    }
+
+    return capacity * sizeof(Slot) + capacity + GROUP_SIZE;
+}
+
+void KeyIndex::set_ctrl(size_t i, int8_t value) {
+    ctrl[i] = value;
+
+    // keep the mirrored bytes at the end in sync
+    if (i < GROUP_SIZE) {
+        ctrl[capacity + i] = value;
+    }
+}
+
+uint32_t KeyIndex::match(size_t pos, int8_t value) const {
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl + pos));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), group));
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < GROUP_SIZE; i++) {
+        if (ctrl[pos + i] == value) {
+            bits |= 1u << i;
+        }
+    }
+    return bits;
+#endif
+}
+
+uint32_t KeyIndex::match_empty_or_deleted(size_t pos) const {
+#ifdef __SSE2__
+    // EMPTY and DELETED are the only control bytes less than -1
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl + pos));
+    return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), group));
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < GROUP_SIZE; i++) {
+        if (ctrl[pos + i] < -1) {
+            bits |= 1u << i;
+        }
+    }
+    return bits;
+#endif
+}
+
+size_t KeyIndex::find_index(std::string_view key, uint64_t hash) const {
+    if (capacity == 0) {
+        return capacity;
+    }
+
+    size_t mask = capacity - 1;
+    size_t pos = h1(hash) & mask;
+    size_t stride = 0;
+    int8_t tag = h2(hash);
+
+    // triangular probing over groups visits every group once when capacity is a power of 2
+    while (true) {
+        uint32_t bits = match(pos, tag);
+        while (bits) {
+            size_t i = (pos + __builtin_ctz(bits)) & mask;
+            const Slot &slot = slots[i];
+            if (slot.hash == hash && slot.value->key == key) {
+                return i;
+            }
+
+            bits &= bits - 1;
+        }
+
+        // an empty slot ends the probe sequence
+        if (match(pos, EMPTY)) {
+            return capacity;
+        }
+
+        stride += GROUP_SIZE;
+        pos = (pos + stride) & mask;
+    }
+}
+
+size_t KeyIndex::find_insert_index(uint64_t hash) const {
+    size_t mask = capacity - 1;
+    size_t pos = h1(hash) & mask;
+    size_t stride = 0;
+
+    while (true) {
+        uint32_t bits = match_empty_or_deleted(pos);
+        if (bits) {
+            return (pos + __builtin_ctz(bits)) & mask;
+        }
+
+        stride += GROUP_SIZE;
+        pos = (pos + stride) & mask;
+    }
+}
+
+void KeyIndex::rehash(size_t new_capacity) {
+    int8_t *old_ctrl = ctrl;
+    Slot *old_slots = slots;
+    size_t old_capacity = capacity;
+
+    capacity = new_capacity;
+    ctrl = new int8_t[capacity + GROUP_SIZE];
+    std::memset(ctrl, EMPTY, capacity + GROUP_SIZE);
+    slots = new Slot[capacity];
+    tombstones = 0;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] >= 0) {
+            Slot &old_slot = old_slots[i];
+            size_t j = find_insert_index(old_slot.hash);
+
+            set_ctrl(j, h2(old_slot.hash));
+            slots[j] = old_slot;
+        }
+    }
+
+    delete[] old_ctrl;
+    delete[] old_slots;
+}
+
+void KeyIndex::reserve(size_t n) {
+    // keep the load factor at or below 7/8
+    size_t needed = GROUP_SIZE;
+    while (needed / 8 * 7 < n) {
+        needed *= 2;
+    }
+
+    if (needed > capacity) {
+        rehash(needed);
+    }
+}
+
+void KeyIndex::clear() {
+    delete[] ctrl;
+    delete[] slots;
+
+    ctrl = nullptr;
+    slots = nullptr;
+    capacity = 0;
+    used = 0;
+    tombstones = 0;
+}
+
+CacheEntry *KeyIndex::find(std::string_view key) const {
+    size_t i = find_index(key, hash_key(key));
+    if (i == capacity) {
+        return nullptr;
+    }
+
+    return slots[i].value;
+}
+
+bool KeyIndex::insert(CacheEntry *entry) {
+    uint64_t hash = hash_key(entry->key);
+    if (find_index(entry->key, hash) != capacity) {
+        return false;
+    }
+
+    if (capacity == 0 || (used + tombstones + 1) > capacity / 8 * 7) {
+        // reclaim tombstones in place if they make up most of the load, otherwise grow
+        if (capacity > 0 && tombstones > used) {
+            rehash(capacity);
+        } else {
+            rehash(capacity == 0 ? GROUP_SIZE : capacity * 2);
+        }
+    }
+
+    size_t i = find_insert_index(hash);
+    if (ctrl[i] == DELETED) {
+        tombstones--;
+    }
+
+    set_ctrl(i, h2(hash));
+    slots[i].hash = hash;
+    slots[i].value = entry;
+    used++;
+
+    return true;
+}
+
+bool KeyIndex::erase(std::string_view key) {
+    size_t i = find_index(key, hash_key(key));
+    if (i == capacity) {
+        return false;
+    }
+
+    // a slot can go straight back to EMPTY if no group containing it was ever full,
+    // since then no probe sequence could have continued past it
+    size_t mask = capacity - 1;
+    uint32_t empty_after = match(i, EMPTY);
+    uint32_t empty_before = match((i - GROUP_SIZE) & mask, EMPTY);
+
+    bool never_full = empty_after && empty_before &&
+        (__builtin_ctz(empty_after) + (__builtin_clz(empty_before) - 16)) < (int) GROUP_SIZE;
+
+    if (never_full) {
+        set_ctrl(i, EMPTY);
+    } else {
+        set_ctrl(i, DELETED);
+        tombstones++;
+    }
+
+    slots[i].value = nullptr;
+    used--;
+
+    return true;
+}
+
+CacheEntry *KeyIndex::sample(uint64_t r) const {
+    if (used == 0) {
+        return nullptr;
+    }
+
+    size_t mask = capacity - 1;
+    size_t i = r & mask;
+    while (ctrl[i] < 0) {
+        i = (i + 1) & mask;
+    }
+
+    return slots[i].value;
+}
@@ -3,21 +3,28 @@
 #include <zmq.hpp>
 #include <unistd.h>
 #include <string>
+#include <cstring>
+#include <algorithm>
+#include <functional>
 
 #include "command.hpp"
+#include "resp.hpp"
 #include "lru_cache.hpp"
 #include "globals.hpp"
 #include "unix_times.hpp"
 #include "consistent-hashing.hpp"
 #include "leader.hpp"
 #include "worker.hpp"
+#include "tcp_server.hpp"
 
 using namespace std::chrono_literals;
 
 void start_leader() {
     ring.set_up_dealer();
-    
-    std::thread client_thread(handle_client_requests);
+
+    // made before the internal thread starts, so a worker joining finds the shards' extract hook installed
+    ClientRequests clients;
+    std::thread client_thread(handle_client_requests, std::ref(clients));
     std::thread internal_thread(handle_internal_requests);
     std::thread cleanup_thread(handle_nodes_cleanup);
 
@@ -40,40 +47,38 @@ void handle_internal_requests() {
     zmq::context_t internal_context{1};
     zmq::socket_t internal_socket{internal_context, zmq::socket_type::rep};
     internal_socket.bind("tcp://*:" + std::to_string(internal_port));
-    ring.add(leader_pid, internal_socket.get(zmq::sockopt::last_endpoint), true);
+    ring.add(leader_pid, internal_socket.get(zmq::sockopt::last_endpoint), true, virtual_nodes, node_weight);
 
-    ServerNode *this_node = ring.get_by_pid(leader_pid);
     while (true) {
         try {
             zmq::message_t reply;
             zmq::recv_result_t res = internal_socket.recv(reply, zmq::recv_flags::none);
-            bool new_added = false;
             std::string ping_msg = reply.to_string();
 
-            ServerNode *next_node = nullptr;
             ServerNode *added = nullptr;
-            bool wrap_around = false;
 
             int sep = ping_msg.find(" ");
             if (sep != std::string::npos) {
                 std::string pid = ping_msg.substr(0, sep);
                 std::string endpoint = ping_msg.substr(sep + 1); 
 
-                ServerNode *cur = ring.get(pid + endpoint);
-                if (cur && cur->pid == pid && cur->endpoint == endpoint) {
+                // the worker's weight follows its endpoint
+                int weight = 1;
+                size_t weight_sep = endpoint.find(" ");
+                if (weight_sep != std::string::npos) {
+                    weight = std::clamp(atoi(endpoint.c_str() + weight_sep + 1), 1, MAX_WEIGHT);
+                    endpoint.resize(weight_sep);
+                }
+
+                ServerNode *cur = ring.find(pid, endpoint);
+                if (cur) {
                     cur->refresh_last_ping();
                 } else {
-                    // add this to ring
-                    new_added = true;
-
-                    next_node = ring.get_next_node(this_node);
-                    bool wrap_around = ring.is_begin(next_node);
-
-                
-                    added = ring.add(pid, endpoint, false);
+                    // add this to ring, with as many points per unit of weight as the leader's
+                    added = ring.add(pid, endpoint, false, virtual_nodes, weight);
                     
                     std::cout << "Connected to worker node with pid: " << pid 
-                        << " and endpoint: " << endpoint << std::endl;
+                        << " and endpoint: " << endpoint << " and weight: " << weight << std::endl;
                 }
             }
 
@@ -83,10 +88,8 @@ void handle_internal_requests() {
             //send latest connections, RING_UPDATE prefix not needed for ping
             internal_socket.send(zmq::buffer(internal), zmq::send_flags::none);
 
-            if (new_added) {
-                if (next_node && added && ring.get_next_node(this_node) == added) {
-                    ring.send_extracted_cache(this_node, next_node, wrap_around);
-                }
+            if (added) {
+                ring.send_extracted_cache();
 
                 //ring update needed for request
                 ring.dealer_send(RING_UPDATE + internal);
@@ -116,164 +119,721 @@ void handle_internal_requests() {
     }
 }
 
-void handle_client_requests() {
-    std::string leader_pid = std::to_string(getpid());
+// a COMMAND message for workers: the protocol to reply in, then the request as a RESP array
+static std::string command_message(const Tokens &tokens, resp::Protocol protocol) {
+    std::string msg;
+    msg += COMMAND;
+    msg += static_cast<char>(protocol);
+    resp::write_request(tokens, msg);
+    return msg;
+}
 
-    // client socket for client requests
-    zmq::context_t client_context{1};
-    zmq::socket_t client_socket{client_context, zmq::socket_type::rep};
-    client_socket.bind("tcp://*:" + std::to_string(client_port));
+// adds up the keys of each node in a dist reply, "[node pid: count]" for each node or shard
+static void count_dist(const std::string &dist, std::unordered_map<std::string, int64_t> &keys) {
+    size_t pos = 0;
+    while ((pos = dist.find("[node ", pos)) != std::string::npos) {
+        size_t sep = dist.find(": ", pos);
+        if (sep == std::string::npos) {
+            return;
+        }
 
-    std::cout << "Started leader node with pid " << leader_pid << " on " 
-        << client_socket.get(zmq::sockopt::last_endpoint)
-        << std::endl;
+        std::string pid = dist.substr(pos + 6, sep - pos - 6);
+        keys[pid] += atoll(dist.c_str() + sep + 2);
+        pos = sep;
+    }
+}
 
-    while (true) {
-        zmq::message_t request;
-        zmq::recv_result_t res = client_socket.recv(request, zmq::recv_flags::none);
-
-        std::string reply = "";
-        std::string msg = request.to_string();
-
-        if (monitoring) {
-            std::cout << msg << std::endl; 
-        }
-        
-        // does this command require asking all the nodes?
-        std::string name = cmd::extract_name(msg);
-        cmd::NodeCMDType nodeCmd = cmd::nodeCmds(name);
-        bool shouldAddAll = cmd::addAll(name);
-        bool shouldConcatAll = cmd::concatAll(name);
-        bool shouldAskAll = cmd::askAll(name);
-
-        if (nodeCmd != cmd::NodeCMDType::Not) {
-            switch(nodeCmd) {
-                case cmd::NodeCMDType::Nodes: {
-                    reply = ring.to_user_string();
-                    break;
+bool ClientRequests::serve_request(const Tokens &tokens, resp::Protocol &protocol, std::string &reply, Pending &origin) {
+    if (monitoring) {
+        for (size_t i = 0; i < tokens.size(); i++) {
+            std::cout << (i > 0 ? " " : "") << tokens[i];
+        }
+        std::cout << std::endl;
+    }
+    
+    // one lookup in the command table decides how the request is served.
+    // unknown commands are run locally, which replies with the error
+    const cmd::Spec *spec = cmd::lookup(tokens.name());
+    cmd::Routing routing = spec ? spec->routing : cmd::Routing::Local;
+
+    // does this command require asking all the nodes?
+    cmd::NodeCMDType nodeCmd = routing == cmd::Routing::Node ? cmd::nodeCmds(tokens.name()) : cmd::NodeCMDType::Not;
+    bool shouldAddAll = routing == cmd::Routing::Sum;
+    bool shouldConcatAll = routing == cmd::Routing::Concat;
+    bool shouldAskAll = routing == cmd::Routing::Broadcast;
+
+    if (nodeCmd != cmd::NodeCMDType::Not) {
+        std::string text;
+
+        switch(nodeCmd) {
+            case cmd::NodeCMDType::Nodes: {
+                text = ring.to_user_string();
+                break;
+            }
+            case cmd::NodeCMDType::Ring: {
+                // for clients that send requests straight to the owning worker
+                text = ring.to_internal_string();
+                break;
+            }
+            case cmd::NodeCMDType::Skew: {
+                // keys per node from dist, against how much of the ring each owns
+                Tokens dist { "dist" };
+                std::unordered_map<std::string, int64_t> keys;
+                count_dist(ask_local(dist, resp::Protocol::Text), keys);
+                for (const std::string &part : ask_workers(command_message(dist, resp::Protocol::Text))) {
+                    count_dist(part, keys);
                 }
-                case cmd::NodeCMDType::Create: {
-                    int pid = fork();
-                    if (pid == 0) {
-                        char i_port[100], c_port[100];
-                        snprintf(i_port, sizeof(i_port), "%d", internal_port);
-                        snprintf(c_port, sizeof(c_port), "%d", client_port);
-                        execlp("./node", "./node", "-w", "-i", i_port, "-c", c_port, nullptr);
-                        exit(EXIT_FAILURE);
-                    } else {
-                        reply = "Worker node created with pid " + std::to_string(pid);
+
+                text = ring.skew_report(keys);
+                break;
+            }
+            case cmd::NodeCMDType::Create: {
+                int pid = fork();
+                if (pid == 0) {
+                    char i_port[100], c_port[100], t_port[100], threads[100], vnodes[100];
+                    snprintf(i_port, sizeof(i_port), "%d", internal_port);
+                    snprintf(c_port, sizeof(c_port), "%d", client_port);
+                    snprintf(t_port, sizeof(t_port), "%d", tcp_port);
+                    snprintf(threads, sizeof(threads), "%d", worker_threads);
+                    snprintf(vnodes, sizeof(vnodes), "%d", virtual_nodes);
+                    std::vector<char*> args { (char*)"./node", (char*)"-w", (char*)"-i", i_port, (char*)"-c", c_port,
+                        (char*)"-n", threads, (char*)"-v", vnodes };
+                    if (pin_threads) {
+                        args.push_back((char*)"-p");
                     }
-                    break;
-                }
-                case cmd::NodeCMDType::Kill: {
-                    std::string key = cmd::extract_key(msg);
-                    if (key == "leader" || key == leader_pid) {
-                        client_socket.send(zmq::buffer("OK"), zmq::send_flags::none);
-                        exit(EXIT_SUCCESS);
+                    // workers are passed the TCP port too, in case they are elected leader
+                    if (tcp_port >= 0) {
+                        args.push_back((char*)"-t");
+                        args.push_back(t_port);
                     }
+                    args.push_back(nullptr);
+                    execvp("./node", args.data());
+                    exit(EXIT_FAILURE);
+                } else {
+                    text = "Worker node created with pid " + std::to_string(pid);
+                }
+                break;
+            }
+            case cmd::NodeCMDType::Kill: {
+                std::string key { tokens.key() };
+                if (key == "leader" || key == leader_pid) {
+                    // the leader exits once the reply is sent
+                    stop = true;
+                    resp::Writer { reply, protocol }.simple("OK");
+                    return true;
+                }
 
-                    ServerNode *node = ring.get_by_pid(key);
-                    if (!node) {
-                        reply = "Node not found";
-                    } else {
-                        node->send(NODE_COMMAND + msg);
-                        node->recv(request);
-                        reply = request.to_string();
-                    }
-                    break;
+                ServerNode *node = ring.get_by_pid(key);
+                if (!node) {
+                    text = "Node not found";
+                } else {
+                    zmq::message_t node_reply;
+                    node->send(NODE_COMMAND + std::string("kill ") + key);
+                    node->recv(node_reply);
+                    text = node_reply.to_string();
                 }
-                default:
-                    break;
+                break;
             }
-        } else if (shouldAddAll || shouldConcatAll || shouldAskAll) {
-            ring.dealer_send(COMMAND + msg);
+            default:
+                break;
+        }
+
+        resp::Writer { reply, protocol }.bulk(text);
+    } else if (shouldAddAll || shouldConcatAll || shouldAskAll) {
+        // these are rare admin and stats commands, so they still wait for every node in turn.
+        // sums are added up here, so workers reply in text
+        resp::Protocol node_protocol = shouldAddAll ? resp::Protocol::Text : protocol;
+        std::vector<std::string> replies = ask_workers(command_message(tokens, node_protocol));
 
-            int sum = 0;
-            std::stringstream ss;
+        // process on master node first
+        std::string parsed = ask_local(tokens, node_protocol);
+        replies.insert(replies.begin(), parsed);
 
-            // process onmaster node
-            Command cmd { request.to_string() };
-            std::string parsed = cmd.parse_cmd();
+        int64_t sum = 0;
+        std::stringstream ss;
+        std::vector<std::string> parts;
 
+        for (const std::string &str : replies) {
             if (shouldAddAll) {
                 try {
-                    sum += stoi(parsed);
+                    sum += stoll(str);
                 } catch (...) {
-                    std::cout << "Error with this cmd: " << msg << std::endl;
+                    std::cout << "Error with this cmd: " << tokens.name() << std::endl;
                 }
             } else if (shouldConcatAll) {
-                if (parsed.size() > 0) {
-                    ss << parsed << " ";
+                if (protocol != resp::Protocol::Text) {
+                    parts.push_back(str);
+                } else if (str.size() > 0) {
+                    ss << str << " ";
                 }
             }
+        }
 
-            // ask for worker node responses
-            // stop after all responses (or timeout)
-            ring.mutex.lock();
-            int count = 0;
-            while (count < ring.dealer_connected) {
-                try {
-                    zmq::message_t dealer_request;
-                    // empty envelope
-                    zmq::recv_result_t res = ring.dealer_socket->recv(dealer_request, zmq::recv_flags::none);
-                    // actual result
-                    res = ring.dealer_socket->recv(dealer_request, zmq::recv_flags::none);
-
-                    count++;
-                    if (shouldAddAll) {
-                        try {
-                            sum += stoi(dealer_request.to_string());
-                        } catch (...) {
-                            std::cout << "Error with this cmd: " << msg << std::endl;
-                        }
-                    } else if (shouldConcatAll) {
-                        std::string str = dealer_request.to_string();
-                        if (str.size() > 0) {
-                            ss << str << " ";
-                        }
-                    }
-                } catch (...) {
-                    std::cout << "Recv " << count << " out of " << ring.size() << std::endl;
-                }
+        if (shouldAddAll) {
+            resp::Writer { reply, protocol }.integer(sum);
+        } else if (shouldConcatAll) {
+            reply += protocol == resp::Protocol::Text ? ss.str() : resp::merge_arrays(parts);
+        } else {
+            reply += parsed;
+        }
+    } else if (routing == cmd::Routing::Keys || routing == cmd::Routing::Pairs) {
+        return serve_keys(tokens, routing == cmd::Routing::Pairs ? 2 : 1, protocol, reply, origin);
+    } else {
+        std::shared_ptr<ServerNode> worker;
+        std::string_view key = tokens.key();
+        if (routing == cmd::Routing::Key && key != "") {
+            worker = ring.get(key);
+            if (monitoring && worker) {
+                std::cout << key << " [" << hash_function(key)
+                    << "] in to Node [" << worker->hash << "] with pid " 
+                    << worker->pid  << std::endl;
             }
-            ring.mutex.unlock();
-            if (shouldAddAll) {
-                reply = std::to_string(sum);
-            } else if (shouldConcatAll) {
-                reply = ss.str();
+        }
+
+        if (worker && worker->pid != leader_pid) {
+            //request goes to another worker, whose reply is already in the client's protocol.
+            //the client is answered when it arrives, so others are served meanwhile
+            origin.protocol = protocol;
+            if (forward(worker->pid, worker->endpoint, command_message(tokens, protocol), origin)) {
+                return false;
             }
+
+            resp::Writer { reply, protocol }.error("FAILED");
+        } else if (worker || (shards && spec && (spec->flags & (cmd::READ | cmd::WRITE)))) {
+            //request for a key the leader owns, or another command on its cache, which with
+            //shards is theirs rather than the global one
+            return serve_local(tokens, protocol, reply, origin);
+        } else { 
+            //request can be fuffiled by leader
+            Command cmd { tokens, protocol };
+            reply += cmd.parse_cmd();
+            // HELLO switches the connection's protocol
+            protocol = cmd.get_protocol();
+        }
+    }
+
+    return true;
+}
+
+ClientRequests::ClientRequests():
+    leader_pid(std::to_string(getpid())),
+    client_socket(context, zmq::socket_type::router),
+    worker_socket(context, zmq::socket_type::router),
+    tcp_server([this](const Tokens &args, resp::Protocol &protocol, std::string &out, const TcpServer::Ticket &ticket) {
+        Pending origin;
+        origin.ticket = ticket;
+        return serve_request(args, protocol, out, origin);
+    }) {
+
+    // sends to a worker that isn't connected fail instead of being dropped
+    worker_socket.set(zmq::sockopt::router_mandatory, true);
+    worker_socket.set(zmq::sockopt::linger, 0);
+
+    if (worker_threads > 1) {
+        shards = std::make_unique<Shards>(worker_threads, cache, pin_threads);
+        ring.extract = [this](const LRUCache::Group &group, size_t groups) {
+            return shards->extract(group, groups);
+        };
+
+        // a worker elected leader brings its keys in the global cache. the bounds cover the whole ring
+        for (const std::string &entries : cache.extract({ 0, 0 })) {
+            std::string reply;
+            shards->call(CACHE_UPDATE + entries, reply);
+        }
+        cache.clear();
+    }
+}
+
+std::vector<std::string> ClientRequests::ask_workers(const std::string &msg) {
+    std::vector<std::string> replies;
+    ring.dealer_send(msg);
+
+    // stop after all responses (or timeout)
+    ring.mutex.lock();
+    int count = 0;
+    while (count < ring.dealer_connected) {
+        try {
+            zmq::message_t dealer_request;
+            // empty envelope
+            zmq::recv_result_t res = ring.dealer_socket->recv(dealer_request, zmq::recv_flags::none);
+            // actual result
+            res = ring.dealer_socket->recv(dealer_request, zmq::recv_flags::none);
+
+            count++;
+            replies.push_back(dealer_request.to_string());
+        } catch (...) {
+            std::cout << "Recv " << count << " out of " << ring.size() << std::endl;
+        }
+    }
+    ring.mutex.unlock();
+
+    return replies;
+}
+
+std::string ClientRequests::ask_local(const Tokens &tokens, resp::Protocol protocol) {
+    std::string parsed;
+    if (!shards || !shards->call(command_message(tokens, protocol), parsed)) {
+        Command cmd { tokens, protocol };
+        parsed = cmd.parse_cmd();
+    }
+    return parsed;
+}
+
+bool ClientRequests::serve_local(const Tokens &tokens, resp::Protocol protocol, std::string &reply, Pending &origin) {
+    if (shards) {
+        origin.protocol = protocol;
+        submit(command_message(tokens, protocol), origin);
+        return false;
+    }
+
+    Command cmd { tokens, protocol };
+    reply += cmd.parse_cmd();
+    return true;
+}
+
+void ClientRequests::submit(const std::string &msg, Pending &origin) {
+    // Done must be copyable, so the origin is shared
+    auto waiting = std::make_shared<Pending>(std::move(origin));
+    shards->submit(msg, [this, waiting](std::string &&out) {
+        zmq::message_t reply(out.data(), out.size());
+        send_reply(*waiting, reply);
+    });
+}
+
+bool ClientRequests::serve_keys(const Tokens &tokens, size_t step, resp::Protocol protocol, std::string &reply, Pending &origin) {
+    // the keys' owners, and where each one's keys are in the command
+    std::vector<std::shared_ptr<ServerNode>> owners;
+    std::vector<std::vector<size_t>> keys;
+
+    // a missing value is an error the command replies with itself
+    if ((tokens.size() - 1) % step == 0) {
+        std::unordered_map<ServerNode*, size_t> parts;
+        for (size_t i = 1; i < tokens.size(); i += step) {
+            std::shared_ptr<ServerNode> owner = ring.get(tokens[i]);
+            auto [it, added] = parts.emplace(owner.get(), owners.size());
+            if (added) {
+                owners.push_back(owner);
+                keys.emplace_back();
+            }
+            keys[it->second].push_back((i - 1) / step);
+        }
+    }
+
+    // every key is on one node, so the command is sent as is
+    if (owners.size() <= 1) {
+        std::shared_ptr<ServerNode> worker = owners.empty() ? nullptr : owners[0];
+        if (worker && worker->pid != leader_pid) {
+            origin.protocol = protocol;
+            if (forward(worker->pid, worker->endpoint, command_message(tokens, protocol), origin)) {
+                return false;
+            }
+
+            resp::Writer { reply, protocol }.error("FAILED");
+            return true;
+        }
+        return serve_local(tokens, protocol, reply, origin);
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->replies.resize(owners.size());
+    batch->key_count = (tokens.size() - 1) / step;
+
+    // parts are asked in RESP2 whatever the client's protocol, so they can be merged
+    for (size_t part = 0; part < owners.size(); part++) {
+        Tokens sub;
+        sub.push(tokens.name());
+        for (size_t key : keys[part]) {
+            for (size_t arg = 0; arg < step; arg++) {
+                sub.push(tokens[1 + key * step + arg]);
+            }
+        }
+
+        Pending part_origin;
+        part_origin.batch = batch;
+        part_origin.indexes = { part };
+        part_origin.protocol = resp::Protocol::RESP2;
+
+        const std::shared_ptr<ServerNode> &worker = owners[part];
+        if (!worker || worker->pid == leader_pid) {
+            if (!serve_local(sub, resp::Protocol::RESP2, batch->replies[part], part_origin)) {
+                batch->waiting++;
+            }
+            continue;
+        }
+
+        if (forward(worker->pid, worker->endpoint, command_message(sub, resp::Protocol::RESP2), part_origin)) {
+            batch->waiting++;
         } else {
-            ServerNode *worker = nullptr;
-            std::string key = cmd::extract_key(msg);
-            if (key != "") {
-                worker = ring.get(key);
-                if (monitoring) {
-                    std::cout << key << " [" << hash_function(key)
-                        << "] in to Node [" << worker->hash << "] with pid " 
-                        << worker->pid  << std::endl;
+            resp::Writer { batch->replies[part], resp::Protocol::RESP2 }.error("FAILED");
+        }
+    }
+
+    batch->keys = std::move(keys);
+
+    // every part was served here, or no worker could be sent to
+    if (batch->waiting == 0) {
+        resp::merge_keys(batch->replies, batch->keys, batch->key_count, protocol, reply);
+        return true;
+    }
+
+    batch->origin = std::move(origin);
+    batch->origin.protocol = protocol;
+    return false;
+}
+
+bool ClientRequests::forward(const std::string &pid, const std::string &endpoint, const std::string &msg, Pending &origin) {
+    auto connected = worker_endpoints.find(pid);
+    if (connected == worker_endpoints.end() || connected->second != endpoint) {
+        if (connected != worker_endpoints.end()) {
+            worker_socket.disconnect(connected->second);
+        }
+
+        // named by pid so requests can be addressed to it as soon as it's connected
+        worker_socket.set(zmq::sockopt::connect_routing_id, pid);
+        worker_socket.connect(endpoint);
+        worker_endpoints[pid] = endpoint;
+    }
+
+    uint64_t id = next_request_id++;
+
+    // the worker's REP socket sends back every frame before the empty one, so the reply carries the id
+    try {
+        worker_socket.send(zmq::buffer(pid), zmq::send_flags::sndmore);
+        worker_socket.send(zmq::buffer(&id, sizeof(id)), zmq::send_flags::sndmore);
+        worker_socket.send(zmq::message_t(), zmq::send_flags::sndmore);
+        worker_socket.send(zmq::buffer(msg), zmq::send_flags::none);
+    } catch (...) {
+        return false;
+    }
+
+    origin.deadline = time_ms() + FORWARD_TIMEOUT_MS;
+    pending.emplace(id, std::move(origin));
+    pending_order.push_back(id);
+    return true;
+}
+
+bool ClientRequests::serve_batch(std::string_view msg, std::vector<zmq::message_t> &&envelope) {
+    // the requests may outlive the client's message if the batch has to wait, so they view a copy
+    auto batch = std::make_shared<Batch>();
+    batch->msg = msg;
+    msg = batch->msg;
+
+    while (!msg.empty()) {
+        size_t consumed;
+        Tokens &tokens = batch->requests.emplace_back();
+        if (resp::parse_request(msg, tokens, consumed) != resp::Status::Complete) {
+            return false;
+        }
+        msg.remove_prefix(consumed);
+
+        // blank lines between inline requests are skipped
+        if (tokens.empty()) {
+            batch->requests.pop_back();
+        }
+    }
+
+    batch->origin.envelope = std::move(envelope);
+    batch->origin.protocol = resp::Protocol::RESP2;
+    batch->replies.resize(batch->requests.size());
+    continue_batch(std::move(batch));
+    return true;
+}
+
+void ClientRequests::continue_batch(std::shared_ptr<Batch> batch) {
+    // requests for keys on other nodes, grouped into one BATCH message per worker
+    struct SubBatch {
+        std::string endpoint;
+        std::string msg;
+        std::vector<size_t> indexes;
+    };
+    std::unordered_map<std::string, SubBatch> sub_batches;
+
+    // sends the requests grouped so far
+    auto send_sub_batches = [&]() {
+        for (auto &[pid, sub] : sub_batches) {
+            Pending origin;
+            origin.batch = batch;
+            origin.indexes = std::move(sub.indexes);
+            origin.protocol = resp::Protocol::RESP2;
+
+            if (pid == leader_pid) {
+                submit(sub.msg, origin);
+                batch->waiting++;
+            } else if (forward(pid, sub.endpoint, sub.msg, origin)) {
+                batch->waiting++;
+            } else {
+                for (size_t i : origin.indexes) {
+                    resp::Writer { batch->replies[i], resp::Protocol::RESP2 }.error("FAILED");
                 }
             }
+        }
+        sub_batches.clear();
+    };
+
+    for (; batch->served < batch->requests.size(); batch->served++) {
+        size_t i = batch->served;
+        const Tokens &tokens = batch->requests[i];
+        const cmd::Spec *spec = cmd::lookup(tokens.name());
+        cmd::Routing routing = spec ? spec->routing : cmd::Routing::Local;
+        std::shared_ptr<ServerNode> worker;
+        if (routing == cmd::Routing::Key && !tokens.key().empty()) {
+            worker = ring.get(tokens.key());
+        }
 
-            if (worker && worker->pid != leader_pid) {
-                //request goes to another worker
-                worker->send(COMMAND + msg);
-                if (worker->recv(request)) {
-                    reply = request.to_string();
-                } else {
-                    reply = "FAILED";
-                }
-            } else { 
-                //request can be fuffiled by leader
-                Command cmd { request.to_string() };
-                reply = cmd.parse_cmd();
+        // with shards, the leader's own keys are one more sub-batch
+        if (worker && (worker->pid != leader_pid || shards)) {
+            SubBatch &sub = sub_batches[worker->pid];
+            if (sub.msg.empty()) {
+                sub.endpoint = worker->endpoint;
+                sub.msg += BATCH;
+                sub.msg += static_cast<char>(resp::Protocol::RESP2);
+            }
+            resp::write_request(tokens, sub.msg);
+            sub.indexes.push_back(i);
+            continue;
+        }
+
+        // the requests before this one are sent first. multi-key commands such as DEL and MGET follow
+        // them to each node over the same connections. commands that ask every node or run here go
+        // over others, and could be run before them, so they wait for them to be replied to
+        if (routing != cmd::Routing::Key) {
+            send_sub_batches();
+            if (routing != cmd::Routing::Keys && routing != cmd::Routing::Pairs && batch->waiting > 0) {
+                return;
+            }
+        }
+
+        // each request in a message is replied to in RESP2, as a message of its own would be.
+        // if the ring changed since, the request is forwarded alone
+        resp::Protocol protocol = resp::Protocol::RESP2;
+        Pending origin;
+        origin.batch = batch;
+        origin.indexes = { i };
+        if (!serve_request(tokens, protocol, batch->replies[i], origin)) {
+            batch->waiting++;
+        }
+    }
+
+    send_sub_batches();
+
+    // every request was served here
+    if (batch->waiting == 0) {
+        send_batch(*batch);
+    }
+}
+
+void ClientRequests::complete_batch(Pending &origin, std::string_view replies) {
+    Batch &batch = *origin.batch;
+
+    for (size_t i : origin.indexes) {
+        size_t consumed;
+        if (resp::parse_reply(replies, consumed) == resp::Status::Complete) {
+            batch.replies[i] = replies.substr(0, consumed);
+            replies.remove_prefix(consumed);
+        } else {
+            // the worker failed or timed out before replying to this one
+            batch.replies[i].clear();
+            resp::Writer { batch.replies[i], resp::Protocol::RESP2 }.error("FAILED");
+        }
+    }
+
+    if (--batch.waiting == 0) {
+        if (batch.served < batch.requests.size()) {
+            continue_batch(origin.batch);
+        } else {
+            send_batch(batch);
+        }
+    }
+}
+
+void ClientRequests::send_batch(Batch &batch) {
+    std::string out;
+    if (batch.keys.empty()) {
+        for (const std::string &reply : batch.replies) {
+            out += reply;
+        }
+    } else {
+        resp::merge_keys(batch.replies, batch.keys, batch.key_count, batch.origin.protocol, out);
+    }
+
+    zmq::message_t reply(out.data(), out.size());
+    send_reply(batch.origin, reply);
+}
+
+void ClientRequests::send_reply(Pending &origin, zmq::message_t &reply) {
+    if (origin.batch) {
+        complete_batch(origin, reply.to_string_view());
+        return;
+    }
+
+    if (origin.envelope.empty()) {
+        tcp_server.complete(origin.ticket, reply.to_string_view());
+        return;
+    }
+
+    for (zmq::message_t &frame : origin.envelope) {
+        client_socket.send(frame, zmq::send_flags::sndmore);
+    }
+    client_socket.send(reply, zmq::send_flags::none);
+}
+
+void ClientRequests::serve_clients() {
+    while (client_socket.get(zmq::sockopt::events) & ZMQ_POLLIN) {
+        // routing frames, the empty delimiter, then the request
+        Pending origin;
+        zmq::message_t request;
+        while (true) {
+            if (!client_socket.recv(request, zmq::recv_flags::dontwait)) {
+                return;
+            }
+
+            if (!request.more()) {
+                break;
+            }
+
+            origin.envelope.push_back(std::move(request));
+            request = zmq::message_t();
+        }
+
+        if (origin.envelope.empty()) {
+            continue;
+        }
+
+        // parsed once, as views into request, for both routing and running the command
+        Tokens tokens;
+        resp::Protocol protocol;
+        std::string out;
+        if (!resp::parse_message(request.to_string_view(), tokens, protocol)) {
+            // more than one request is a batch
+            if (serve_batch(request.to_string_view(), std::move(origin.envelope))) {
+                continue;
+            }
+            out = "-ERR Protocol error\r\n";
+        } else if (!serve_request(tokens, protocol, out, origin)) {
+            continue;
+        }
+
+        zmq::message_t reply(out.data(), out.size());
+        send_reply(origin, reply);
+    }
+}
+
+void ClientRequests::serve_worker_replies() {
+    while (worker_socket.get(zmq::sockopt::events) & ZMQ_POLLIN) {
+        // pid, request id, the empty delimiter, then the reply
+        std::vector<zmq::message_t> frames;
+        do {
+            frames.emplace_back();
+            if (!worker_socket.recv(frames.back(), zmq::recv_flags::dontwait)) {
+                return;
             }
+        } while (frames.back().more());
+
+        uint64_t id;
+        if (frames.size() != 4 || frames[1].size() != sizeof(id)) {
+            continue;
+        }
+        std::memcpy(&id, frames[1].data(), sizeof(id));
+
+        // requests that timed out were already answered
+        auto it = pending.find(id);
+        if (it == pending.end()) {
+            continue;
+        }
+
+        // answering can serve more requests and add to pending, so take this one out first
+        Pending origin = std::move(it->second);
+        pending.erase(it);
+        send_reply(origin, frames[3]);
+    }
+}
+
+void ClientRequests::expire_pending() {
+    milliseconds::rep now = time_ms();
+
+    while (!pending_order.empty()) {
+        auto it = pending.find(pending_order.front());
+        if (it != pending.end() && it->second.deadline > now) {
+            return;
+        }
+
+        pending_order.pop_front();
+        if (it == pending.end()) {
+            continue;
+        }
+
+        // as in serve_worker_replies, take the request out before answering it
+        Pending origin = std::move(it->second);
+        pending.erase(it);
+
+        std::string failed;
+        resp::Writer { failed, origin.protocol }.error("FAILED");
+        zmq::message_t reply(failed.data(), failed.size());
+        send_reply(origin, reply);
+    }
+}
+
+void ClientRequests::disconnect_old_workers() {
+    for (auto it = worker_endpoints.begin(); it != worker_endpoints.end();) {
+        if (!ring.get_by_pid(it->first)) {
+            worker_socket.disconnect(it->second);
+            it = worker_endpoints.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ClientRequests::run() {
+    client_socket.bind("tcp://*:" + std::to_string(client_port));
+
+    std::cout << "Started leader node with pid " << leader_pid << " on " 
+        << client_socket.get(zmq::sockopt::last_endpoint)
+        << std::endl;
+
+    if (tcp_port >= 0) {
+        if (!tcp_server.listen(tcp_port)) {
+            std::perror("Could not listen for TCP clients");
+            exit(EXIT_FAILURE);
+        }
+
+        std::cout << "Listening for TCP clients on port " << tcp_server.get_port() << std::endl;
+    }
+
+    // ZMQ signals its fds when the sockets' events change rather than per message,
+    // so they are drained after every poll too
+    tcp_server.watch(client_socket.get(zmq::sockopt::fd), [this]() { serve_clients(); });
+    tcp_server.watch(worker_socket.get(zmq::sockopt::fd), [this]() { serve_worker_replies(); });
+    if (shards) {
+        tcp_server.watch(shards->fd(), [this]() { shards->collect(); });
+    }
+
+    while (true) {
+        tcp_server.poll(ACTIVE_EXPIRE_INTERVAL_MS);
+
+        // sending on a socket can take the signal meant for a message it received,
+        // so both are drained until neither has anything left
+        do {
+            serve_worker_replies();
+            serve_clients();
+        } while ((worker_socket.get(zmq::sockopt::events) & ZMQ_POLLIN) ||
+            (client_socket.get(zmq::sockopt::events) & ZMQ_POLLIN));
+
+        expire_pending();
+        disconnect_old_workers();
+
+        // reclaim expired keys between requests. shards expire their own
+        if (!shards) {
+            cache.active_expire();
         }
-        
 
-        client_socket.send(zmq::buffer(reply), zmq::send_flags::none);
         if (stop) {
             std::cout << "Stopping leader node pid " << leader_pid << std::endl;
             exit(EXIT_SUCCESS);
         }
     }
-}
\ No newline at end of file
+}
+
+void handle_client_requests(ClientRequests &clients) {
+    clients.run();
+}
@@ -1,122 +1,157 @@
 #include <list>
 #include <iostream>
 
-#include "entries/base_entry.hpp"
 #include "lru_cache.hpp"
+#include "quick_list.hpp"
 #include "globals.hpp"
 #include "consistent-hashing.hpp"
+#include "resp.hpp"
 
 
-LRUCache::LRUCache(long inital_size, long max_map_size): max_size(max_map_size) {
+LRUCache::LRUCache(long inital_size, long max_map_size, long max_map_memory): policy(std::make_unique<LRUPolicy>()), max_size(max_map_size), max_memory(max_map_memory) {
     if (max_map_size > keyMap.max_size()) {
         max_size = keyMap.max_size();
     }
     keyMap.reserve(inital_size);
 }
 
-LRUCache::LRUCache(const std::string &import_str, long inital_size, long max_map_size): LRUCache(inital_size, max_map_size) {
+LRUCache::LRUCache(const std::string &import_str, long inital_size, long max_map_size, long max_map_memory): LRUCache(inital_size, max_map_size, max_map_memory) {
     import(import_str);
 }
 
+size_t LRUCache::entry_memory(CacheEntry *entry) {
+    return entry->memory_usage() + KeyIndex::slot_memory();
+}
 
+void LRUCache::delete_entry(CacheEntry *entry) {
+    keyMap.erase(entry->key);
+    policy->remove(entry);
+    expirations.remove(entry);
+    used_memory -= entry->memory;
 
-CacheEntry *LRUCache::get_cache_entry(const std::string& key) {
-    auto it = keyMap.find(key);
+    delete entry;
+}
 
-    if (it == keyMap.end()) {
-        return nullptr;
+void LRUCache::evict_to_fit(CacheEntry *keep) {
+    if (max_memory <= 0) {
+        return;
     }
 
-    Node *node = it->second;
+    while (used_memory > max_memory) {
+        CacheEntry *victim = policy->victim(keyMap, keep);
+        if (!victim) {
+            return;
+        }
 
-    //bring node to front of list
-    BaseEntry *entry = entries.remove_node(node);
-    it->second = entries.add_end(entry);
-    
-    if (entry->get_type() == EntryType::cache) {
-        CacheEntry *cache_entry = dynamic_cast<CacheEntry*>(entry);
+        delete_entry(victim);
+    }
+}
 
-        if (cache_entry->expired()) {
-            delete entries.remove_node(it->second);
-            keyMap.erase(it);
+void LRUCache::update_memory(CacheEntry *entry) {
+    size_t memory = entry_memory(entry);
+    used_memory += (long) memory - (long) entry->memory;
+    entry->memory = memory;
 
-            return nullptr;
-        } else {
-            return cache_entry;
-        }
+    evict_to_fit(entry);
+}
+
+long LRUCache::memory_usage(std::string_view key) {
+    CacheEntry *entry = get_cache_entry(key);
+    if (!entry) {
+        return -1;
     }
 
-    return nullptr;
+    return entry->memory;
 }
 
-void LRUCache::add(const std::string& key, BaseEntry *value) {
+
+CacheEntry *LRUCache::get_cache_entry(std::string_view key) {
+    CacheEntry *entry = keyMap.find(key);
+
+    if (!entry) {
+        policy->miss(key);
+        return nullptr;
+    }
+
+    if (entry->expired()) {
+        delete_entry(entry);
+        count_expired(1);
+        policy->miss(key);
+        return nullptr;
+    }
+
+    policy->access(entry);
+    return entry;
+}
+
+CacheEntry *LRUCache::add(std::string_view key, Value &&value) {
     CacheEntry *existing = get_cache_entry(key);
 
     if (existing) {
-        if (existing->get_type() == EntryType::cache) {
-            delete existing->cached;
-            existing->cached = value;
-        }
-        return;
+        existing->value = std::move(value);
+        update_memory(existing);
+        return existing;
     }
 
     if (size() >= max_size) {
-        BaseEntry *lru = entries.remove_front();
-
-        if (lru->get_type() == EntryType::cache) {
-            CacheEntry *old_entry = dynamic_cast<CacheEntry*>(lru);
-            keyMap.erase(old_entry->key);
+        CacheEntry *victim = policy->victim(keyMap, nullptr);
+        if (victim) {
+            delete_entry(victim);
         }
-
-        delete lru;
     }
 
-    CacheEntry *entry = new CacheEntry(key, value);
-    Node *node = entries.add_end(entry);
-    keyMap.insert({key, node});
+    CacheEntry *entry = new CacheEntry(key, std::move(value));
+    policy->insert(entry);
+    keyMap.insert(entry);
+    update_memory(entry);
+
+    return entry;
 }
 
-BaseEntry *LRUCache::get(const std::string& key) {
+Value *LRUCache::get(std::string_view key) {
     CacheEntry *cache_entry = get_cache_entry(key);
 
     if (cache_entry) {
-        return cache_entry->cached;
+        return &cache_entry->value;
     } else {
         return nullptr;
     }
 }
 
-BaseEntry *LRUCache::remove(const std::string& key) {
-    auto it = keyMap.find(key);
+Value LRUCache::remove(std::string_view key) {
+    CacheEntry *cache_entry = keyMap.find(key);
 
-    if (it == keyMap.end()) {
-        return nullptr;
+    if (!cache_entry) {
+        return Value();
     }
     
-    Node *node = it->second;
-    keyMap.erase(it);
+    // ownership of the value goes to the caller
+    Value value = std::move(cache_entry->value);
 
-    BaseEntry *entry = entries.remove_node(node);
-    if (entry->get_type() == EntryType::cache) {
-        CacheEntry *cache_entry = dynamic_cast<CacheEntry*>(entry);
-        BaseEntry *value = cache_entry->cached;
+    delete_entry(cache_entry);
+    return value;
+}
 
-        delete cache_entry;
-        return value;
+std::vector<std::string> LRUCache::key_set(bool single_str) {
+    return policy->keys(single_str);
+}
+
+void LRUCache::set_eviction(std::unique_ptr<EvictionPolicy> new_policy) {
+    if (!new_policy) {
+        return;
     }
 
-    return nullptr;
-}
+    new_policy->reserve(max_size);
 
-std::vector<std::string> LRUCache::key_set(bool single_str) {
-    if (single_str) {
-        return entries.values(0, -1, false, true);    
-    } else {
-        return entries.values();
+    for (auto it = keyMap.begin(); it != keyMap.end(); ++it) {
+        policy->remove(it->value);
+        new_policy->insert(it->value);
     }
+
+    policy = std::move(new_policy);
 }
 
-bool LRUCache::set_expire(const std::string& key, std::time_t time) {
+bool LRUCache::set_expire(std::string_view key, std::time_t time) {
     CacheEntry *cache_entry = get_cache_entry(key);
     if (cache_entry) {
         if (time == 0 && cache_entry->expiration == 0) {
@@ -125,81 +160,180 @@ bool LRUCache::set_expire(const std::string& key, std::time_t time) {
         }
 
         cache_entry->expiration = time;
+        expirations.add(cache_entry);
         return true;
     }
 
     return false;
 }
 
+void LRUCache::use_thread_pools() {
+    if (!CacheEntry::thread_pool()) {
+        CacheEntry::thread_pool() = new SlabPool("entries", sizeof(CacheEntry), alignof(CacheEntry));
+    }
+    QuickList::use_thread_pools();
+}
+
+void LRUCache::release_thread_pools() {
+    delete CacheEntry::thread_pool();
+    CacheEntry::thread_pool() = nullptr;
+    QuickList::release_thread_pools();
+}
+
 void LRUCache::clear() {
-    entries.clear();
+    if (!policy) {
+        // moved from
+        return;
+    }
+
+    SlabPool &pool = CacheEntry::pool();
+    if (pool.get_in_use() == keyMap.size()) {
+        // every pooled entry belongs to this cache, so the entries can be destroyed in the order
+        // they sit in memory and the slabs dropped whole, instead of freeing each one
+        pool.for_each_in_use([](void *entry) {
+            static_cast<CacheEntry*>(entry)->~CacheEntry();
+        });
+
+        policy->release();
+        pool.release();
+    } else {
+        policy->clear();
+    }
+
     keyMap.clear();
+    expirations.clear();
+    used_memory = 0;
+
+    // lists owned by the values are gone too, so their pools may be empty now
+    if (QuickList::chunk_pool().get_in_use() == 0) {
+        QuickList::chunk_pool().release();
+    }
+    if (QuickList::pool().get_in_use() == 0) {
+        QuickList::pool().release();
+    }
+}
+
+void LRUCache::count_expired(long num) {
+    if (num == 0) {
+        return;
+    }
+
+    expired_total += num;
+
+    seconds::rep now = time_secs();
+    int i = now % EXPIRE_STATS_WINDOW;
+    if (expired_window_secs[i] != now) {
+        expired_window_secs[i] = now;
+        expired_window[i] = 0;
+    }
+
+    expired_window[i] += num;
+}
+
+double LRUCache::expired_per_sec() {
+    seconds::rep now = time_secs();
+    long sum = 0;
+
+    for (int i = 0; i < EXPIRE_STATS_WINDOW; i++) {
+        if (now - expired_window_secs[i] < EXPIRE_STATS_WINDOW) {
+            sum += expired_window[i];
+        }
+    }
+
+    return (double) sum / EXPIRE_STATS_WINDOW;
+}
+
+long LRUCache::active_expire(long max_us) {
+    // work done between clock checks. reading the clock on every key would cost more than deleting it
+    const long step = 64;
+
+    seconds::rep now = time_secs();
+    steady_clock::time_point start = steady_clock::now();
+    long expired = 0;
+
+    while (true) {
+        long work = 0;
+        bool done = false;
+
+        while (work < step) {
+            CacheEntry *entry = expirations.pop_expired(now, work, step);
+            if (!entry) {
+                done = work < step;
+                break;
+            }
+
+            delete_entry(entry);
+            expired++;
+        }
+
+        if (done || duration_cast<microseconds>(steady_clock::now() - start).count() >= max_us) {
+            break;
+        }
+    }
+
+    count_expired(expired);
+    return expired;
 }
 
-bool in_range(int val, int low, int high) {
-    if (high < low) { //wrap around
+bool in_range(uint64_t val, uint64_t low, uint64_t high) {
+    if (high <= low) { //wrap around
         return low <= val || val < high; 
     } else {
         return low <= val && val < high;
     }
 }
 
-std::vector<std::string> LRUCache::extract(std::vector<int> upper_bounds) {
+std::vector<std::string> LRUCache::extract(const std::vector<uint64_t> &upper_bounds) {
     if (upper_bounds.size() < 2) {
         return {};
     }
 
-    std::vector<std::stringstream *> import_strs;
-    int n = upper_bounds.size();
-    for (int i = 0; i < n - 1; i++) {
-        import_strs.emplace_back( new std::stringstream() );
-    }
-
-    for (auto it = keyMap.begin(); it != keyMap.end(); it++) {
-        std::string key = it->first;
-        int hash = hash_function(key);
+    return extract(by_ranges(upper_bounds), upper_bounds.size() - 1);
+}
 
-        for (int i = 0; i < n - 1; i++) {
+LRUCache::Group LRUCache::by_ranges(const std::vector<uint64_t> &upper_bounds) {
+    return [upper_bounds](uint64_t hash) {
+        for (size_t i = 0; i + 1 < upper_bounds.size(); i++) {
             if (in_range(hash, upper_bounds[i], upper_bounds[i + 1])) {
-                // add this key/value to the string
-                BaseEntry *entry = it->second->value;
-                if (entry->get_type() == EntryType::cache) {
-                    std::stringstream *ss = import_strs[i];
-                    
-                    CacheEntry *cache_entry = dynamic_cast<CacheEntry*>(entry);
-                    *ss << key << "\n" << cache_entry->cached->to_string() << "\n";
-                }
-
-                //move node for LRU deletion
-                Node *node = it->second;
-                it->second = entries.add_front(entries.remove_node(node));
-                break;
+                return static_cast<int>(i);
             }
         }
+        return -1;
+    };
+}
 
-    }
-   
-    std::vector<std::string> strs;
-    for (auto &ss : import_strs) {
-        std::string str = ss->str();
-        strs.emplace_back(str);
-        
-        delete ss;
+std::vector<std::string> LRUCache::extract(const Group &group, size_t groups) {
+    std::vector<std::string> import_strs(groups);
+
+    for (auto it = keyMap.begin(); it != keyMap.end(); ++it) {
+        CacheEntry *cache_entry = it->value;
+        const std::string &key = cache_entry->key;
+        int i = group(hash_function(key));
+
+        if (i >= 0 && static_cast<size_t>(i) < groups) {
+            // add this key/value to the string
+            resp::write_entry(key, cache_entry->value, import_strs[i]);
+
+            //move entry for LRU deletion
+            policy->demote(cache_entry);
+        }
     }
 
-    return strs;
+    return import_strs;
 }
 
-bool LRUCache::import(const std::string& import_str) {
-    std::istringstream iss(import_str);
+bool LRUCache::import(std::string_view import_str) {
+    resp::Reader reader { import_str };
 
-    for (std::string key; std::getline(iss, key); ) {
-        std::string value;
-        if (std::getline(iss, value)) {
-            add(key, str_to_base_entry(value));
-        } else {
+    while (!reader.done()) {
+        size_t size;
+        std::string_view key;
+        Value value;
+        if (!reader.read_array(size) || size != 2 || !reader.read_bulk(key) || !reader.read_value(value)) {
             return false;
         }
+
+        add(key, std::move(value));
     }
 
     return true;
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cmath>
+
+#include "placement.hpp"
+#include "consistent-hashing.hpp"
+#include "wyhash.hpp"
+
+bool parse_placement(std::string_view name, PlacementType &type) {
+    if (name == "ring") {
+        type = PlacementType::Ring;
+    } else if (name == "jump") {
+        type = PlacementType::Jump;
+    } else if (name == "rendezvous") {
+        type = PlacementType::Rendezvous;
+    } else if (name == "bounded") {
+        type = PlacementType::Bounded;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+const char *placement_name(PlacementType type) {
+    switch (type) {
+        case PlacementType::Jump:
+            return "jump";
+        case PlacementType::Rendezvous:
+            return "rendezvous";
+        case PlacementType::Bounded:
+            return "bounded";
+        default:
+            return "ring";
+    }
+}
+
+std::unique_ptr<Placement> Placement::make(PlacementType type, const std::vector<Node> &nodes) {
+    switch (type) {
+        case PlacementType::Jump:
+            return std::make_unique<JumpPlacement>(nodes);
+        case PlacementType::Rendezvous:
+            return std::make_unique<RendezvousPlacement>(nodes);
+        case PlacementType::Bounded:
+            return std::make_unique<BoundedPlacement>(nodes);
+        default:
+            return std::make_unique<RingPlacement>(nodes);
+    }
+}
+
+
+RingPlacement::RingPlacement(const std::vector<Node> &nodes) {
+    for (size_t i = 0; i < nodes.size(); i++) {
+        for (int j = 0; j < std::max(nodes[i].vnodes, 1) * std::max(nodes[i].weight, 1); j++) {
+            points.push_back({ vnode_hash(nodes[i].pid, nodes[i].endpoint, j), j, i });
+        }
+    }
+
+    // by hash, then pid, so every node agrees on the order of points that collide
+    std::sort(points.begin(), points.end(), [&nodes](const Point &a, const Point &b) {
+        if (a.hash != b.hash) {
+            return a.hash < b.hash;
+        }
+        if (nodes[a.node].pid != nodes[b.node].pid) {
+            return nodes[a.node].pid < nodes[b.node].pid;
+        }
+        return a.index < b.index;
+    });
+}
+
+size_t RingPlacement::point_of(uint64_t hash) const {
+    // the point at or before the hash, wrapping around to the last
+    auto it = std::lower_bound(points.begin(), points.end(), hash, [](const Point &point, uint64_t hash) {
+        return point.hash < hash;
+    });
+
+    if (it == points.end() || (it->hash != hash && it == points.begin())) {
+        return points.size() - 1;
+    } else if (it->hash == hash) {
+        return it - points.begin();
+    }
+
+    return it - points.begin() - 1;
+}
+
+size_t RingPlacement::get(uint64_t hash) const {
+    return points[point_of(hash)].node;
+}
+
+
+JumpPlacement::JumpPlacement(const std::vector<Node> &nodes) {
+    std::vector<size_t> order;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        order.push_back(i);
+    }
+
+    std::sort(order.begin(), order.end(), [&nodes](size_t a, size_t b) {
+        return pid_greater(nodes[b].pid, nodes[a].pid);
+    });
+
+    for (size_t i : order) {
+        buckets.insert(buckets.end(), std::max(nodes[i].weight, 1), i);
+    }
+}
+
+size_t JumpPlacement::get(uint64_t hash) const {
+    int64_t b = -1;
+    int64_t j = 0;
+    int64_t n = buckets.size();
+
+    while (j < n) {
+        b = j;
+        hash = hash * 2862933555777941757ULL + 1;
+        j = (b + 1) * (static_cast<double>(1LL << 31) / static_cast<double>((hash >> 33) + 1));
+    }
+
+    return buckets[b];
+}
+
+
+RendezvousPlacement::RendezvousPlacement(const std::vector<Node> &nodes) {
+    for (const Node &node : nodes) {
+        seeds.push_back(hash_function(node.pid + node.endpoint));
+        weights.push_back(std::max(node.weight, 1));
+    }
+}
+
+size_t RendezvousPlacement::get(uint64_t hash) const {
+    size_t best = 0;
+    double best_score = 0;
+
+    for (size_t i = 0; i < seeds.size(); i++) {
+        // the top 53 bits as a double in (0, 1), so the log is negative and finite
+        double u = ((wyhash::mix(hash ^ seeds[i], wyhash::secret[0]) >> 11) + 0.5) * 0x1p-53;
+        double score = weights[i] / -std::log(u);
+        // ties go to the greater seed, so the order of nodes doesn't matter
+        if (i == 0 || score > best_score || (score == best_score && seeds[i] > seeds[best])) {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    return best;
+}
+
+
+BoundedPlacement::BoundedPlacement(const std::vector<Node> &nodes) : RingPlacement(nodes) {
+    size_t count = size_t { 1 } << BOUNDED_SLOT_BITS;
+    double total = 0;
+    for (const Node &node : nodes) {
+        total += std::max(node.weight, 1);
+    }
+
+    std::vector<size_t> caps;
+    for (const Node &node : nodes) {
+        caps.push_back(std::ceil((1 + BOUNDED_LOAD_EPSILON) * count * std::max(node.weight, 1) / total));
+    }
+    std::vector<size_t> loads(nodes.size(), 0);
+
+    // the caps add up to at least the slots, so a node with room is always found
+    slots.resize(count);
+    for (size_t slot = 0; slot < count; slot++) {
+        size_t point = point_of(static_cast<uint64_t>(slot) << (64 - BOUNDED_SLOT_BITS));
+        while (loads[points[point].node] >= caps[points[point].node]) {
+            point = (point + 1) % points.size();
+        }
+
+        slots[slot] = points[point].node;
+        loads[points[point].node]++;
+    }
+}
+
+size_t BoundedPlacement::get(uint64_t hash) const {
+    return slots[hash >> (64 - BOUNDED_SLOT_BITS)];
+}
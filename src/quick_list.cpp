@@ -0,0 +1,403 @@
+#include <cstring>
+
+#include "quick_list.hpp"
+
+// high nibble of an element's tag byte. ints keep their width in the low nibble
+constexpr uint8_t TAG_INT = 0x10;
+constexpr uint8_t TAG_STR = 0x20;
+constexpr uint8_t TAG_HEAP_STR = 0x30;
+
+struct HeapString {
+    char *data;
+    size_t size;
+};
+
+static size_t int_width(int64_t num) {
+    if (num >= INT8_MIN && num <= INT8_MAX) {
+        return 1;
+    } else if (num >= INT16_MIN && num <= INT16_MAX) {
+        return 2;
+    } else if (num >= INT32_MIN && num <= INT32_MAX) {
+        return 4;
+    }
+
+    return 8;
+}
+
+static int64_t read_int(const char *src, size_t width) {
+    switch (width) {
+        case 1: { int8_t num; std::memcpy(&num, src, 1); return num; }
+        case 2: { int16_t num; std::memcpy(&num, src, 2); return num; }
+        case 4: { int32_t num; std::memcpy(&num, src, 4); return num; }
+        default: { int64_t num; std::memcpy(&num, src, 8); return num; }
+    }
+}
+
+static void write_int(int64_t num, char *dest, size_t width) {
+    switch (width) {
+        case 1: { int8_t n = num; std::memcpy(dest, &n, 1); break; }
+        case 2: { int16_t n = num; std::memcpy(dest, &n, 2); break; }
+        case 4: { int32_t n = num; std::memcpy(dest, &n, 4); break; }
+        default: std::memcpy(dest, &num, 8);
+    }
+}
+
+void QuickList::use_thread_pools() {
+    if (!thread_pool()) {
+        thread_pool() = new SlabPool("lists", sizeof(QuickList), alignof(QuickList));
+        Chunk::thread_pool() = new SlabPool("chunks", sizeof(Chunk), alignof(Chunk));
+    }
+}
+
+void QuickList::release_thread_pools() {
+    delete thread_pool();
+    thread_pool() = nullptr;
+    delete Chunk::thread_pool();
+    Chunk::thread_pool() = nullptr;
+}
+
+size_t QuickList::encoded_size(const Value &value) {
+    if (value.is_int()) {
+        return 2 + int_width(value.integer());
+    } else if (value.str().size() <= QUICKLIST_INLINE_MAX) {
+        return 3 + value.str().size();
+    }
+
+    return 2 + sizeof(HeapString);
+}
+
+void QuickList::encode(const Value &value, char *dest, size_t size) {
+    if (value.is_int()) {
+        size_t width = size - 2;
+        dest[0] = TAG_INT | width;
+        write_int(value.integer(), dest + 1, width);
+    } else if (value.str().size() <= QUICKLIST_INLINE_MAX) {
+        std::string_view str = value.str();
+        dest[0] = TAG_STR;
+        dest[1] = str.size();
+        std::memcpy(dest + 2, str.data(), str.size());
+    } else {
+        std::string_view str = value.str();
+        HeapString heap { new char[str.size()], str.size() };
+        std::memcpy(heap.data, str.data(), str.size());
+
+        dest[0] = TAG_HEAP_STR;
+        std::memcpy(dest + 1, &heap, sizeof(HeapString));
+    }
+
+    dest[size - 1] = size;
+}
+
+size_t QuickList::size_at(const char *src) {
+    uint8_t tag = src[0];
+
+    switch (tag & 0xF0) {
+        case TAG_INT: return 2 + (tag & 0x0F);
+        case TAG_STR: return 3 + static_cast<uint8_t>(src[1]);
+        default: return 2 + sizeof(HeapString);
+    }
+}
+
+Value QuickList::decode(const char *src) {
+    uint8_t tag = src[0];
+
+    switch (tag & 0xF0) {
+        case TAG_INT:
+            return Value(read_int(src + 1, tag & 0x0F));
+        case TAG_STR:
+            return Value(std::string_view(src + 2, static_cast<uint8_t>(src[1])));
+        default: {
+            HeapString heap;
+            std::memcpy(&heap, src + 1, sizeof(HeapString));
+            return Value(std::string_view(heap.data, heap.size));
+        }
+    }
+}
+
+void QuickList::append_string(const char *src, std::string &out) {
+    uint8_t tag = src[0];
+
+    switch (tag & 0xF0) {
+        case TAG_INT:
+            out += std::to_string(read_int(src + 1, tag & 0x0F));
+            break;
+        case TAG_STR:
+            out.append(src + 2, static_cast<uint8_t>(src[1]));
+            break;
+        default: {
+            HeapString heap;
+            std::memcpy(&heap, src + 1, sizeof(HeapString));
+            out.append(heap.data, heap.size);
+        }
+    }
+}
+
+void QuickList::free_element(const char *src) {
+    if ((static_cast<uint8_t>(src[0]) & 0xF0) != TAG_HEAP_STR) {
+        return;
+    }
+
+    HeapString heap;
+    std::memcpy(&heap, src + 1, sizeof(HeapString));
+    heap_bytes -= heap.size;
+    delete[] heap.data;
+}
+
+Value QuickList::flatten(Value &&value) {
+    if (value.is_list()) {
+        return Value(value.to_string());
+    }
+
+    return std::move(value);
+}
+
+QuickList::Chunk *QuickList::new_chunk(Chunk *prev, Chunk *next) {
+    Chunk *chunk = new Chunk();
+    chunk->prev = prev;
+    chunk->next = next;
+
+    if (prev) {
+        prev->next = chunk;
+    } else {
+        head = chunk;
+    }
+
+    if (next) {
+        next->prev = chunk;
+    } else {
+        tail = chunk;
+    }
+
+    chunks++;
+    return chunk;
+}
+
+void QuickList::delete_chunk(Chunk *chunk) {
+    if (chunk->prev) {
+        chunk->prev->next = chunk->next;
+    } else {
+        head = chunk->next;
+    }
+
+    if (chunk->next) {
+        chunk->next->prev = chunk->prev;
+    } else {
+        tail = chunk->prev;
+    }
+
+    chunks--;
+    delete chunk;
+}
+
+QuickList::Cursor QuickList::find(int i) {
+    Chunk *chunk;
+    int first; // index of the chunk's first element
+
+    // skip whole chunks from whichever end is closer
+    if (i < size / 2) {
+        chunk = head;
+        first = 0;
+        while (i >= first + chunk->count) {
+            first += chunk->count;
+            chunk = chunk->next;
+        }
+    } else {
+        chunk = tail;
+        first = size - chunk->count;
+        while (i < first) {
+            chunk = chunk->prev;
+            first -= chunk->count;
+        }
+    }
+
+    size_t offset = 0;
+    for (int j = first; j < i; j++) {
+        offset += size_at(chunk->data + offset);
+    }
+
+    return { chunk, offset };
+}
+
+Value QuickList::remove_at(Cursor cursor) {
+    Chunk *chunk = cursor.chunk;
+    char *src = chunk->data + cursor.offset;
+    size_t element = size_at(src);
+
+    Value value = decode(src);
+    free_element(src);
+
+    std::memmove(src, src + element, chunk->bytes - cursor.offset - element);
+    chunk->bytes -= element;
+    chunk->count--;
+    size--;
+
+    if (chunk->count == 0) {
+        delete_chunk(chunk);
+    }
+
+    return value;
+}
+
+Value QuickList::get(int i) {
+    if (i < 0 || i >= size) {
+        return Value();
+    }
+
+    Cursor cursor = find(i);
+    return decode(cursor.chunk->data + cursor.offset);
+}
+
+bool QuickList::add_end(Value &&value) {
+    Value flat = flatten(std::move(value));
+    if (flat.is_none()) {
+        return false;
+    }
+
+    size_t element = encoded_size(flat);
+    if (!tail || tail->bytes + element > sizeof(tail->data)) {
+        new_chunk(tail, nullptr);
+    }
+
+    encode(flat, tail->data + tail->bytes, element);
+    tail->bytes += element;
+    tail->count++;
+    size++;
+
+    if (flat.is_str() && flat.str().size() > QUICKLIST_INLINE_MAX) {
+        heap_bytes += flat.str().size();
+    }
+
+    return true;
+}
+
+bool QuickList::add_front(Value &&value) {
+    Value flat = flatten(std::move(value));
+    if (flat.is_none()) {
+        return false;
+    }
+
+    size_t element = encoded_size(flat);
+    if (!head || head->bytes + element > sizeof(head->data)) {
+        new_chunk(nullptr, head);
+    }
+
+    std::memmove(head->data + element, head->data, head->bytes);
+    encode(flat, head->data, element);
+    head->bytes += element;
+    head->count++;
+    size++;
+
+    if (flat.is_str() && flat.str().size() > QUICKLIST_INLINE_MAX) {
+        heap_bytes += flat.str().size();
+    }
+
+    return true;
+}
+
+Value QuickList::remove_end() {
+    if (size == 0) {
+        return Value();
+    }
+
+    size_t offset = tail->bytes - size_before(tail->data + tail->bytes);
+    return remove_at({ tail, offset });
+}
+
+Value QuickList::remove_front() {
+    if (size == 0) {
+        return Value();
+    }
+
+    return remove_at({ head, 0 });
+}
+
+Value QuickList::remove(int i) {
+    if (i < 0 || i >= size) {
+        return Value();
+    }
+
+    return remove_at(find(i));
+}
+
+std::vector<std::string> QuickList::values(int start, int stop, bool reverse, bool single_str) {
+    if (start < 0) {
+        start = 0;
+    }
+
+    if (stop < 0 || stop >= size) {
+        stop = size - 1;
+    }
+
+    std::string joined;
+    std::vector<std::string> vals;
+
+    if (start <= stop) {
+        if (!single_str) {
+            vals.reserve(stop - start + 1);
+        }
+
+        // reverse indexes count from the tail
+        Cursor cursor = find(reverse ? size - 1 - start : start);
+        Chunk *chunk = cursor.chunk;
+        size_t offset = cursor.offset;
+
+        for (int i = start; i <= stop; i++) {
+            if (single_str) {
+                if (i != start) {
+                    joined += ' ';
+                }
+                append_string(chunk->data + offset, joined);
+            } else {
+                vals.emplace_back();
+                append_string(chunk->data + offset, vals.back());
+            }
+
+            if (i == stop) {
+                break;
+            }
+
+            if (reverse) {
+                if (offset == 0) {
+                    chunk = chunk->prev;
+                    offset = chunk->bytes;
+                }
+                offset -= size_before(chunk->data + offset);
+            } else {
+                offset += size_at(chunk->data + offset);
+                if (offset == chunk->bytes) {
+                    chunk = chunk->next;
+                    offset = 0;
+                }
+            }
+        }
+    }
+
+    if (single_str) {
+        return { joined };
+    } else {
+        return vals;
+    }
+}
+
+void QuickList::clear() {
+    Chunk *chunk = head;
+
+    while (chunk) {
+        // only long strings own memory outside the chunk
+        if (heap_bytes > 0) {
+            for (size_t offset = 0; offset < chunk->bytes; offset += size_at(chunk->data + offset)) {
+                free_element(chunk->data + offset);
+            }
+        }
+
+        Chunk *next = chunk->next;
+        delete chunk;
+        chunk = next;
+    }
+
+    size = 0;
+    chunks = 0;
+    heap_bytes = 0;
+    head = nullptr;
+    tail = nullptr;
+}
@@ -0,0 +1,494 @@
+#include <charconv>
+#include <algorithm>
+
+#include "resp.hpp"
+#include "quick_list.hpp"
+
+namespace resp {
+    // parses a number ending in \r\n at buf[pos], moving pos past it
+    static Status parse_number(std::string_view buf, size_t &pos, int64_t &num) {
+        size_t end = buf.find('\r', pos);
+        if (end == std::string_view::npos || end + 1 >= buf.size()) {
+            // a number longer than 20 digits, or a line ended by \n alone, is malformed
+            bool malformed = buf.size() - pos > 21 || buf.find('\n', pos) != std::string_view::npos;
+            return malformed ? Status::Error : Status::Incomplete;
+        }
+
+        if (buf[end + 1] != '\n') {
+            return Status::Error;
+        }
+
+        auto [ptr, ec] = std::from_chars(buf.data() + pos, buf.data() + end, num);
+        if (ec != std::errc() || ptr != buf.data() + end) {
+            return Status::Error;
+        }
+
+        pos = end + 2;
+        return Status::Complete;
+    }
+
+    static Status parse_inline(std::string_view buf, Tokens &args, size_t &consumed) {
+        size_t end = buf.find('\n');
+        if (end == std::string_view::npos) {
+            return Status::Incomplete;
+        }
+
+        args = Tokens { buf.substr(0, end) };
+        consumed = end + 1;
+        return Status::Complete;
+    }
+
+    Status parse_request(std::string_view buf, Tokens &args, size_t &consumed) {
+        if (buf.empty()) {
+            return Status::Incomplete;
+        }
+
+        if (buf[0] != '*') {
+            return parse_inline(buf, args, consumed);
+        }
+
+        size_t pos = 1;
+        int64_t size;
+        Status status = parse_number(buf, pos, size);
+        if (status != Status::Complete) {
+            return status;
+        }
+
+        if (size < 0 || static_cast<size_t>(size) > MAX_ARRAY) {
+            return Status::Error;
+        }
+
+        args.clear();
+        for (int64_t i = 0; i < size; i++) {
+            if (pos >= buf.size()) {
+                return Status::Incomplete;
+            }
+
+            if (buf[pos] != '$') {
+                return Status::Error;
+            }
+
+            pos++;
+            int64_t len;
+            status = parse_number(buf, pos, len);
+            if (status != Status::Complete) {
+                return status;
+            }
+
+            if (len < 0 || static_cast<size_t>(len) > MAX_BULK) {
+                return Status::Error;
+            }
+
+            if (buf.size() - pos < static_cast<size_t>(len) + 2) {
+                return Status::Incomplete;
+            }
+
+            if (buf[pos + len] != '\r' || buf[pos + len + 1] != '\n') {
+                return Status::Error;
+            }
+
+            args.push(buf.substr(pos, len));
+            pos += len + 2;
+        }
+
+        consumed = pos;
+        return Status::Complete;
+    }
+
+    bool parse_message(std::string_view msg, Tokens &args, Protocol &protocol) {
+        if (msg.empty() || msg[0] != '*') {
+            args = Tokens { msg };
+            protocol = Protocol::Text;
+            return true;
+        }
+
+        size_t consumed;
+        protocol = Protocol::RESP2;
+        return parse_request(msg, args, consumed) == Status::Complete && consumed == msg.size();
+    }
+
+    void write_request(const Tokens &args, std::string &out) {
+        Writer writer { out, Protocol::RESP2 };
+        writer.array(args.size());
+        for (size_t i = 0; i < args.size(); i++) {
+            writer.bulk(args[i]);
+        }
+    }
+
+    Status parse_reply(std::string_view buf, size_t &consumed) {
+        size_t pos = 0;
+        // values left to find, counting elements of the aggregates found so far
+        int64_t remaining = 1;
+
+        while (remaining > 0) {
+            if (pos >= buf.size()) {
+                return Status::Incomplete;
+            }
+
+            char type = buf[pos++];
+            remaining--;
+
+            switch (type) {
+                case '+': case '-': case ':': case '_': case ',': case '#': {
+                    size_t end = buf.find("\r\n", pos);
+                    if (end == std::string_view::npos) {
+                        return Status::Incomplete;
+                    }
+                    pos = end + 2;
+                    break;
+                }
+                case '$': {
+                    int64_t len;
+                    Status status = parse_number(buf, pos, len);
+                    if (status != Status::Complete) {
+                        return status;
+                    }
+
+                    // -1 is a RESP2 null
+                    if (len >= 0) {
+                        if (static_cast<size_t>(len) > MAX_BULK) {
+                            return Status::Error;
+                        }
+                        if (buf.size() - pos < static_cast<size_t>(len) + 2) {
+                            return Status::Incomplete;
+                        }
+                        pos += len + 2;
+                    }
+                    break;
+                }
+                case '*': case '%': case '~': case '>': {
+                    int64_t size;
+                    Status status = parse_number(buf, pos, size);
+                    if (status != Status::Complete) {
+                        return status;
+                    }
+
+                    if (size > static_cast<int64_t>(MAX_ARRAY)) {
+                        return Status::Error;
+                    }
+                    if (size > 0) {
+                        remaining += type == '%' ? 2 * size : size;
+                    }
+                    break;
+                }
+                default:
+                    return Status::Error;
+            }
+        }
+
+        consumed = pos;
+        return Status::Complete;
+    }
+
+    void Writer::separate() {
+        if (protocol == Protocol::Text && !first) {
+            out += ' ';
+        }
+
+        first = false;
+    }
+
+    void Writer::header(char type, int64_t num) {
+        char digits[20];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), num);
+
+        out += type;
+        out.append(digits, end - digits);
+        out += "\r\n";
+    }
+
+    void Writer::simple(std::string_view str) {
+        separate();
+        if (protocol == Protocol::Text) {
+            out += str;
+            return;
+        }
+
+        out += '+';
+        out += str;
+        out += "\r\n";
+    }
+
+    void Writer::error(std::string_view msg) {
+        separate();
+        if (protocol == Protocol::Text) {
+            out += msg;
+            return;
+        }
+
+        out += "-ERR ";
+        out += msg;
+        out += "\r\n";
+    }
+
+    void Writer::integer(int64_t num) {
+        separate();
+        if (protocol == Protocol::Text) {
+            out += std::to_string(num);
+            return;
+        }
+
+        header(':', num);
+    }
+
+    void Writer::bulk(std::string_view str) {
+        separate();
+        if (protocol == Protocol::Text) {
+            out += str;
+            return;
+        }
+
+        header('$', str.size());
+        out += str;
+        out += "\r\n";
+    }
+
+    void Writer::null() {
+        separate();
+        switch (protocol) {
+            case Protocol::Text: out += "(NIL)"; break;
+            case Protocol::RESP2: out += "$-1\r\n"; break;
+            case Protocol::RESP3: out += "_\r\n"; break;
+        }
+    }
+
+    void Writer::array(size_t size) {
+        if (protocol != Protocol::Text) {
+            header('*', size);
+        }
+    }
+
+    void Writer::map(size_t size) {
+        switch (protocol) {
+            case Protocol::Text: break;
+            case Protocol::RESP2: header('*', 2 * size); break;
+            case Protocol::RESP3: header('%', size); break;
+        }
+    }
+
+    void Writer::value(const Value &value) {
+        switch (value.type()) {
+            case EntryType::integer:
+                integer(value.integer());
+                break;
+            case EntryType::str:
+                bulk(value.str());
+                break;
+            case EntryType::list: {
+                std::vector<std::string> elements = value.list()->values();
+                array(elements.size());
+                for (const std::string &element : elements) {
+                    bulk(element);
+                }
+                break;
+            }
+            default:
+                null();
+        }
+    }
+
+    bool Reader::read_header(char type, int64_t &num) {
+        if (peek() != type) {
+            return false;
+        }
+
+        size_t next = pos + 1;
+        if (parse_number(buf, next, num) != Status::Complete) {
+            return false;
+        }
+
+        pos = next;
+        return true;
+    }
+
+    bool Reader::read_array(size_t &size) {
+        size_t start = pos;
+        int64_t num;
+        if (!read_header('*', num) || num < 0) {
+            pos = start;
+            return false;
+        }
+
+        size = num;
+        return true;
+    }
+
+    bool Reader::read_integer(int64_t &num) {
+        return read_header(':', num);
+    }
+
+    bool Reader::read_bulk(std::string_view &str) {
+        size_t start = pos;
+        int64_t len;
+        if (!read_header('$', len) || len < 0 || buf.size() - pos < static_cast<size_t>(len) + 2 ||
+            buf[pos + len] != '\r' || buf[pos + len + 1] != '\n'
+        ) {
+            pos = start;
+            return false;
+        }
+
+        str = buf.substr(pos, len);
+        pos += len + 2;
+        return true;
+    }
+
+    bool Reader::read_value(Value &value) {
+        size_t start = pos;
+
+        switch (peek()) {
+            case ':': {
+                int64_t num;
+                if (!read_integer(num)) {
+                    return false;
+                }
+
+                value = Value(num);
+                return true;
+            }
+            case '$': {
+                std::string_view str;
+                if (!read_bulk(str)) {
+                    return false;
+                }
+
+                value = Value(str);
+                return true;
+            }
+            case '*': {
+                size_t size;
+                if (!read_array(size)) {
+                    return false;
+                }
+
+                Value list = Value::new_list();
+                for (size_t i = 0; i < size; i++) {
+                    std::string_view element;
+                    if (!read_bulk(element)) {
+                        pos = start;
+                        return false;
+                    }
+
+                    list.list()->add_end(arg_to_value(element));
+                }
+
+                value = std::move(list);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    void write_entry(std::string_view key, const Value &value, std::string &out) {
+        Writer writer { out, Protocol::RESP2 };
+        writer.array(2);
+        writer.bulk(key);
+        writer.value(value);
+    }
+
+    std::string merge_arrays(const std::vector<std::string> &replies) {
+        int64_t size = 0;
+        std::string body;
+
+        for (const std::string &reply : replies) {
+            size_t pos = 1;
+            int64_t num;
+            if (!reply.empty() && reply[0] == '*' &&
+                parse_number(reply, pos, num) == Status::Complete && num >= 0
+            ) {
+                size += num;
+                body.append(reply, pos);
+            } else {
+                size++;
+                body += reply;
+            }
+        }
+
+        std::string merged;
+        Writer { merged, Protocol::RESP2 }.array(size);
+        return merged + body;
+    }
+
+    void merge_keys(const std::vector<std::string> &replies, const std::vector<std::vector<size_t>> &keys,
+        size_t key_count, Protocol protocol, std::string &out) {
+
+        Writer writer { out, protocol };
+
+        for (const std::string &reply : replies) {
+            if (reply.empty() || reply[0] == '-') {
+                // without the -ERR the writer adds back, and the \r\n
+                std::string_view msg = reply;
+                msg = msg.substr(0, msg.find("\r\n"));
+                msg.remove_prefix(msg.substr(0, 5) == "-ERR " ? 5 : std::min<size_t>(msg.size(), 1));
+                writer.error(msg.empty() ? "FAILED" : msg);
+                return;
+            }
+        }
+
+        if (replies.empty()) {
+            writer.null();
+            return;
+        }
+
+        switch (replies[0][0]) {
+            case ':': {
+                int64_t sum = 0;
+                for (const std::string &reply : replies) {
+                    int64_t num = 0;
+                    Reader { reply }.read_integer(num);
+                    sum += num;
+                }
+
+                writer.integer(sum);
+                break;
+            }
+            case '*': {
+                // keys without a value are null
+                std::vector<std::string_view> values(key_count);
+                std::vector<bool> found(key_count, false);
+
+                for (size_t i = 0; i < replies.size(); i++) {
+                    std::string_view rest = replies[i];
+                    Reader reader { rest };
+                    size_t size;
+                    if (!reader.read_array(size)) {
+                        continue;
+                    }
+                    rest.remove_prefix(rest.find("\r\n") + 2);
+
+                    for (size_t j = 0; j < size && j < keys[i].size(); j++) {
+                        size_t consumed;
+                        if (parse_reply(rest, consumed) != Status::Complete) {
+                            break;
+                        }
+
+                        std::string_view str;
+                        if (Reader { rest.substr(0, consumed) }.read_bulk(str)) {
+                            values[keys[i][j]] = str;
+                            found[keys[i][j]] = true;
+                        }
+                        rest.remove_prefix(consumed);
+                    }
+                }
+
+                writer.array(key_count);
+                for (size_t i = 0; i < key_count; i++) {
+                    if (found[i]) {
+                        writer.bulk(values[i]);
+                    } else {
+                        writer.null();
+                    }
+                }
+                break;
+            }
+            default:
+                // every node replied OK, as to MSET
+                if (protocol == Protocol::Text) {
+                    out += "SUCCESS";
+                } else {
+                    writer.simple("OK");
+                }
+                break;
+        }
+    }
+}
@@ -0,0 +1,521 @@
+#include <algorithm>
+#include <poll.h>
+#include <pthread.h>
+
+#include "shards.hpp"
+#include "command.hpp"
+#include "resp.hpp"
+#include "worker.hpp"
+#include "wyhash.hpp"
+
+// a call() to take a shard's entries within the bounds that follow, see LRUCache::extract
+constexpr char EXTRACT = 'x';
+
+Shards::Shards(size_t count, LRUCache &config, bool pin) {
+    // the node's limits are split evenly, so all the shards together hold what one cache would
+    long max_size = std::max(1L, config.max_size / static_cast<long>(count));
+    long max_memory = config.max_memory / static_cast<long>(count);
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < count; i++) {
+        auto shard = std::make_unique<Shard>();
+        shard->thread = std::thread(run, std::ref(*shard), std::ref(replied), std::ref(called),
+            max_size, max_memory, config.eviction());
+
+        if (pin) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % cores, &cpus);
+            pthread_setaffinity_np(shard->thread.native_handle(), sizeof(cpus), &cpus);
+        }
+
+        shards.push_back(std::move(shard));
+    }
+}
+
+Shards::~Shards() {
+    for (auto &shard : shards) {
+        shard->stopping = true;
+        shard->wake.ring();
+    }
+
+    for (auto &shard : shards) {
+        shard->thread.join();
+    }
+}
+
+size_t Shards::shard_of(std::string_view key) const {
+    return wyhash::hash(key.data(), key.size()) % shards.size();
+}
+
+void Shards::run(Shard &shard, Doorbell &replied, Doorbell &called, long max_size, long max_memory, std::string eviction) {
+    LRUCache::use_thread_pools();
+    serve(shard, replied, called, LRUCache { DEFAULT_INITIAL_SIZE, max_size, max_memory }, eviction);
+    LRUCache::release_thread_pools();
+}
+
+void Shards::serve(Shard &shard, Doorbell &replied, Doorbell &called, LRUCache &&cache, const std::string &eviction) {
+    cache.set_eviction(make_eviction_policy(eviction));
+
+    while (!shard.stopping) {
+        pollfd item { shard.wake.fd(), POLLIN, 0 };
+        poll(&item, 1, ACTIVE_EXPIRE_INTERVAL_MS);
+        // cleared before draining, so a message queued meanwhile rings again
+        shard.wake.clear();
+
+        // the dispatcher is woken once for all the replies to what it sent
+        Message msg;
+        bool any = false;
+        while (shard.requests.pop(msg)) {
+            msg.data = handle(msg.data, cache);
+            // never full, as the dispatcher has at most its capacity in flight
+            shard.replies.push(std::move(msg));
+            any = true;
+        }
+        if (any) {
+            replied.ring();
+        }
+
+        std::string call;
+        if (shard.calls.pop(call)) {
+            shard.call_replies.push(handle(call, cache, shard.group));
+            called.ring();
+        }
+
+        // reclaim expired keys between requests
+        cache.active_expire();
+    }
+}
+
+std::string Shards::handle(std::string_view msg, LRUCache &cache, const LRUCache::Group *group) {
+    if (msg.empty()) {
+        return "";
+    }
+
+    if (msg[0] == CACHE_UPDATE) {
+        long old_size = cache.size();
+        cache.import(msg.substr(1));
+        return std::to_string(cache.size() - old_size);
+    }
+
+    if (msg[0] == EXTRACT) {
+        // the message is the number of groups
+        size_t groups = std::stoull(std::string(msg.substr(1)));
+        std::vector<std::string> extracted = group ? cache.extract(*group, groups) : std::vector<std::string>();
+        std::string reply;
+        resp::Writer writer { reply, resp::Protocol::RESP2 };
+        writer.array(extracted.size());
+        for (const std::string &str : extracted) {
+            writer.bulk(str);
+        }
+        return reply;
+    }
+
+    return serve_commands(msg, cache);
+}
+
+bool Shards::send(Shard &shard, Message &&msg) {
+    // replies can't overflow as long as no more than a queue's worth is in flight
+    if (!shard.backlog.empty() || shard.in_flight == shard.requests.capacity() || !shard.requests.push(std::move(msg))) {
+        shard.backlog.push_back(std::move(msg));
+        return false;
+    }
+
+    shard.in_flight++;
+    return true;
+}
+
+void Shards::dispatch(std::vector<std::pair<size_t, std::string>> &messages, Merge merge, Done done) {
+    auto gather = std::make_shared<Gather>();
+    gather->parts.resize(messages.size());
+    gather->waiting = messages.size();
+    gather->merge = std::move(merge);
+    gather->done = std::move(done);
+
+    if (messages.empty()) {
+        gather->done(gather->merge(gather->parts));
+        return;
+    }
+
+    for (size_t i = 0; i < messages.size(); i++) {
+        uint64_t tag = next_tag++;
+        waiting[tag] = { gather, i };
+
+        Shard &shard = *shards[messages[i].first];
+        if (send(shard, { tag, std::move(messages[i].second) })) {
+            shard.wake.ring();
+        }
+    }
+}
+
+bool Shards::submit(std::string_view msg, Done done) {
+    std::vector<std::pair<size_t, std::string>> messages;
+    Merge merge;
+    if (!plan(msg, messages, merge)) {
+        return false;
+    }
+
+    dispatch(messages, std::move(merge), std::move(done));
+    return true;
+}
+
+// the message's first reply, for commands every shard runs the same way
+static std::string first_part(std::vector<std::string> &parts) {
+    return std::move(parts[0]);
+}
+
+static std::string protocol_error(std::vector<std::string> &) {
+    return "-ERR Protocol error\r\n";
+}
+
+bool Shards::plan(std::string_view msg, std::vector<std::pair<size_t, std::string>> &messages, Merge &merge) const {
+    if (msg.empty()) {
+        return false;
+    }
+
+    char type = msg[0];
+
+    if (type == CACHE_UPDATE) {
+        // each entry goes to the shard of its key. a malformed entry ends the import, as in LRUCache::import
+        std::vector<std::string> parts(shards.size());
+        std::string_view entries = msg.substr(1);
+        while (!entries.empty()) {
+            size_t consumed;
+            size_t size;
+            std::string_view key;
+            resp::Reader reader { entries };
+            if (resp::parse_reply(entries, consumed) != resp::Status::Complete ||
+                !reader.read_array(size) || !reader.read_bulk(key)
+            ) {
+                break;
+            }
+
+            std::string &part = parts[shard_of(key)];
+            if (part.empty()) {
+                part += CACHE_UPDATE;
+            }
+            part += entries.substr(0, consumed);
+            entries.remove_prefix(consumed);
+        }
+
+        for (size_t i = 0; i < parts.size(); i++) {
+            if (!parts[i].empty()) {
+                messages.emplace_back(i, std::move(parts[i]));
+            }
+        }
+
+        // each shard replies with how many keys it gained
+        merge = [](std::vector<std::string> &parts) {
+            long added = 0;
+            for (const std::string &part : parts) {
+                added += std::stol(part);
+            }
+            return std::to_string(added);
+        };
+        return true;
+    }
+
+    if (type != COMMAND && type != BATCH) {
+        return false;
+    }
+
+    if (msg.size() < 2) {
+        merge = protocol_error;
+        return true;
+    }
+    resp::Protocol protocol = static_cast<resp::Protocol>(msg[1]);
+    std::string_view body = msg.substr(2);
+
+    if (type == BATCH) {
+        // requests are split by shard like the leader splits them by node, then put back in order.
+        // the leader only batches single-key commands, so others run on the first shard
+        std::vector<std::string> parts(shards.size());
+        std::vector<std::vector<size_t>> order(shards.size());
+        size_t count = 0;
+        bool malformed = false;
+
+        Tokens args;
+        while (!body.empty()) {
+            size_t consumed;
+            args.clear();
+            if (resp::parse_request(body, args, consumed) != resp::Status::Complete) {
+                malformed = true;
+                break;
+            }
+
+            const cmd::Spec *spec = cmd::lookup(args.name());
+            size_t shard = spec && spec->routing == cmd::Routing::Key && !args.key().empty() ? shard_of(args.key()) : 0;
+            if (parts[shard].empty()) {
+                parts[shard] += BATCH;
+                parts[shard] += static_cast<char>(protocol);
+            }
+            parts[shard] += body.substr(0, consumed);
+            order[shard].push_back(count++);
+            body.remove_prefix(consumed);
+        }
+
+        std::vector<std::vector<size_t>> indexes;
+        for (size_t i = 0; i < parts.size(); i++) {
+            if (!parts[i].empty()) {
+                messages.emplace_back(i, std::move(parts[i]));
+                indexes.push_back(std::move(order[i]));
+            }
+        }
+
+        merge = [indexes, count, malformed](std::vector<std::string> &parts) {
+            std::vector<std::string_view> replies(count);
+            for (size_t i = 0; i < parts.size(); i++) {
+                std::string_view rest = parts[i];
+                for (size_t index : indexes[i]) {
+                    size_t consumed;
+                    if (resp::parse_reply(rest, consumed) != resp::Status::Complete) {
+                        break;
+                    }
+                    replies[index] = rest.substr(0, consumed);
+                    rest.remove_prefix(consumed);
+                }
+            }
+
+            std::string out;
+            for (std::string_view reply : replies) {
+                out += reply;
+            }
+            if (malformed) {
+                out += "-ERR Protocol error\r\n";
+            }
+            return out;
+        };
+        return true;
+    }
+
+    Tokens args;
+    size_t consumed;
+    if (resp::parse_request(body, args, consumed) != resp::Status::Complete) {
+        merge = protocol_error;
+        return true;
+    }
+
+    const cmd::Spec *spec = cmd::lookup(args.name());
+    cmd::Routing routing = spec ? spec->routing : cmd::Routing::Local;
+    std::string request { msg };
+
+    // sends the request to every shard, asking in RESP2 if the replies are merged here
+    auto every_shard = [&](bool resp2) {
+        std::string shard_msg = request;
+        if (resp2) {
+            shard_msg[1] = static_cast<char>(resp::Protocol::RESP2);
+        }
+        for (size_t i = 0; i < shards.size(); i++) {
+            messages.emplace_back(i, shard_msg);
+        }
+    };
+
+    switch (routing) {
+        case cmd::Routing::Key:
+            messages.emplace_back(args.key().empty() ? 0 : shard_of(args.key()), request);
+            merge = first_part;
+            return true;
+        case cmd::Routing::Keys:
+        case cmd::Routing::Pairs: {
+            size_t step = routing == cmd::Routing::Pairs ? 2 : 1;
+
+            // where each shard's keys are in the command
+            std::vector<std::vector<size_t>> keys(shards.size());
+            if ((args.size() - 1) % step == 0) {
+                for (size_t i = 1; i < args.size(); i += step) {
+                    keys[shard_of(args[i])].push_back((i - 1) / step);
+                }
+            }
+
+            size_t used = std::count_if(keys.begin(), keys.end(), [](const auto &k) { return !k.empty(); });
+            if (used <= 1) {
+                // one shard has every key, or the command has no keys or is missing a value
+                auto shard = std::find_if(keys.begin(), keys.end(), [](const auto &k) { return !k.empty(); });
+                messages.emplace_back(shard == keys.end() ? 0 : shard - keys.begin(), request);
+                merge = first_part;
+                return true;
+            }
+
+            std::vector<std::vector<size_t>> part_keys;
+            for (size_t shard = 0; shard < shards.size(); shard++) {
+                if (keys[shard].empty()) {
+                    continue;
+                }
+
+                Tokens sub;
+                sub.push(args.name());
+                for (size_t key : keys[shard]) {
+                    for (size_t arg = 0; arg < step; arg++) {
+                        sub.push(args[1 + key * step + arg]);
+                    }
+                }
+
+                std::string shard_msg;
+                shard_msg += COMMAND;
+                shard_msg += static_cast<char>(resp::Protocol::RESP2);
+                resp::write_request(sub, shard_msg);
+                messages.emplace_back(shard, std::move(shard_msg));
+                part_keys.push_back(std::move(keys[shard]));
+            }
+
+            size_t key_count = (args.size() - 1) / step;
+            merge = [part_keys, key_count, protocol](std::vector<std::string> &parts) {
+                std::string out;
+                resp::merge_keys(parts, part_keys, key_count, protocol, out);
+                return out;
+            };
+            return true;
+        }
+        case cmd::Routing::Sum:
+            every_shard(true);
+            merge = [protocol](std::vector<std::string> &parts) {
+                std::string out;
+                resp::merge_keys(parts, {}, 0, protocol, out);
+                return out;
+            };
+            return true;
+        case cmd::Routing::Concat:
+            every_shard(false);
+            merge = [protocol](std::vector<std::string> &parts) {
+                if (protocol != resp::Protocol::Text) {
+                    return resp::merge_arrays(parts);
+                }
+
+                std::string out;
+                for (const std::string &part : parts) {
+                    if (!part.empty()) {
+                        out += out.empty() ? "" : " ";
+                        out += part;
+                    }
+                }
+                return out;
+            };
+            return true;
+        case cmd::Routing::Broadcast:
+            every_shard(false);
+            merge = first_part;
+            return true;
+        default:
+            messages.emplace_back(0, request);
+            merge = first_part;
+            return true;
+    }
+}
+
+void Shards::collect() {
+    replied.clear();
+
+    for (auto &shard : shards) {
+        Message msg;
+        while (shard->replies.pop(msg)) {
+            shard->in_flight--;
+
+            auto it = waiting.find(msg.tag);
+            if (it == waiting.end()) {
+                continue;
+            }
+
+            Part part = std::move(it->second);
+            waiting.erase(it);
+
+            Gather &gather = *part.gather;
+            gather.parts[part.index] = std::move(msg.data);
+            if (--gather.waiting == 0) {
+                gather.done(gather.merge(gather.parts));
+            }
+        }
+
+        // room was made for the backlog
+        bool sent = false;
+        while (!shard->backlog.empty() && shard->in_flight < shard->requests.capacity()) {
+            if (!shard->requests.push(std::move(shard->backlog.front()))) {
+                break;
+            }
+            shard->backlog.pop_front();
+            shard->in_flight++;
+            sent = true;
+        }
+        if (sent) {
+            shard->wake.ring();
+        }
+    }
+}
+
+std::vector<std::string> Shards::call_parts(std::vector<std::pair<size_t, std::string>> &messages) {
+    // a message has at most one part per shard, so each shard's queue has room for it
+    for (auto &[index, msg] : messages) {
+        shards[index]->calls.push(std::move(msg));
+        shards[index]->wake.ring();
+    }
+
+    std::vector<std::string> parts(messages.size());
+    for (size_t i = 0; i < messages.size(); i++) {
+        Shard &shard = *shards[messages[i].first];
+        while (!shard.call_replies.pop(parts[i])) {
+            pollfd item { called.fd(), POLLIN, 0 };
+            poll(&item, 1, ACTIVE_EXPIRE_INTERVAL_MS);
+            called.clear();
+        }
+    }
+
+    return parts;
+}
+
+bool Shards::call(std::string_view msg, std::string &reply) {
+    std::vector<std::pair<size_t, std::string>> messages;
+    Merge merge;
+    if (!plan(msg, messages, merge)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(call_mutex);
+    std::vector<std::string> parts = call_parts(messages);
+    reply = merge(parts);
+    return true;
+}
+
+std::vector<std::string> Shards::extract(const std::vector<uint64_t> &upper_bounds) {
+    if (upper_bounds.size() < 2) {
+        return {};
+    }
+
+    return extract(LRUCache::by_ranges(upper_bounds), upper_bounds.size() - 1);
+}
+
+std::vector<std::string> Shards::extract(const LRUCache::Group &group, size_t groups) {
+    std::string msg = EXTRACT + std::to_string(groups);
+
+    std::vector<std::pair<size_t, std::string>> messages;
+    for (size_t i = 0; i < shards.size(); i++) {
+        messages.emplace_back(i, msg);
+    }
+
+    // shards only read group while this call waits for them, and see it set as they pop the message
+    std::lock_guard<std::mutex> lock(call_mutex);
+    for (auto &shard : shards) {
+        shard->group = &group;
+    }
+    std::vector<std::string> parts = call_parts(messages);
+    for (auto &shard : shards) {
+        shard->group = nullptr;
+    }
+
+    // each shard's entries in a group are appended to the others'
+    std::vector<std::string> extracted(groups);
+    for (const std::string &part : parts) {
+        resp::Reader reader { part };
+        size_t size;
+        if (!reader.read_array(size)) {
+            continue;
+        }
+
+        for (size_t i = 0; i < size && i < extracted.size(); i++) {
+            std::string_view str;
+            if (reader.read_bulk(str)) {
+                extracted[i] += str;
+            }
+        }
+    }
+
+    return extracted;
+}
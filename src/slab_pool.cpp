@@ -0,0 +1,76 @@
+#include <new>
+#include <cstdlib>
+#include <algorithm>
+#include <sstream>
+
+#include "slab_pool.hpp"
+
+SlabPool::SlabPool(const std::string &name, size_t object_size, size_t alignment): name(name) {
+    // every slot must be able to hold a free list link, and keep the next slot aligned
+    alignment = std::max(alignment, alignof(FreeSlot));
+    object_size = std::max(object_size, sizeof(FreeSlot));
+    this->object_size = (object_size + alignment - 1) / alignment * alignment;
+}
+
+SlabPool::~SlabPool() {
+    release();
+}
+
+void *SlabPool::allocate() {
+    in_use++;
+
+    if (free_list) {
+        FreeSlot *slot = free_list;
+        free_list = slot->next;
+        return slot;
+    }
+
+    if (!unused || static_cast<size_t>(unused_end - unused) < object_size) {
+        char *slab = static_cast<char*>(std::malloc(SLAB_SIZE));
+        if (!slab) {
+            in_use--;
+            throw std::bad_alloc();
+        }
+
+        slabs.push_back(slab);
+        unused = slab;
+        unused_end = slab + SLAB_SIZE;
+    }
+
+    void *ptr = unused;
+    unused += object_size;
+    return ptr;
+}
+
+void SlabPool::deallocate(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    FreeSlot *slot = static_cast<FreeSlot*>(ptr);
+    slot->next = free_list;
+    free_list = slot;
+    in_use--;
+}
+
+void SlabPool::release() {
+    for (char *slab : slabs) {
+        std::free(slab);
+    }
+
+    slabs.clear();
+    free_list = nullptr;
+    unused = nullptr;
+    unused_end = nullptr;
+    in_use = 0;
+}
+
+std::string SlabPool::stats() const {
+    std::stringstream ss;
+    ss << name << "(size=" << object_size
+        << " used=" << in_use
+        << " slabs=" << slabs.size()
+        << " bytes=" << memory_usage() << ")";
+
+    return ss.str();
+}
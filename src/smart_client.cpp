@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <sstream>
+#include <iterator>
+
+#include "smart_client.hpp"
+#include "consistent-hashing.hpp"
+#include "command.hpp"
+#include "worker.hpp"
+
+SmartClient::SmartClient(const std::string &leader_endpoint, int timeout_ms):
+    leader_endpoint(leader_endpoint),
+    timeout_ms(timeout_ms),
+    leader(connect(leader_endpoint)) {}
+
+zmq::socket_t SmartClient::connect(const std::string &endpoint) {
+    zmq::socket_t socket{context, zmq::socket_type::req};
+    socket.set(zmq::sockopt::linger, 0);
+    socket.set(zmq::sockopt::rcvtimeo, timeout_ms);
+    socket.connect(endpoint);
+    return socket;
+}
+
+bool SmartClient::send_recv(zmq::socket_t &socket, const std::string &endpoint, const std::string &msg, std::string &reply) {
+    try {
+        socket.send(zmq::buffer(msg), zmq::send_flags::none);
+
+        zmq::message_t res;
+        if (socket.recv(res, zmq::recv_flags::none)) {
+            reply = res.to_string();
+            return true;
+        }
+    } catch (...) {
+    }
+
+    socket = connect(endpoint);
+    return false;
+}
+
+bool SmartClient::refresh() {
+    std::string internal;
+    if (!send_recv(leader, leader_endpoint, "ring", internal)) {
+        return false;
+    }
+
+    set_ring(internal);
+    return true;
+}
+
+void SmartClient::set_ring(std::string_view internal) {
+    nodes.clear();
+    placement.reset();
+    PlacementType type = PlacementType::Ring;
+
+    std::istringstream iss { std::string(internal) };
+    for (auto it = std::istream_iterator<std::string>(iss); it != std::istream_iterator<std::string>(); ++it) {
+        const std::string &node = *it;
+        if (node[0] == '@') {
+            parse_placement(std::string_view(node).substr(1), type);
+            continue;
+        }
+
+        size_t sep = node.find(",");
+        if (sep == std::string::npos) {
+            continue;
+        }
+
+        bool is_leader = node[0] == '*';
+        std::string pid = node.substr(is_leader ? 1 : 0, sep - (is_leader ? 1 : 0));
+        std::string endpoint = node.substr(sep + 1);
+        int vnodes = 1;
+        int weight = 1;
+
+        size_t vnodes_sep = endpoint.find(",");
+        if (vnodes_sep != std::string::npos) {
+            vnodes = std::max(atoi(endpoint.c_str() + vnodes_sep + 1), 1);
+            size_t weight_sep = endpoint.find(",", vnodes_sep + 1);
+            if (weight_sep != std::string::npos) {
+                weight = std::max(atoi(endpoint.c_str() + weight_sep + 1), 1);
+            }
+            endpoint.resize(vnodes_sep);
+        }
+        nodes.push_back({ hash_function(pid + endpoint), pid, endpoint, is_leader, vnodes, weight });
+    }
+
+    std::sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.pid < b.pid;
+    });
+
+    if (nodes.size() > 0) {
+        std::vector<Placement::Node> placed;
+        for (const Node &node : nodes) {
+            placed.push_back({ node.pid, node.endpoint, node.vnodes, node.weight });
+        }
+        placement = Placement::make(type, placed);
+    }
+
+    // sockets to nodes that left are closed
+    for (auto it = workers.begin(); it != workers.end();) {
+        bool found = std::any_of(nodes.begin(), nodes.end(), [&](const Node &node) {
+            return node.endpoint == it->first;
+        });
+        it = found ? std::next(it) : workers.erase(it);
+    }
+}
+
+const SmartClient::Node *SmartClient::owner(std::string_view key) const {
+    if (!placement) {
+        return nullptr;
+    }
+
+    return &nodes[placement->get(hash_function(key))];
+}
+
+std::string SmartClient::request(const Tokens &args, resp::Protocol protocol) {
+    const cmd::Spec *spec = cmd::lookup(args.name());
+    bool keyed = spec && spec->routing == cmd::Routing::Key && !args.key().empty();
+
+    for (int tries = 0; keyed && tries <= SMART_MAX_REDIRECTS; tries++) {
+        const Node *node = owner(args.key());
+        if (!node || node->is_leader) {
+            break;
+        }
+
+        std::string msg;
+        msg += DIRECT_COMMAND;
+        msg += static_cast<char>(protocol);
+        resp::write_request(args, msg);
+
+        std::string endpoint = node->endpoint;
+        auto socket = workers.find(endpoint);
+        if (socket == workers.end()) {
+            socket = workers.emplace(endpoint, connect(endpoint)).first;
+        }
+
+        std::string reply;
+        if (!send_recv(socket->second, endpoint, msg, reply)) {
+            // the worker may have left, so the leader is asked instead
+            refresh();
+            break;
+        }
+
+        if (!reply.empty() && reply[0] == COMMAND) {
+            direct++;
+            return reply.substr(1);
+        }
+
+        // the ring changed since it was fetched
+        redirects++;
+        if (!refresh()) {
+            break;
+        }
+    }
+
+    // the leader serves every request, just with an extra hop for keys on workers
+    std::string msg;
+    if (protocol == resp::Protocol::Text) {
+        for (size_t i = 0; i < args.size(); i++) {
+            msg += i > 0 ? " " : "";
+            msg += args[i];
+        }
+    } else {
+        resp::write_request(args, msg);
+    }
+
+    std::string reply;
+    if (!send_recv(leader, leader_endpoint, msg, reply)) {
+        reply.clear();
+        resp::Writer { reply, protocol }.error("FAILED");
+    }
+
+    return reply;
+}
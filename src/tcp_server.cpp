@@ -0,0 +1,313 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "tcp_server.hpp"
+
+// reads per event before other connections get a turn. epoll reports the rest on the next poll
+constexpr int TCP_READS_PER_EVENT = 64;
+
+TcpServer::TcpServer(Handler handler): handler(std::move(handler)) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        std::perror("epoll_create1");
+        exit(EXIT_FAILURE);
+    }
+}
+
+TcpServer::~TcpServer() {
+    for (auto &[fd, conn] : connections) {
+        close(fd);
+    }
+
+    if (listen_fd >= 0) {
+        close(listen_fd);
+    }
+
+    close(epoll_fd);
+}
+
+bool TcpServer::listen(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    socklen_t len = sizeof(addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(fd, SOMAXCONN) < 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0
+    ) {
+        close(fd);
+        return false;
+    }
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    this->port = ntohs(addr.sin_port);
+    return true;
+}
+
+void TcpServer::watch(int fd, std::function<void()> on_ready) {
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        std::perror("epoll_ctl");
+        exit(EXIT_FAILURE);
+    }
+
+    watched[fd] = std::move(on_ready);
+}
+
+int TcpServer::poll(int timeout_ms) {
+    epoll_event events[TCP_MAX_EVENTS];
+    int count = epoll_wait(epoll_fd, events, TCP_MAX_EVENTS, timeout_ms);
+    if (count < 0) {
+        // interrupted by a signal
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+
+        if (fd == listen_fd) {
+            accept_all();
+            continue;
+        }
+
+        auto watcher = watched.find(fd);
+        if (watcher != watched.end()) {
+            watcher->second();
+            continue;
+        }
+
+        // may have been closed by an earlier event
+        auto it = connections.find(fd);
+        if (it == connections.end()) {
+            continue;
+        }
+
+        Connection &conn = it->second;
+        uint32_t ready = events[i].events;
+
+        // both directions are shut, so nothing more can be sent
+        if (ready & (EPOLLHUP | EPOLLERR)) {
+            close_connection(fd);
+            continue;
+        }
+
+        // requests read before the client closed its end are still answered
+        if ((ready & EPOLLIN) && !read_all(fd, conn)) {
+            conn.eof = true;
+        }
+
+        bool valid = serve(fd, conn);
+        bool flushed = flush(fd, conn);
+        finish(fd, conn, valid && flushed);
+    }
+
+    return count;
+}
+
+void TcpServer::accept_all() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // none left, or out of fds. the rest are accepted on a later poll
+            return;
+        }
+
+        // replies are small and written whole, so don't hold them back waiting for acks
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+
+        Connection &conn = connections[fd];
+        conn.id = next_connection_id++;
+        conn.events = EPOLLIN;
+    }
+}
+
+bool TcpServer::read_all(int fd, Connection &conn) {
+    char buf[TCP_READ_SIZE];
+
+    for (int reads = 0; reads < TCP_READS_PER_EVENT; reads++) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            conn.in.append(buf, n);
+        } else if (n == 0) {
+            return false;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TcpServer::serve(int fd, Connection &conn) {
+    std::string_view buf = conn.in;
+    size_t pos = 0;
+    bool valid = true;
+    Tokens args;
+    conn.blocked = false;
+
+    while (pos < buf.size()) {
+        // stop once replies back up, and continue when the socket drains or deferred replies complete
+        if (conn.queued.size() >= TCP_MAX_QUEUED || (conn.out.size() - conn.sent >= TCP_MAX_PENDING &&
+            (!flush(fd, conn) || conn.out.size() - conn.sent >= TCP_MAX_PENDING))
+        ) {
+            conn.blocked = true;
+            break;
+        }
+
+        args.clear();
+        size_t consumed = 0;
+        resp::Status status = resp::parse_request(buf.substr(pos), args, consumed);
+
+        if (status == resp::Status::Incomplete) {
+            if (buf[pos] != '*' && buf.size() - pos > TCP_MAX_INLINE) {
+                conn.out += "-ERR Protocol error: too big inline request\r\n";
+                valid = false;
+            }
+            break;
+        } else if (status == resp::Status::Error) {
+            conn.out += "-ERR Protocol error\r\n";
+            valid = false;
+            break;
+        }
+
+        pos += consumed;
+        // blank lines are skipped, like Redis
+        if (args.empty()) {
+            continue;
+        }
+
+        Ticket ticket { fd, conn.id, conn.next_seq++ };
+        if (conn.queued.empty()) {
+            if (!handler(args, conn.protocol, conn.out, ticket)) {
+                conn.queued.emplace_back();
+            }
+        } else {
+            // held behind a deferred reply
+            Reply &reply = conn.queued.emplace_back();
+            reply.ready = handler(args, conn.protocol, reply.data, ticket);
+        }
+    }
+
+    conn.in.erase(0, pos);
+    return valid;
+}
+
+void TcpServer::complete(const Ticket &ticket, std::string_view reply) {
+    auto it = connections.find(ticket.fd);
+    if (it == connections.end() || it->second.id != ticket.connection) {
+        return;
+    }
+
+    Connection &conn = it->second;
+    uint64_t first = conn.next_seq - conn.queued.size();
+    Reply &slot = conn.queued[ticket.seq - first];
+    slot.data = reply;
+    slot.ready = true;
+
+    while (!conn.queued.empty() && conn.queued.front().ready) {
+        conn.out += conn.queued.front().data;
+        conn.queued.pop_front();
+    }
+
+    // requests held back by the limits may be served now
+    bool valid = serve(ticket.fd, conn);
+    bool flushed = flush(ticket.fd, conn);
+    finish(ticket.fd, conn, valid && flushed);
+}
+
+bool TcpServer::flush(int fd, Connection &conn) {
+    while (conn.sent < conn.out.size()) {
+        ssize_t n = send(fd, conn.out.data() + conn.sent, conn.out.size() - conn.sent, MSG_NOSIGNAL);
+        if (n >= 0) {
+            conn.sent += n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+
+    if (conn.sent == conn.out.size()) {
+        conn.out.clear();
+        conn.sent = 0;
+    }
+
+    return true;
+}
+
+void TcpServer::finish(int fd, Connection &conn, bool ok) {
+    bool done = conn.eof && !conn.blocked && conn.queued.empty() && conn.sent == conn.out.size();
+    if (!ok || done) {
+        close_connection(fd);
+    } else {
+        update_events(fd, conn);
+    }
+}
+
+void TcpServer::update_events(int fd, Connection &conn) {
+    size_t pending = conn.out.size() - conn.sent;
+    uint32_t events = 0;
+
+    if (!conn.eof && pending < TCP_MAX_PENDING && conn.queued.size() < TCP_MAX_QUEUED) {
+        events |= EPOLLIN;
+    }
+
+    if (pending > 0) {
+        events |= EPOLLOUT;
+    }
+
+    if (events != conn.events) {
+        epoll_event event {};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        conn.events = events;
+    }
+}
+
+void TcpServer::close_connection(int fd) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
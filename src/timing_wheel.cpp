@@ -0,0 +1,172 @@
+#include "timing_wheel.hpp"
+
+TimingWheel::TimingWheel(TimingWheel &&other): count(other.count), current(other.current), cascaded(other.cascaded) {
+    for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+        slots[i] = other.slots[i];
+        other.slots[i] = nullptr;
+    }
+
+    other.count = 0;
+}
+
+TimingWheel& TimingWheel::operator=(TimingWheel &&other) {
+    if (this != &other) {
+        for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+            slots[i] = other.slots[i];
+            other.slots[i] = nullptr;
+        }
+
+        count = other.count;
+        current = other.current;
+        cascaded = other.cascaded;
+        other.count = 0;
+    }
+
+    return *this;
+}
+
+void TimingWheel::link(CacheEntry *entry, int slot) {
+    CacheEntry *head = slots[slot];
+
+    if (!head) {
+        entry->wheel_prev = entry;
+        entry->wheel_next = entry;
+        slots[slot] = entry;
+    } else {
+        // insert before head, at the end of the circular list
+        entry->wheel_prev = head->wheel_prev;
+        entry->wheel_next = head;
+        head->wheel_prev->wheel_next = entry;
+        head->wheel_prev = entry;
+    }
+
+    entry->wheel_slot = slot;
+    count++;
+}
+
+void TimingWheel::unlink(CacheEntry *entry) {
+    int slot = entry->wheel_slot;
+
+    if (entry->wheel_next == entry) {
+        slots[slot] = nullptr;
+    } else {
+        entry->wheel_prev->wheel_next = entry->wheel_next;
+        entry->wheel_next->wheel_prev = entry->wheel_prev;
+
+        if (slots[slot] == entry) {
+            slots[slot] = entry->wheel_next;
+        }
+    }
+
+    entry->wheel_prev = nullptr;
+    entry->wheel_next = nullptr;
+    entry->wheel_slot = -1;
+    count--;
+}
+
+int TimingWheel::slot_for(seconds::rep expiration) {
+    if (expiration < current) {
+        expiration = current;
+    }
+
+    seconds::rep delta = expiration - current;
+
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        if (delta < (seconds::rep(1) << (WHEEL_BITS * (level + 1)))) {
+            return level * WHEEL_SLOTS + ((expiration >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+        }
+    }
+
+    // past the end of the wheel. park it in the furthest slot, it will be rescheduled on cascade
+    int level = WHEEL_LEVELS - 1;
+    expiration = current + (seconds::rep(1) << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    return level * WHEEL_SLOTS + ((expiration >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+}
+
+long TimingWheel::cascade(int level) {
+    int slot = level * WHEEL_SLOTS + ((current >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+
+    CacheEntry *cur = slots[slot];
+    if (!cur) {
+        return 0;
+    }
+
+    // detach the whole list, then reschedule each entry relative to current
+    cur->wheel_prev->wheel_next = nullptr;
+    slots[slot] = nullptr;
+
+    long moved = 0;
+    while (cur) {
+        CacheEntry *next = cur->wheel_next;
+        count--;
+        link(cur, slot_for(cur->expiration));
+        cur = next;
+        moved++;
+    }
+
+    return moved;
+}
+
+void TimingWheel::add(CacheEntry *entry) {
+    remove(entry);
+
+    if (entry->expiration > 0) {
+        link(entry, slot_for(entry->expiration));
+    }
+}
+
+void TimingWheel::remove(CacheEntry *entry) {
+    if (entry->wheel_slot >= 0) {
+        unlink(entry);
+    }
+}
+
+CacheEntry *TimingWheel::pop_expired(seconds::rep now, long &work, long max_work) {
+    if (count == 0) {
+        // nothing scheduled, skip ahead
+        if (current <= now) {
+            current = now + 1;
+            cascaded = false;
+        }
+        return nullptr;
+    }
+
+    while (current <= now && work < max_work) {
+        if (!cascaded) {
+            // when the lower levels wrap around, pull the next slot of each level above down
+            for (int level = 1; level < WHEEL_LEVELS; level++) {
+                seconds::rep lower_bits = current & ((seconds::rep(1) << (WHEEL_BITS * level)) - 1);
+                if (lower_bits != 0) {
+                    break;
+                }
+
+                work += cascade(level) + 1;
+            }
+
+            cascaded = true;
+        }
+
+        CacheEntry *head = slots[current & (WHEEL_SLOTS - 1)];
+        if (head) {
+            unlink(head);
+            work++;
+            return head;
+        }
+
+        current++;
+        cascaded = false;
+        work++;
+    }
+
+    return nullptr;
+}
+
+void TimingWheel::clear(seconds::rep now) {
+    for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+        slots[i] = nullptr;
+    }
+
+    count = 0;
+    current = now;
+    cascaded = false;
+}
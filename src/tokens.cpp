@@ -0,0 +1,57 @@
+#include "tokens.hpp"
+
+// the characters std::isspace treats as whitespace in the C locale, which istream splitting used
+static bool is_space(char ch) {
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+Tokens::Tokens(std::string_view str) {
+    size_t i = 0;
+    size_t n = str.size();
+
+    while (i < n) {
+        while (i < n && is_space(str[i])) {
+            i++;
+        }
+
+        size_t start = i;
+        while (i < n && !is_space(str[i])) {
+            i++;
+        }
+
+        if (i > start) {
+            push(str.substr(start, i - start));
+        }
+    }
+}
+
+void Tokens::push(std::string_view token) {
+    if (count < TOKENS_INLINE) {
+        inline_tokens[count] = token;
+    } else {
+        more.push_back(token);
+    }
+
+    count++;
+}
+
+std::string_view Tokens::key() const {
+    size_t i = equals_ignore_case(name(), "memory") ? 2 : 1;
+    return i < count ? (*this)[i] : std::string_view();
+}
+
+bool equals_ignore_case(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] + 32 : a[i];
+        char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] + 32 : b[i];
+        if (x != y) {
+            return false;
+        }
+    }
+
+    return true;
+}
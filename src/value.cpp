@@ -0,0 +1,142 @@
+#include <cctype>
+
+#include "entries/value.hpp"
+#include "quick_list.hpp"
+
+Value::Value(std::string_view str) {
+    if (str.size() <= SMALL_CAPACITY) {
+        set_tag(EntryType::str, SMALL_FLAG | static_cast<uint8_t>(str.size()));
+        std::memcpy(bytes, str.data(), str.size());
+    } else {
+        set_tag(EntryType::str);
+
+        char *data = new char[str.size()];
+        std::memcpy(data, str.data(), str.size());
+        store(HeapString { data, str.size() });
+    }
+}
+
+Value::Value(Value &&other) noexcept: tag(other.tag) {
+    std::memcpy(bytes, other.bytes, sizeof(bytes));
+    other.tag = 0;
+}
+
+Value& Value::operator=(Value &&other) noexcept {
+    if (this != &other) {
+        reset();
+
+        std::memcpy(bytes, other.bytes, sizeof(bytes));
+        tag = other.tag;
+        other.tag = 0;
+    }
+
+    return *this;
+}
+
+void Value::reset() {
+    if (type() == EntryType::str && !is_small()) {
+        delete[] load<HeapString>().data;
+    } else if (type() == EntryType::list) {
+        delete list();
+    }
+
+    tag = 0;
+}
+
+Value Value::new_list() {
+    return Value(new QuickList());
+}
+
+std::string_view Value::str() const {
+    if (is_small()) {
+        return std::string_view(bytes, tag & SIZE_MASK);
+    }
+
+    HeapString heap = load<HeapString>();
+    return std::string_view(heap.data, heap.size);
+}
+
+std::string Value::to_string() const {
+    switch (type()) {
+        case EntryType::str:
+            return std::string(str());
+        case EntryType::integer:
+            return std::to_string(integer());
+        case EntryType::list:
+            return list()->values(0, -1, false, true)[0];
+        default:
+            return "?";
+    }
+}
+
+size_t Value::memory_usage() const {
+    switch (type()) {
+        case EntryType::str:
+            return is_small() ? 0 : load<HeapString>().size;
+        case EntryType::list:
+            return sizeof(QuickList) + list()->memory_usage();
+        default:
+            return 0;
+    }
+}
+
+// parses a non negative int without exceptions. returns false if str is not all digits, overflows,
+// or has leading zeros, so an int is only stored when it prints back as the same bytes
+static bool parse_int(std::string_view str, int64_t &out) {
+    if (str.empty() || str.size() > 19 || (str.size() > 1 && str[0] == '0')) {
+        return false;
+    }
+
+    uint64_t num = 0;
+    for (char ch : str) {
+        if (ch < '0' || ch > '9') {
+            return false;
+        }
+
+        num = num * 10 + (ch - '0');
+    }
+
+    if (num > INT64_MAX) {
+        return false;
+    }
+
+    out = num;
+    return true;
+}
+
+Value str_to_value(std::string_view str) {
+    if (str.find(' ') != std::string_view::npos) {
+        Value value = Value::new_list();
+        QuickList *list = value.list();
+
+        // split on any whitespace, skipping repeats
+        size_t i = 0;
+        while (i < str.size()) {
+            while (i < str.size() && std::isspace(static_cast<unsigned char>(str[i]))) {
+                i++;
+            }
+
+            size_t start = i;
+            while (i < str.size() && !std::isspace(static_cast<unsigned char>(str[i]))) {
+                i++;
+            }
+
+            if (i > start) {
+                list->add_end(str_to_value(str.substr(start, i - start)));
+            }
+        }
+
+        return value;
+    }
+
+    return arg_to_value(str);
+}
+
+Value arg_to_value(std::string_view str) {
+    int64_t num;
+    if (parse_int(str, num)) {
+        return Value(num);
+    }
+
+    return Value(str);
+}
@@ -6,12 +6,14 @@
 #include <csignal>
 
 #include "command.hpp"
+#include "resp.hpp"
 #include "lru_cache.hpp"
 #include "globals.hpp"
 #include "unix_times.hpp"
 #include "consistent-hashing.hpp"
 #include "worker.hpp"
 #include "leader.hpp"
+#include "shards.hpp"
 
 std::string endpoint;
 std::mutex endpoint_mutex;
@@ -52,16 +54,202 @@ void start_worker() {
 }
 
 
+std::string serve_commands(std::string_view msg, LRUCache &cache) {
+    // the protocol to reply in, then the requests as RESP arrays viewed in place
+    std::string_view body = msg.substr(1);
+    if (body.empty()) {
+        return "-ERR Protocol error\r\n";
+    }
+
+    resp::Protocol protocol = static_cast<resp::Protocol>(body[0]);
+    std::string_view requests = body.substr(1);
+    std::string response;
+    Tokens args;
+
+    // a batch's requests are replied to in turn, so the leader can split the replies
+    do {
+        size_t consumed;
+        args.clear();
+        if (resp::parse_request(requests, args, consumed) != resp::Status::Complete) {
+            response += "-ERR Protocol error\r\n";
+            break;
+        }
+
+        Command cmd { args, protocol, cache };
+        response += cmd.parse_cmd();
+        requests.remove_prefix(consumed);
+    } while (msg[0] == BATCH && !requests.empty());
+
+    return response;
+}
+
+// replies MOVED if a DIRECT_COMMAND is for a key another node owns. a client's ring may be
+// older than this node's, so it is told who owns the key now
+static bool moved(std::string_view msg, const std::string &worker_pid, std::string &response) {
+    Tokens args;
+    size_t consumed;
+    if (msg.size() < 2 || resp::parse_request(msg.substr(2), args, consumed) != resp::Status::Complete) {
+        return false;
+    }
+
+    const cmd::Spec *spec = cmd::lookup(args.name());
+    std::shared_ptr<ServerNode> owner = spec && spec->routing == cmd::Routing::Key && !args.key().empty()
+        ? ring.get(args.key()) : nullptr;
+
+    if (owner && owner->pid != worker_pid) {
+        response = MOVED + std::to_string(owner->hash) + " " + owner->endpoint;
+        return true;
+    }
+    return false;
+}
+
+// the reply to any message but commands, which may need the shards
+static std::string serve_message(std::string_view msg, const std::string &worker_pid) {
+    std::string msg_body { msg.substr(1) };
+    char type = msg.at(0);
+
+    // leader msgs should end an election
+    switch(type) {
+        case COMMAND:
+        case BATCH:
+        case RING_UPDATE:
+        case ELECTION_VICTORY:
+            if (election_in_progress) {
+                recv_victory = true;
+            }
+            break;
+        default:
+        break;
+    }
+
+    // process msg
+    switch(type) {
+        case COMMAND:
+        case BATCH:
+            return serve_commands(msg, cache);
+        case DIRECT_COMMAND: {
+            std::string response;
+            if (moved(msg, worker_pid, response)) {
+                return response;
+            }
+            return COMMAND + serve_commands(msg, cache);
+        }
+        case NODE_COMMAND: {
+            Tokens tokens { msg_body };
+            if (cmd::nodeCmds(tokens.name()) == cmd::NodeCMDType::Kill &&
+                tokens.key() == worker_pid
+            ) {
+                // the worker exits once the reply is sent
+                stop = true;
+                return "OK";
+            }
+            return "";
+        }
+        case RING_UPDATE:
+            ring.update(msg_body);
+            return std::to_string(ring.size());
+        case CACHE_UPDATE: {
+            int old_size = cache.size();
+            cache.import(msg.substr(1));
+            return std::to_string(cache.size() - old_size);
+        }
+        case ELECTION_MSG:
+            if (!election_in_progress && !recv_victory && !promoted_to_leader) {
+                std::cout << worker_pid << " got ELECTION_MSG. Calling an election..." << std::endl;
+                election_in_progress = true;
+                std::thread election_thread(leader_election);
+                election_thread.detach();
+            }
+
+            return worker_pid;
+        case ELECTION_VICTORY:
+            return "OK";
+        default:
+            return "Missing type char";
+    }
+}
+
+// serves the messages that have arrived on a ROUTER socket, running commands on the shards.
+// replies go back through the frames before the message, which end with an empty delimiter
+static void serve_sharded(zmq::socket_t &socket, Shards &shards, const std::string &worker_pid) {
+    zmq::pollitem_t items[] = {
+        { socket.handle(), 0, ZMQ_POLLIN, 0 },
+        { nullptr, shards.fd(), ZMQ_POLLIN, 0 }
+    };
+    zmq::poll(items, 2, std::chrono::milliseconds(ACTIVE_EXPIRE_INTERVAL_MS));
+
+    shards.collect();
+
+    while (socket.get(zmq::sockopt::events) & ZMQ_POLLIN) {
+        auto envelope = std::make_shared<std::vector<zmq::message_t>>();
+        zmq::message_t request;
+        while (true) {
+            zmq::message_t frame;
+            if (!socket.recv(frame, envelope->empty() ? zmq::recv_flags::dontwait : zmq::recv_flags::none)) {
+                return;
+            }
+
+            if (!frame.more()) {
+                request = std::move(frame);
+                break;
+            }
+            envelope->push_back(std::move(frame));
+        }
+
+        auto send_reply = [&socket, envelope](std::string &&reply) {
+            for (zmq::message_t &frame : *envelope) {
+                socket.send(frame, zmq::send_flags::sndmore);
+            }
+            socket.send(zmq::buffer(reply), zmq::send_flags::none);
+        };
+
+        std::string_view msg = request.to_string_view();
+        if (msg.empty()) {
+            send_reply("");
+            continue;
+        }
+
+        char type = msg[0];
+        if ((type == COMMAND || type == BATCH) && election_in_progress) {
+            recv_victory = true;
+        }
+
+        if (type == DIRECT_COMMAND) {
+            std::string response;
+            if (moved(msg, worker_pid, response)) {
+                send_reply(std::move(response));
+                continue;
+            }
+
+            std::string command { msg };
+            command[0] = COMMAND;
+            shards.submit(command, [send_reply](std::string &&reply) {
+                send_reply(COMMAND + reply);
+            });
+        } else if (!shards.submit(msg, send_reply)) {
+            send_reply(serve_message(msg, worker_pid));
+        }
+    }
+}
+
 void handle_reqs() {
     std::string worker_pid = std::to_string(getpid());
 
-    // open an endpoint
+    // open an endpoint. with executor threads, a ROUTER socket keeps many requests in flight on the shards
     zmq::context_t context(1);
-    zmq::socket_t socket(context, zmq::socket_type::rep);
+    zmq::socket_t socket(context, worker_threads > 1 ? zmq::socket_type::router : zmq::socket_type::rep);
     socket.set(zmq::sockopt::linger, 0);
-    socket.set(zmq::sockopt::rcvtimeo, 1000);
+    socket.set(zmq::sockopt::rcvtimeo, ACTIVE_EXPIRE_INTERVAL_MS);
     socket.bind("tcp://*:0");
 
+    std::unique_ptr<Shards> shards;
+    if (worker_threads > 1) {
+        shards = std::make_unique<Shards>(worker_threads, cache, pin_threads);
+        ring.extract = [&shards](const LRUCache::Group &group, size_t groups) {
+            return shards->extract(group, groups);
+        };
+    }
+
     // set endpoint and unlock mutex
     endpoint = socket.get(zmq::sockopt::last_endpoint);
     endpoint_mutex.unlock();
@@ -69,75 +257,25 @@ void handle_reqs() {
     // listen for requests
     while (true) {
         try {
-            zmq::message_t request;
-            zmq::recv_result_t res = socket.recv(request, zmq::recv_flags::none);
-        
-            std::string response = "";
-            std::string msg = request.to_string();
-
-            if (msg.size() > 0) {
-                std::string msg_body = msg.substr(1);
-                char type = msg.at(0);
-
-                // leader msgs should end an election
-                switch(type) {
-                    case COMMAND:
-                    case RING_UPDATE:
-                    case ELECTION_VICTORY:
-                        if (election_in_progress) {
-                            recv_victory = true;
-                        }
-                        break;
-                    default:
-                    break;
+            if (shards) {
+                serve_sharded(socket, *shards, worker_pid);
+            } else {
+                zmq::message_t request;
+                zmq::recv_result_t res = socket.recv(request, zmq::recv_flags::none);
+                if (!res.has_value()) {
+                    throw std::strerror(errno);
                 }
 
-                // process msg
-                switch(type) {
-                    case COMMAND: {
-                        Command cmd { msg_body };
-                        response = cmd.parse_cmd();
-                        break;
-                    } 
-                    case NODE_COMMAND:
-                        if (cmd::nodeCmds(cmd::extract_name(msg_body)) == cmd::NodeCMDType::Kill && 
-                            cmd::extract_key(msg_body) == worker_pid
-                        ) {
-                            socket.send(zmq::buffer("OK"), zmq::send_flags::none);
-                            std::cout << "Stopping " << worker_pid << std::endl;
-                            exit(EXIT_SUCCESS);
-                        }
-                        break;
-                    case RING_UPDATE:
-                        ring.update(msg_body);
-                        response = std::to_string(ring.size());  
-                        break;
-                    case CACHE_UPDATE: {
-                        int old_size = cache.size();
-                        cache.import(msg_body);
-                        response = std::to_string(cache.size() - old_size);
-                        break;
-                    }
-                    case ELECTION_MSG:
-                        if (!election_in_progress && !recv_victory && !promoted_to_leader) {
-                            std::cout << worker_pid << " got ELECTION_MSG. Calling an election..." << std::endl;
-                            election_in_progress = true;
-                            std::thread election_thread(leader_election);
-                            election_thread.detach();
-                        }
-
-                        response = worker_pid;
-                        break;
-                    case ELECTION_VICTORY:
-                        response = "OK";
-                        break;
-                    default:
-                        response = "Missing type char";
-                }
+                std::string response = request.empty() ? "" : serve_message(request.to_string_view(), worker_pid);
+                socket.send(zmq::buffer(response), zmq::send_flags::none);
             }
-            socket.send(zmq::buffer(response), zmq::send_flags::none);
         } catch (...) {
         }
+
+        // reclaim expired keys between requests. shards expire their own
+        if (!shards) {
+            cache.active_expire();
+        }
         
         if (stop) {
             std::cout << "Stopping worker node pid " << worker_pid << std::endl;
@@ -145,6 +283,14 @@ void handle_reqs() {
         }
 
         if (got_SIGUSR1) {
+            if (shards) {
+                // the leader serves keys from the global cache, so the shards' entries are moved into it.
+                // the bounds cover the whole ring
+                ring.extract = nullptr;
+                for (const std::string &entries : shards->extract({ 0, 0 })) {
+                    cache.import(entries);
+                }
+            }
             return;
         }
     }
@@ -156,7 +302,7 @@ void handle_pings() {
     endpoint_mutex.unlock();
 
     std::string worker_pid = std::to_string(getpid());
-    std::string ping = worker_pid + " " + endpoint;
+    std::string ping = worker_pid + " " + endpoint + " " + std::to_string(node_weight);
     std::string leader_endpoint = "tcp://localhost:" + std::to_string(internal_port);
 
     // open connection to leader to send endpoint of this
@@ -168,7 +314,7 @@ void handle_pings() {
     leader_socket.connect(leader_endpoint);
             
     while (true) {        
-        // send pid and endpoint to leader
+        // send pid, endpoint, and weight to leader
         leader_socket.send(zmq::message_t(ping), zmq::send_flags::none);
         bool got_reply = false;
         while (!got_reply) {
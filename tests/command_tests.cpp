@@ -4,15 +4,6 @@
 #include "globals.hpp"
 #include "unix_times.hpp"
 
-bool monitoring = false;
-bool stop = false;
-LRUCache cache {};
-int secs_offset = 0;
-int ms_offset = 0;
-int client_port = 5555;
-int internal_port = -1;
-ConsistentHashing ring;
-
 class CommandTests: public ::testing::Test {
 protected:
     void SetUp() override {
@@ -36,14 +27,18 @@ TEST_F(CommandTests, ExtractKey) {
     EXPECT_EQ(cmd::extract_key("1 2"), "2");
     EXPECT_EQ(cmd::extract_key("1"), "");
     EXPECT_EQ(cmd::extract_key(""), "");
+    EXPECT_EQ(cmd::extract_key("memory usage a"), "a");
+    EXPECT_EQ(cmd::extract_key("MEMORY usage a"), "a");
+    EXPECT_EQ(cmd::extract_key("memory usage"), "");
 }
 TEST_F(CommandTests, Sets) {
     EXPECT_EQ(cmd::addAll("dbsize"), true);
-    EXPECT_EQ(cmd::addAll("exists"), true);
+    EXPECT_EQ(cmd::addAll("exists"), false);
     EXPECT_EQ(cmd::addAll("get"), false);
 
     EXPECT_EQ(cmd::concatAll("keys"), true);
     EXPECT_EQ(cmd::concatAll("dist"), true);
+    EXPECT_EQ(cmd::concatAll("info"), true);
     EXPECT_EQ(cmd::concatAll("get"), false);
 
     EXPECT_EQ(cmd::askAll("flushall"), true);
@@ -56,6 +51,95 @@ TEST_F(CommandTests, Sets) {
     EXPECT_EQ(cmd::nodeCmds("get"), cmd::NodeCMDType::Not);
 }
 
+TEST_F(CommandTests, Lookup) {
+    const cmd::Spec *get = cmd::lookup("get");
+    ASSERT_NE(get, nullptr);
+    EXPECT_EQ(get->name, "get");
+    EXPECT_EQ(get->routing, cmd::Routing::Key);
+    EXPECT_EQ(get->flags, cmd::READ);
+
+    // names match ignoring case
+    EXPECT_EQ(cmd::lookup("GeT"), get);
+    EXPECT_EQ(cmd::addAll("DBSIZE"), true);
+
+    EXPECT_EQ(cmd::lookup("set")->flags, cmd::WRITE);
+    EXPECT_EQ(cmd::lookup("ping")->routing, cmd::Routing::Local);
+    EXPECT_EQ(cmd::lookup("kill")->routing, cmd::Routing::Node);
+    EXPECT_EQ(cmd::lookup("exists")->routing, cmd::Routing::Keys);
+    EXPECT_EQ(cmd::lookup("mset")->routing, cmd::Routing::Pairs);
+
+    EXPECT_EQ(cmd::lookup(""), nullptr);
+    EXPECT_EQ(cmd::lookup("notacommand"), nullptr);
+    EXPECT_EQ(cmd::lookup("getgetgetgetgetgetget"), nullptr);
+}
+
+TEST_F(CommandTests, TooFewArgs) {
+    Command get { "get" };
+    EXPECT_EQ(get.parse_cmd(), "(NIL)");
+
+    Command persist { "persist" };
+    EXPECT_EQ(persist.parse_cmd(), "FAILURE");
+
+    Command incrby { "incrby a" };
+    EXPECT_EQ(incrby.parse_cmd(), "FAILURE");
+
+    // node commands are only run by the leader
+    Command nodes { "nodes" };
+    EXPECT_EQ(nodes.parse_cmd(), "Invalid Command");
+}
+
+TEST_F(CommandTests, UppercaseNames) {
+    Command lpush { "LPUSH a 1 2" };
+    EXPECT_EQ(lpush.parse_cmd(), "2");
+
+    Command rpop { "RPOP a" };
+    EXPECT_EQ(rpop.parse_cmd(), "1");
+
+    Command decrby { "DECRBY b 5" };
+    EXPECT_EQ(decrby.parse_cmd(), "-5");
+}
+
+TEST_F(CommandTests, RespReplies) {
+    auto run = [](std::string request, resp::Protocol protocol = resp::Protocol::RESP2) {
+        Tokens args;
+        resp::Protocol parsed;
+        EXPECT_TRUE(resp::parse_message(request, args, parsed));
+        Command cmd { args, protocol };
+        return cmd.parse_cmd();
+    };
+
+    // values are binary safe, so spaces don't make a list
+    EXPECT_EQ(run("*3\r\n$3\r\nset\r\n$1\r\na\r\n$6\r\nx y\r\nz\r\n"), "+OK\r\n");
+    EXPECT_EQ(run("*2\r\n$4\r\ntype\r\n$1\r\na\r\n"), "+string\r\n");
+    EXPECT_EQ(run("*2\r\n$3\r\nget\r\n$1\r\na\r\n"), "$6\r\nx y\r\nz\r\n");
+
+    EXPECT_EQ(run("*2\r\n$3\r\nget\r\n$1\r\nb\r\n"), "$-1\r\n");
+    EXPECT_EQ(run("*2\r\n$3\r\nget\r\n$1\r\nb\r\n", resp::Protocol::RESP3), "_\r\n");
+    EXPECT_EQ(run("*1\r\n$3\r\nget\r\n"), "$-1\r\n");
+
+    EXPECT_EQ(run("*4\r\n$5\r\nrpush\r\n$1\r\nl\r\n$1\r\n1\r\n$3\r\na b\r\n"), ":2\r\n");
+    EXPECT_EQ(run("*2\r\n$6\r\nlrange\r\n$1\r\nl\r\n"), "*2\r\n$1\r\n1\r\n$3\r\na b\r\n");
+    EXPECT_EQ(run("*2\r\n$4\r\nincr\r\n$1\r\na\r\n"), "-ERR NOT AN INT\r\n");
+    EXPECT_EQ(run("*1\r\n$6\r\ndbsize\r\n"), ":2\r\n");
+    EXPECT_EQ(run("*1\r\n$4\r\nnope\r\n"), "-ERR Invalid Command\r\n");
+
+    // inline requests can be answered in RESP too
+    EXPECT_EQ(run("exists a l"), ":2\r\n");
+}
+
+TEST_F(CommandTests, Hello) {
+    std::string hello3 = "hello 3";
+    Command cmd { hello3 };
+    EXPECT_EQ(cmd.parse_cmd(), "%2\r\n$6\r\nserver\r\n$11\r\nredis-clone\r\n$5\r\nproto\r\n:3\r\n");
+    EXPECT_EQ(cmd.get_protocol(), resp::Protocol::RESP3);
+
+    Command hello2 { "hello 2" };
+    EXPECT_EQ(hello2.parse_cmd(), "*4\r\n$6\r\nserver\r\n$11\r\nredis-clone\r\n$5\r\nproto\r\n:2\r\n");
+
+    Command bad { "hello 4" };
+    EXPECT_EQ(bad.parse_cmd(), "NOPROTO unsupported protocol version");
+}
+
 TEST_F(CommandTests, EmptyCommand) {
     Command cmd { "" };
     EXPECT_EQ(cmd.parse_cmd(), "No Command Entered");
@@ -249,6 +333,24 @@ TEST_F(CommandTests, Dist) {
     EXPECT_EQ(dist3.parse_cmd(), start + ": 0]");
 }
 
+TEST_F(CommandTests, MgetMset) {
+    Command mset { "mset a 1 b 2 c x" };
+    EXPECT_EQ(mset.parse_cmd(), "SUCCESS");
+
+    Command mget { "mget a z c" };
+    EXPECT_EQ(mget.parse_cmd(), "1 (NIL) x");
+
+    Command missing_value { "mset a 1 b" };
+    EXPECT_EQ(missing_value.parse_cmd(), "FAILURE");
+
+    Command too_few { "mget" };
+    EXPECT_EQ(too_few.parse_cmd(), "FAILURE");
+
+    std::string request = "mget b z";
+    Command resp { Tokens { request }, resp::Protocol::RESP2 };
+    EXPECT_EQ(resp.parse_cmd(), "*2\r\n$1\r\n2\r\n$-1\r\n");
+}
+
 TEST_F(CommandTests, Exists) {
     Command exists_empty { "exists a b c" };
     EXPECT_EQ(exists_empty.parse_cmd(), "0");
@@ -313,7 +415,8 @@ TEST_F(CommandTests, ExpireAt) {
     Command set { "set a 1" };
     EXPECT_EQ(set.parse_cmd(), "SUCCESS");
 
-    Command expire { "expireat a " + std::to_string(time_secs() + 50)};
+    std::string expireat = "expireat a " + std::to_string(time_secs() + 50);
+    Command expire { expireat };
     EXPECT_EQ(expire.parse_cmd(), "SUCCESS");
 
     Command get_a { "get a" };
@@ -689,12 +792,102 @@ TEST_F(CommandTests, Hash) {
     EXPECT_EQ(empty.parse_cmd(), "FAILURE");
 
     Command hash1 { "hash 10" };
-    EXPECT_EQ(hash1.parse_cmd(), "103");
+    EXPECT_EQ(hash1.parse_cmd(), "16471181070848109824");
 
     Command hash2 { "hash unix" };
-    EXPECT_EQ(hash2.parse_cmd(), "115");
+    EXPECT_EQ(hash2.parse_cmd(), "15779097703208559609");
 
     Command hash3 { "hash abc123" };
-    EXPECT_EQ(hash3.parse_cmd(), "249");
+    EXPECT_EQ(hash3.parse_cmd(), "11730385095933809950");
 }
 
+
+
+TEST_F(CommandTests, MemoryUsage) {
+    Command none { "memory usage a" };
+    EXPECT_EQ(none.parse_cmd(), "(NIL)");
+
+    Command missing_key { "memory usage" };
+    EXPECT_EQ(missing_key.parse_cmd(), "FAILURE");
+
+    Command set { "set a 1" };
+    EXPECT_EQ(set.parse_cmd(), "SUCCESS");
+
+    Command usage { "memory usage a" };
+    long int_usage = std::stol(usage.parse_cmd());
+    EXPECT_GT(int_usage, 0);
+
+    // a list costs more than an int and grows a chunk at a time
+    Command rpush { "rpush b 1 2 3" };
+    EXPECT_EQ(rpush.parse_cmd(), "3");
+
+    Command list_usage { "MEMORY USAGE b" };
+    long three_elements = std::stol(list_usage.parse_cmd());
+    EXPECT_GT(three_elements, int_usage);
+
+    // a few more elements fit in the same chunk
+    Command rpush_more { "rpush b 4 5 6" };
+    EXPECT_EQ(rpush_more.parse_cmd(), "6");
+    long six_elements = std::stol(list_usage.parse_cmd());
+    EXPECT_EQ(six_elements, three_elements);
+
+    std::string many = "rpush b";
+    for (int i = 0; i < 200; i++) {
+        many += " 7";
+    }
+    Command rpush_many { many };
+    EXPECT_EQ(rpush_many.parse_cmd(), "206");
+    long many_elements = std::stol(list_usage.parse_cmd());
+    EXPECT_GT(many_elements, six_elements);
+
+    // emptied chunks are freed
+    Command lpop { "lpop b 203" };
+    EXPECT_EQ(lpop.parse_cmd().substr(0, 13), "1 2 3 4 5 6 7");
+    EXPECT_EQ(std::stol(list_usage.parse_cmd()), three_elements);
+
+    EXPECT_EQ(cache.memory(), int_usage + three_elements);
+}
+
+TEST_F(CommandTests, Slabs) {
+    Command set_a { "set a 1" };
+    EXPECT_EQ(set_a.parse_cmd(), "SUCCESS");
+
+    Command push { "rpush list a b" };
+    EXPECT_EQ(push.parse_cmd(), "2");
+
+    std::string start = "[node " + std::to_string(getpid()) + ": entries(size=";
+    Command slabs { "slabs" };
+    std::string res = slabs.parse_cmd();
+    EXPECT_EQ(res.substr(0, start.size()), start);
+    EXPECT_NE(res.find(" used=2 slabs=1 bytes=" + std::to_string(SLAB_SIZE) + ") chunks(size="), std::string::npos);
+    EXPECT_NE(res.find(" used=1 slabs=1 "), std::string::npos);
+
+    // flushall drops the slabs
+    Command flushall { "flushall" };
+    flushall.parse_cmd();
+    res = slabs.parse_cmd();
+    EXPECT_NE(res.find(" used=0 slabs=0 bytes=0) chunks("), std::string::npos);
+}
+
+TEST_F(CommandTests, Info) {
+    std::string start = "[node " + std::to_string(getpid()) + ": keys=";
+
+    Command set_a { "set a 1" };
+    EXPECT_EQ(set_a.parse_cmd(), "SUCCESS");
+
+    Command expire { "expire a 10" };
+    expire.parse_cmd();
+
+    Command info { "info" };
+    std::string res = info.parse_cmd();
+    EXPECT_EQ(res.substr(0, start.size() + 1), start + "1");
+    EXPECT_NE(res.find("expires=1 expired_keys=0 expired_per_sec=0.0]"), std::string::npos);
+    EXPECT_NE(res.find(" eviction=lru "), std::string::npos);
+
+    secs_offset = 100;
+    cache.active_expire();
+
+    res = info.parse_cmd();
+    EXPECT_EQ(res.substr(0, start.size() + 1), start + "0");
+    EXPECT_NE(res.find("expires=0 expired_keys=1 expired_per_sec=0.1]"), std::string::npos);
+}
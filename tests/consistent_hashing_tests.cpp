@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include <thread>
+#include <atomic>
 #include <zmq.hpp>
 
 #include "consistent-hashing.hpp"
@@ -8,6 +9,17 @@
 
 std::string PREFIX = std::string { CACHE_UPDATE };
 
+// an entry as LRUCache::extract writes it
+static std::string entry(const std::string &key, const std::string &value) {
+    return "*2\r\n$" + std::to_string(key.size()) + "\r\n" + key + "\r\n"
+        + "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+}
+
+static std::string entry(const std::string &key, int64_t num) {
+    return "*2\r\n$" + std::to_string(key.size()) + "\r\n" + key + "\r\n"
+        + ":" + std::to_string(num) + "\r\n";
+}
+
 // echos one request
 void create_echo_socket(std::string port) {
     zmq::context_t context(1);
@@ -116,18 +128,75 @@ TEST(ConsistentHashingTests, ConsistentHashing) {
     two.join();
     three.join();
 
-    std::string hash_2 = "two";
-    std::string hash_152 = "cool";
-    std::string hash_339 = "a";
-    std::string hash_343 = "do";
-
-    // b -> 128
-    // a - > 289
-    // c -> 342
-    EXPECT_EQ(ch_ring.get(hash_2), node_c);
-    EXPECT_EQ(ch_ring.get(hash_152), node_b);
-    EXPECT_EQ(ch_ring.get(hash_339), node_a);
-    EXPECT_EQ(ch_ring.get(hash_343), node_c);
+    std::string before_a = "b"; // 4922105486923917368
+    std::string after_a = "s"; // 11834818205269833459
+    std::string after_b = "d"; // 16430000378845041108
+    std::string after_c = "cm"; // 18303938331386113134
+
+    // a -> 11273408151714612001
+    // b -> 15097357931225601835
+    // c -> 18283465577884674279
+    EXPECT_EQ(ch_ring.get(before_a).get(), node_c);
+    EXPECT_EQ(ch_ring.get(after_a).get(), node_a);
+    EXPECT_EQ(ch_ring.get(after_b).get(), node_b);
+    EXPECT_EQ(ch_ring.get(after_c).get(), node_c);
+}
+
+TEST(ConsistentHashingTests, VirtualNodes) {
+    ConsistentHashing ch_ring;
+    ch_ring.add("one", "tcp://localhost:5001", true, 32);
+    ch_ring.add("two", "tcp://localhost:5002", false, 32);
+    ch_ring.add("three", "tcp://localhost:5003", false, 32);
+    EXPECT_EQ(ch_ring.size(), 3);
+    EXPECT_EQ(ch_ring.point_count(), 96);
+
+    // a node's first point is where it would be without virtual nodes
+    EXPECT_EQ(vnode_hash("one", "tcp://localhost:5001", 0), hash_function("onetcp://localhost:5001"));
+
+    // every node owns part of the ring, and together all of it
+    double total = 0;
+    for (const auto &[pid, owned] : ch_ring.ownership()) {
+        EXPECT_GT(owned, 0);
+        total += owned;
+    }
+    EXPECT_NEAR(total, 1, 1e-9);
+
+    // another ring built from this one's internal string places keys the same way
+    ConsistentHashing ch_ring2;
+    ch_ring2.update(ch_ring.to_internal_string());
+    EXPECT_EQ(ch_ring2.point_count(), 96);
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_EQ(ch_ring2.get(key)->pid, ch_ring.get(key)->pid);
+    }
+
+    std::string report = ch_ring.skew_report({ { "one", 10 }, { "two", 10 }, { "three", 40 } });
+    EXPECT_NE(report.find("[node two: 10 keys"), std::string::npos);
+    EXPECT_NE(report.find("keys max/mean: 2.00"), std::string::npos);
+}
+
+TEST(ConsistentHashingTests, LookupsDuringChanges) {
+    ConsistentHashing ch_ring;
+    ch_ring.add("one", "tcp://localhost:5001", true, 16);
+
+    // lookups don't lock, and always find a node while others join
+    std::atomic<bool> done { false };
+    std::thread reader([&]() {
+        while (!done) {
+            for (int i = 0; i < 100; i++) {
+                ASSERT_NE(ch_ring.get("key" + std::to_string(i)), nullptr);
+            }
+        }
+    });
+
+    for (int i = 2; i < 50; i++) {
+        ch_ring.add(std::to_string(i), "tcp://localhost:" + std::to_string(5000 + i), false, 16);
+    }
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(ch_ring.size(), 49);
+    EXPECT_EQ(ch_ring.point_count(), 49 * 16);
 }
 
 TEST(ConsistentHashingTests, Removing) {
@@ -174,6 +243,22 @@ TEST(ConsistentHashingTests, MarkForRemoval) {
     EXPECT_EQ(ch_ring.get_by_pid("three"), node_three);
 }
 
+TEST(ConsistentHashingTests, LookupOutlivesRemoval) {
+    ConsistentHashing ch_ring;
+    EXPECT_TRUE(ch_ring.add("one", "tcp://localhost:25551", false) != nullptr);
+
+    // a node a lookup returned stays valid after it leaves the ring
+    std::shared_ptr<ServerNode> node = ch_ring.get("a");
+    ASSERT_NE(node, nullptr);
+    node->mark_for_removal();
+    ch_ring.clean_up_old_nodes();
+
+    EXPECT_EQ(ch_ring.size(), 0);
+    EXPECT_EQ(ch_ring.get("a"), nullptr);
+    EXPECT_EQ(node->pid, "one");
+    EXPECT_EQ(node.use_count(), 1);
+}
+
 TEST(ConsistentHashingTests, ConnectionsUpdate) {
     cache = LRUCache();
     EXPECT_EQ(cache.size(), 0);
@@ -189,27 +274,27 @@ TEST(ConsistentHashingTests, ConnectionsUpdate) {
     EXPECT_TRUE(ch_ring.add("two", "tcp://localhost:25552", true) != nullptr);
 
     /*        
-        Worker pid: four. Hash: 173
-        Worker pid: two. Hash: 183 **
-        Worker pid: three. Hash: 318 
-        Worker pid: one. Hash: 349
+        Worker pid: two. Hash: 712397309754819450 **
+        Worker pid: four. Hash: 14514418567251193740
+        Worker pid: one. Hash: 15824162215675637843
+        Worker pid: three. Hash: 17157065688738567552
     */
 
-    // one
-    cache.add("ztybwklsxwb", new StringEntry("z")); //349
-    cache.add("j", new StringEntry("j")); //59
+    // two
+    cache.add("g", Value("g")); //4761086876206992583
+    cache.add("c", Value("c")); //6008362896953459077
 
     // four
-    cache.add("vbecgeeh", new StringEntry("v")); //176
-    cache.add("goxwizagf", new StringEntry("g")); //181
+    cache.add("1", Value("1")); //14530020785791580170
+    cache.add("v", Value("v")); //14559572909495141224
 
-    // two
-    cache.add("n", new StringEntry("n")); //251
-    cache.add("c", new StringEntry("c")); //269
+    // one
+    cache.add("d", Value("d")); //16430000378845041108
+    cache.add("m", Value("m")); //16667924440332593712
 
-    // three
-    cache.add("we", new StringEntry("we")); //337
-    cache.add("weo", new StringEntry("weo")); //341
+    // three, wrapping around
+    cache.add("h", Value("h")); //17936806579536567440
+    cache.add("l", Value("l")); //358915293812505768
 
 
     ServerNode *node_two = ch_ring.get_by_pid("two");
@@ -229,15 +314,15 @@ TEST(ConsistentHashingTests, ConnectionsUpdate) {
     
     ServerNode *node2_two = ch_ring.get_by_pid("two");
     EXPECT_EQ(node2_two->is_leader, true);
-    EXPECT_FALSE(ch_ring.is_begin(node2_two));
+    EXPECT_TRUE(ch_ring.is_begin(node2_two));
 
 
     
     ServerNode *node2_one = ch_ring.get_by_pid("one");
     EXPECT_EQ(node2_one->is_leader, false);
     std::string one_cache = send_str(node2_one, "1");
-    std::string exp1_v1 = PREFIX + "ztybwklsxwb\nz\nj\nj\n";
-    std::string exp1_v2 = PREFIX + "j\nj\nztybwklsxwb\nz\n";
+    std::string exp1_v1 = PREFIX + entry("d", "d") + entry("m", "m");
+    std::string exp1_v2 = PREFIX + entry("m", "m") + entry("d", "d");
     EXPECT_TRUE(one_cache == exp1_v1 || one_cache == exp1_v2); 
     EXPECT_FALSE(ch_ring.is_begin(node2_one));
 
@@ -245,8 +330,8 @@ TEST(ConsistentHashingTests, ConnectionsUpdate) {
     ServerNode *node2_three = ch_ring.get_by_pid("three");
     EXPECT_EQ(node2_three->is_leader, false);
     std::string three_cache = send_str(node2_three, "2");
-    std::string exp3_v1 = PREFIX + "we\nwe\nweo\nweo\n";
-    std::string exp3_v2 = PREFIX + "weo\nweo\nwe\nwe\n";
+    std::string exp3_v1 = PREFIX + entry("h", "h") + entry("l", "l");
+    std::string exp3_v2 = PREFIX + entry("l", "l") + entry("h", "h");
     EXPECT_TRUE(three_cache == exp3_v1 || three_cache == exp3_v2); 
     EXPECT_FALSE(ch_ring.is_begin(node2_three));
 
@@ -254,10 +339,10 @@ TEST(ConsistentHashingTests, ConnectionsUpdate) {
     ServerNode *node2_four = ch_ring.get_by_pid("four");
     EXPECT_EQ(node2_four->is_leader, false);
     std::string four_cache = send_str(node2_four, "2");
-    std::string exp4_v1 = PREFIX + "vbecgeeh\nv\ngoxwizagf\ng\n";
-    std::string exp4_v2 = PREFIX + "goxwizagf\ng\nvbecgeeh\nv\n";
+    std::string exp4_v1 = PREFIX + entry("1", 1) + entry("v", "v");
+    std::string exp4_v2 = PREFIX + entry("v", "v") + entry("1", 1);
     EXPECT_TRUE(four_cache == exp4_v1 || four_cache == exp4_v2); 
-    EXPECT_TRUE(ch_ring.is_begin(node2_four));
+    EXPECT_FALSE(ch_ring.is_begin(node2_four));
 
 
     one.join();
@@ -272,8 +357,10 @@ TEST(ConsistentHashingTests, ConnectionsUpdate2) {
     std::thread one(create_echo_socket, "25551");
     std::thread three(create_echo_socket, "25553");
 
+    // should not receive an update string, its range wasn't this node's
+    std::thread two(create_echo_socket, "25552");
+
     // will recieve an updated string
-    std::thread two(create_persist_socket, "25552");
     std::thread four(create_persist_socket, "25554");
 
     ConsistentHashing ch_ring {"five"}; //treat five as this node
@@ -282,15 +369,15 @@ TEST(ConsistentHashingTests, ConnectionsUpdate2) {
     EXPECT_TRUE(ch_ring.add("five", "tcp://localhost:25555", true) != nullptr);
 
     /*
-        Leader pid: five. Hash: 112 **
-        Worker pid: four. Hash: 173
-        Worker pid: two. Hash: 183
-        Worker pid: three. Hash: 318 **
-        Worker pid: one. Hash: 349
+        Worker pid: two. Hash: 712397309754819450
+        Leader pid: five. Hash: 6257212844030556458 **
+        Worker pid: four. Hash: 14514418567251193740
+        Worker pid: one. Hash: 15824162215675637843 **
+        Worker pid: three. Hash: 17157065688738567552
     */
-    cache.add("l", new StringEntry("l")); //134
-    cache.add("36", new StringEntry("36")); //175
-    cache.add("c", new StringEntry("c")); //269
+    cache.add("n", Value("n")); //7042947045311795759
+    cache.add("1", Value("1")); //14530020785791580170
+    cache.add("v", Value("v")); //14559572909495141224
 
 
     ServerNode *node_one = ch_ring.get_by_pid("one");
@@ -322,13 +409,14 @@ TEST(ConsistentHashingTests, ConnectionsUpdate2) {
     
     ServerNode *node2_two = ch_ring.get_by_pid("two");
     EXPECT_EQ(node2_two->is_leader, false);
-    std::string exp2 = PREFIX + "c\nc\n";
-    EXPECT_EQ(send_str(node2_two, "2"), exp2);
+    EXPECT_EQ(send_str(node2_two, "Hi from 2"), "Hi from 2");
 
     ServerNode *node2_four = ch_ring.get_by_pid("four");
     EXPECT_EQ(node2_four->is_leader, false);
-    std::string exp4 = PREFIX + "36\n36\n";
-    EXPECT_EQ(send_str(node2_four, "4"), exp4);
+    std::string four_cache = send_str(node2_four, "4");
+    std::string exp4_v1 = PREFIX + entry("1", 1) + entry("v", "v");
+    std::string exp4_v2 = PREFIX + entry("v", "v") + entry("1", 1);
+    EXPECT_TRUE(four_cache == exp4_v1 || four_cache == exp4_v2); 
 
 
     two.join();
@@ -343,26 +431,26 @@ TEST(ConsistentHashingTests, ConnectionsUpdateWrapAround) {
     std::thread two(create_echo_socket, "25552");
 
     // should not receive an update string
-    std::thread three(create_echo_socket, "25553");
+    std::thread four(create_echo_socket, "25554");
+    std::thread five(create_echo_socket, "25555");
 
     // will recieve an updated string
-    std::thread four(create_persist_socket, "25554");
-    std::thread five(create_persist_socket, "25555");
+    std::thread three(create_persist_socket, "25553");
 
     ConsistentHashing ch_ring {"one"}; 
     EXPECT_TRUE(ch_ring.add("one", "tcp://localhost:25551", false) != nullptr);
     EXPECT_TRUE(ch_ring.add("two", "tcp://localhost:25552", false) != nullptr);
 
     /*
-        Worker pid: five. Hash: 112 
-        Worker pid: four. Hash: 173
-        Worker pid: two. Hash: 183 **
-        Leader pid: three. Hash: 318 
-        Worker pid: one. Hash: 349 **
+        Worker pid: two. Hash: 712397309754819450 **
+        Worker pid: five. Hash: 6257212844030556458
+        Worker pid: four. Hash: 14514418567251193740
+        Worker pid: one. Hash: 15824162215675637843 **
+        Leader pid: three. Hash: 17157065688738567552
     */
-    cache.add("l", new StringEntry("l")); //134
-    cache.add("36", new StringEntry("36")); //175
-    cache.add("b", new StringEntry("b")); //37
+    cache.add("d", Value("d")); //16430000378845041108
+    cache.add("h", Value("h")); //17936806579536567440
+    cache.add("l", Value("l")); //358915293812505768
 
 
     ServerNode *node_one = ch_ring.get_by_pid("one");
@@ -392,19 +480,21 @@ TEST(ConsistentHashingTests, ConnectionsUpdateWrapAround) {
     ServerNode *node2_two = ch_ring.get_by_pid("two");
     EXPECT_EQ(node2_two->is_leader, false);
 
+    // three's range wraps around the end of the ring
     ServerNode *node2_three = ch_ring.get_by_pid("three");
     EXPECT_EQ(node2_three->is_leader, true);
-    EXPECT_EQ(send_str(node2_three, "Hi from 3"), "Hi from 3");
+    std::string three_cache = send_str(node2_three, "3");
+    std::string exp3_v1 = PREFIX + entry("h", "h") + entry("l", "l");
+    std::string exp3_v2 = PREFIX + entry("l", "l") + entry("h", "h");
+    EXPECT_TRUE(three_cache == exp3_v1 || three_cache == exp3_v2); 
 
     ServerNode *node2_four = ch_ring.get_by_pid("four");
     EXPECT_EQ(node2_four->is_leader, false);
-    std::string exp2 = PREFIX + "36\n36\n";
-    EXPECT_EQ(send_str(node2_four, "4"), exp2);
+    EXPECT_EQ(send_str(node2_four, "Hi from 4"), "Hi from 4");
 
     ServerNode *node2_five = ch_ring.get_by_pid("five");
     EXPECT_EQ(node2_five->is_leader, false);
-    std::string exp5 = PREFIX + "l\nl\n";
-    EXPECT_EQ(send_str(node2_five, "5"), exp5);
+    EXPECT_EQ(send_str(node2_five, "Hi from 5"), "Hi from 5");
 
     three.join();
     four.join();
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+
+#include "entry_list.hpp"
+#include "entries/cache_entry.hpp"
+
+TEST(EntryListTests, Empty) {
+    EntryList list;
+    EXPECT_EQ(list.get_size(), 0);
+    EXPECT_EQ(list.front(), nullptr);
+    EXPECT_EQ(list.remove_front(), nullptr);
+    EXPECT_EQ(list.keys().size(), 0);
+}
+
+TEST(EntryListTests, AddAndRemove) {
+    EntryList list;
+
+    CacheEntry *a = new CacheEntry("a");
+    CacheEntry *b = new CacheEntry("b");
+    CacheEntry *c = new CacheEntry("c");
+
+    list.add_end(b);
+    list.add_end(c);
+    list.add_front(a);
+
+    std::vector<std::string> exp_all {"a", "b", "c"};
+    EXPECT_EQ(list.keys(), exp_all);
+    EXPECT_EQ(list.get_size(), 3);
+    EXPECT_EQ(list.front(), a);
+    EXPECT_EQ(list.back(), c);
+
+    // unlinking does not free the entry
+    EXPECT_EQ(list.remove(b), b);
+    std::vector<std::string> exp_ac {"a", "c"};
+    EXPECT_EQ(list.keys(), exp_ac);
+    EXPECT_EQ(b->prev, nullptr);
+    EXPECT_EQ(b->next, nullptr);
+    delete b;
+
+    EXPECT_EQ(list.remove_front(), a);
+    delete a;
+    EXPECT_EQ(list.front(), c);
+    EXPECT_EQ(list.back(), c);
+    EXPECT_EQ(list.get_size(), 1);
+}
+
+TEST(EntryListTests, Move) {
+    EntryList list;
+
+    CacheEntry *a = new CacheEntry("a");
+    CacheEntry *b = new CacheEntry("b");
+    CacheEntry *c = new CacheEntry("c");
+    list.add_end(a);
+    list.add_end(b);
+    list.add_end(c);
+
+    list.move_to_end(a);
+    std::vector<std::string> exp1 {"b", "c", "a"};
+    EXPECT_EQ(list.keys(), exp1);
+
+    list.move_to_end(a);
+    EXPECT_EQ(list.keys(), exp1);
+
+    list.move_to_front(c);
+    std::vector<std::string> exp2 {"c", "b", "a"};
+    EXPECT_EQ(list.keys(), exp2);
+    EXPECT_EQ(list.keys(true)[0], "c b a");
+    EXPECT_EQ(list.get_size(), 3);
+}
+
+TEST(EntryListTests, Expired) {
+    EntryList list;
+
+    CacheEntry *a = new CacheEntry("a");
+    CacheEntry *b = new CacheEntry("b");
+    b->expiration = 1;
+    list.add_end(a);
+    list.add_end(b);
+
+    std::vector<std::string> exp {"a"};
+    EXPECT_EQ(list.keys(), exp);
+    EXPECT_EQ(list.get_size(), 2);
+}
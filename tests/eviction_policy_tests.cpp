@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+#include <vector>
+
+#include "eviction_policy.hpp"
+#include "lru_cache.hpp"
+#include "entries/value.hpp"
+
+TEST(EvictionPolicyTests, MakePolicy) {
+    EXPECT_EQ(make_eviction_policy("lru")->name(), "lru");
+    EXPECT_EQ(make_eviction_policy("sampled")->name(), "sampled");
+    EXPECT_EQ(make_eviction_policy("clock")->name(), "clock");
+    EXPECT_EQ(make_eviction_policy("random"), nullptr);
+}
+
+TEST(EvictionPolicyTests, ClockSecondChance) {
+    LRUCache cache { 3, 3 };
+    cache.set_eviction(make_eviction_policy("clock"));
+    EXPECT_EQ(cache.eviction(), "clock");
+
+    cache.add("1", Value("a"));
+    cache.add("2", Value("b"));
+    cache.add("3", Value("c"));
+
+    // reads do not reorder the entries
+    EXPECT_NE(cache.get("1"), nullptr);
+    std::vector<std::string> exp1 {"1", "2", "3"};
+    EXPECT_EQ(cache.key_set(), exp1);
+
+    // 1 was referenced, so 2 is evicted and 1 goes around again
+    cache.add("4", Value("d"));
+    EXPECT_EQ(cache.get("2"), nullptr);
+    std::vector<std::string> exp2 {"3", "1", "4"};
+    EXPECT_EQ(cache.key_set(), exp2);
+
+    cache.add("5", Value("e"));
+    EXPECT_EQ(cache.get("3"), nullptr);
+    EXPECT_EQ(cache.size(), 3);
+}
+
+TEST(EvictionPolicyTests, ClockAllReferenced) {
+    LRUCache cache { 3, 3 };
+    cache.set_eviction(make_eviction_policy("clock"));
+
+    cache.add("1", Value("a"));
+    cache.add("2", Value("b"));
+    cache.add("3", Value("c"));
+    cache.get("1");
+    cache.get("2");
+    cache.get("3");
+
+    // one full sweep clears every bit, then the hand evicts where it started
+    cache.add("4", Value("d"));
+    EXPECT_EQ(cache.get("1"), nullptr);
+    EXPECT_EQ(cache.size(), 3);
+}
+
+TEST(EvictionPolicyTests, SampledKeepsHotKeys) {
+    const int size = 100;
+    LRUCache cache { size, size };
+    cache.set_eviction(make_eviction_policy("sampled"));
+
+    for (int i = 0; i < size; i++) {
+        cache.add(std::to_string(i), Value("v"));
+    }
+
+    // keep the first 10 keys hot while streaming new keys through the cache
+    for (int i = size; i < size * 10; i++) {
+        for (int hot = 0; hot < 10; hot++) {
+            cache.get(std::to_string(hot));
+        }
+        cache.add(std::to_string(i), Value("v"));
+        EXPECT_EQ(cache.size(), size);
+    }
+
+    int hot_left = 0;
+    for (int hot = 0; hot < 10; hot++) {
+        if (cache.get(std::to_string(hot))) {
+            hot_left++;
+        }
+    }
+
+    // a hot key is only evicted if all 5 samples are hot, which should be very rare
+    EXPECT_GE(hot_left, 9);
+}
+
+TEST(EvictionPolicyTests, SampledMaxMemory) {
+    LRUCache sizing { };
+    long entry_usage = sizing.add("a", Value("1"))->memory;
+
+    LRUCache cache { 10, 100, entry_usage * 3 };
+    cache.set_eviction(make_eviction_policy("sampled"));
+
+    for (int i = 0; i < 10; i++) {
+        cache.add(std::string(1, 'a' + i), Value("1"));
+        EXPECT_LE(cache.memory(), entry_usage * 3);
+    }
+
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_NE(cache.get("j"), nullptr);
+}
+
+TEST(EvictionPolicyTests, SetEvictionKeepsEntries) {
+    LRUCache cache { 5, 5 };
+    cache.add("1", Value("a"));
+    cache.add("2", Value("b"));
+
+    cache.set_eviction(make_eviction_policy("sampled"));
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.key_set().size(), 2);
+    EXPECT_NE(cache.get("1"), nullptr);
+
+    cache.set_eviction(make_eviction_policy("lru"));
+    cache.remove("1");
+    std::vector<std::string> exp {"2"};
+    EXPECT_EQ(cache.key_set(), exp);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.eviction(), "lru");
+}
+
+TEST(EvictionPolicyTests, TinyLFUScanResistant) {
+    const int size = 100;
+    LRUCache cache { size, size };
+    cache.set_eviction(make_eviction_policy("tinylfu"));
+    EXPECT_EQ(cache.eviction(), "tinylfu");
+
+    // a hot set requested a few times each
+    for (int round = 0; round < 3; round++) {
+        for (int hot = 0; hot < 50; hot++) {
+            if (!cache.get("hot" + std::to_string(hot))) {
+                cache.add("hot" + std::to_string(hot), Value("v"));
+            }
+        }
+    }
+
+    // a scan of one-off keys, several times the size of the cache
+    for (int i = 0; i < size * 5; i++) {
+        cache.add("scan" + std::to_string(i), Value("v"));
+        EXPECT_LE(cache.size(), size);
+    }
+
+    int hot_left = 0;
+    for (int hot = 0; hot < 50; hot++) {
+        if (cache.get("hot" + std::to_string(hot))) {
+            hot_left++;
+        }
+    }
+    EXPECT_EQ(hot_left, 50);
+
+    // plain LRU loses the whole hot set to the same scan
+    LRUCache lru { size, size };
+    for (int hot = 0; hot < 50; hot++) {
+        lru.add("hot" + std::to_string(hot), Value("v"));
+    }
+    for (int i = 0; i < size * 5; i++) {
+        lru.add("scan" + std::to_string(i), Value("v"));
+    }
+    EXPECT_EQ(lru.get("hot0"), nullptr);
+}
+
+TEST(EvictionPolicyTests, TinyLFUAdmitsFrequentKeys) {
+    LRUCache cache { 10, 10 };
+    cache.set_eviction(make_eviction_policy("tinylfu"));
+
+    for (int i = 0; i < 10; i++) {
+        cache.add(std::to_string(i), Value("v"));
+    }
+
+    // a new key that keeps being requested eventually wins admission over a key seen once
+    for (int i = 0; i < 5; i++) {
+        cache.get("new");
+    }
+    cache.add("new", Value("v"));
+    cache.add("other", Value("v"));
+
+    EXPECT_NE(cache.get("new"), nullptr);
+    EXPECT_EQ(cache.size(), 10);
+    EXPECT_EQ(cache.key_set().size(), 10);
+}
+
+TEST(EvictionPolicyTests, TinyLFUMaxMemory) {
+    LRUCache sizing { };
+    long entry_usage = sizing.add("a", Value("1"))->memory;
+
+    LRUCache cache { 10, 100, entry_usage * 3 };
+    cache.set_eviction(make_eviction_policy("tinylfu"));
+
+    for (int i = 0; i < 10; i++) {
+        cache.add(std::string(1, 'a' + i), Value("1"));
+        EXPECT_LE(cache.memory(), entry_usage * 3);
+    }
+
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_EQ(cache.key_set().size(), 3);
+    EXPECT_EQ(cache.key_set(true)[0].size(), 5);
+}
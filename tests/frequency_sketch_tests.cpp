@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+
+#include "frequency_sketch.hpp"
+
+TEST(FrequencySketchTests, Counts) {
+    FrequencySketch sketch { 64 };
+    EXPECT_EQ(sketch.frequency(1), 0);
+
+    sketch.increment(1);
+    sketch.increment(1);
+    sketch.increment(2);
+    EXPECT_EQ(sketch.frequency(1), 2);
+    EXPECT_EQ(sketch.frequency(2), 1);
+    EXPECT_EQ(sketch.frequency(3), 0);
+}
+
+TEST(FrequencySketchTests, Saturates) {
+    FrequencySketch sketch { 64 };
+    for (int i = 0; i < 100; i++) {
+        sketch.increment(7);
+    }
+
+    EXPECT_EQ(sketch.frequency(7), SKETCH_MAX_COUNT);
+}
+
+TEST(FrequencySketchTests, Resize) {
+    FrequencySketch sketch { 10 };
+    EXPECT_EQ(sketch.get_width(), 64);
+    EXPECT_EQ(sketch.get_capacity(), 16);
+    EXPECT_EQ(sketch.memory_usage(), SKETCH_DEPTH * 64 / 2);
+
+    sketch.increment(1);
+    sketch.resize(16);
+    EXPECT_EQ(sketch.frequency(1), 1);
+
+    // a new width starts over
+    sketch.resize(1000);
+    EXPECT_EQ(sketch.get_width(), 4096);
+    EXPECT_EQ(sketch.frequency(1), 0);
+}
+
+TEST(FrequencySketchTests, Aging) {
+    FrequencySketch sketch { 1024 };
+    for (int i = 0; i < SKETCH_MAX_COUNT; i++) {
+        sketch.increment(1);
+    }
+    EXPECT_EQ(sketch.frequency(1), SKETCH_MAX_COUNT);
+
+    // enough increments of other keys to trigger a reset, which halves every counter
+    for (uint64_t i = 0; i < SKETCH_SAMPLE_FACTOR * sketch.get_capacity() + 1000; i++) {
+        sketch.increment(1000 + i);
+    }
+
+    EXPECT_LT(sketch.frequency(1), SKETCH_MAX_COUNT);
+    EXPECT_GE(sketch.frequency(1), SKETCH_MAX_COUNT / 2);
+}
+
+TEST(FrequencySketchTests, Clear) {
+    FrequencySketch sketch { 64 };
+    sketch.increment(1);
+    sketch.clear();
+    EXPECT_EQ(sketch.frequency(1), 0);
+}
@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+#include <set>
+#include <deque>
+
+#include "key_index.hpp"
+#include "entries/cache_entry.hpp"
+
+// the index reads keys from its entries, so they are kept alive for the whole test run
+CacheEntry *make_entry(const std::string &key) {
+    static std::deque<CacheEntry> entries;
+    return &entries.emplace_back(key);
+}
+
+TEST(KeyIndexTests, Empty) {
+    KeyIndex index;
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_EQ(index.find("a"), nullptr);
+    EXPECT_EQ(index.erase("a"), false);
+    EXPECT_TRUE(index.begin() == index.end());
+}
+
+TEST(KeyIndexTests, InsertFindErase) {
+    KeyIndex index;
+    CacheEntry *a = make_entry("a");
+    CacheEntry *b = make_entry("b");
+
+    EXPECT_TRUE(index.insert(a));
+    EXPECT_TRUE(index.insert(b));
+    EXPECT_FALSE(index.insert(make_entry("a")));
+
+    EXPECT_EQ(index.size(), 2);
+    EXPECT_EQ(index.find("a"), a);
+    EXPECT_EQ(index.find("b"), b);
+    EXPECT_EQ(index.find("c"), nullptr);
+    EXPECT_TRUE(index.contains("a"));
+
+    EXPECT_TRUE(index.erase("a"));
+    EXPECT_FALSE(index.erase("a"));
+    EXPECT_EQ(index.find("a"), nullptr);
+    EXPECT_EQ(index.find("b"), b);
+    EXPECT_EQ(index.size(), 1);
+
+    index.clear();
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_EQ(index.find("b"), nullptr);
+}
+
+TEST(KeyIndexTests, KeysStoredInEntries) {
+    // slots hold no copy of the key
+    EXPECT_EQ(sizeof(KeyIndex::Slot), 16);
+    EXPECT_EQ(KeyIndex::slot_memory(), sizeof(KeyIndex::Slot) + 1);
+
+    KeyIndex index;
+    std::string key(100, 'k');
+    CacheEntry *entry = make_entry(key);
+    index.insert(entry);
+
+    EXPECT_EQ(index.find(key), entry);
+    EXPECT_EQ(index.begin()->value->key, key);
+}
+
+TEST(KeyIndexTests, Grow) {
+    KeyIndex index;
+    const long n = 10000;
+
+    std::vector<CacheEntry*> entries;
+    for (long i = 0; i < n; i++) {
+        entries.push_back(make_entry("key" + std::to_string(i)));
+        EXPECT_TRUE(index.insert(entries[i]));
+    }
+
+    EXPECT_EQ(index.size(), n);
+    EXPECT_LE(index.size(), index.bucket_count() / 8 * 7);
+
+    for (long i = 0; i < n; i++) {
+        EXPECT_EQ(index.find("key" + std::to_string(i)), entries[i]);
+    }
+    EXPECT_EQ(index.find("key" + std::to_string(n)), nullptr);
+}
+
+TEST(KeyIndexTests, Churn) {
+    KeyIndex index;
+    index.reserve(100);
+    size_t capacity = index.bucket_count();
+
+    // repeatedly inserting and erasing should reuse tombstones instead of growing
+    std::vector<CacheEntry*> entries;
+    for (long i = 0; i < 10000; i++) {
+        entries.push_back(make_entry("key" + std::to_string(i)));
+        EXPECT_TRUE(index.insert(entries[i]));
+        if (i >= 50) {
+            EXPECT_TRUE(index.erase("key" + std::to_string(i - 50)));
+        }
+    }
+
+    EXPECT_EQ(index.size(), 50);
+    EXPECT_EQ(index.bucket_count(), capacity);
+
+    for (long i = 10000 - 50; i < 10000; i++) {
+        EXPECT_EQ(index.find("key" + std::to_string(i)), entries[i]);
+    }
+}
+
+TEST(KeyIndexTests, Iterate) {
+    KeyIndex index;
+
+    std::set<std::string> exp;
+    for (long i = 0; i < 100; i++) {
+        std::string key = std::to_string(i);
+        index.insert(make_entry(key));
+        if (i % 3 == 0) {
+            index.erase(key);
+        } else {
+            exp.insert(key);
+        }
+    }
+
+    std::set<std::string> found;
+    for (auto it = index.begin(); it != index.end(); ++it) {
+        EXPECT_EQ(index.find(it->value->key), it->value);
+        found.insert(it->value->key);
+    }
+
+    EXPECT_EQ(found, exp);
+}
+
+TEST(KeyIndexTests, Move) {
+    KeyIndex index;
+    CacheEntry *a = make_entry("a");
+    index.insert(a);
+
+    KeyIndex other = std::move(index);
+    EXPECT_EQ(other.find("a"), a);
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_EQ(index.find("a"), nullptr);
+
+    index = std::move(other);
+    EXPECT_EQ(index.find("a"), a);
+}
@@ -1,16 +1,28 @@
 #include "gtest/gtest.h"
 
 #include "lru_cache.hpp"
+#include "consistent-hashing.hpp"
 #include "unix_times.hpp"
-#include "linked_list.hpp"
-#include "entries/list_entry.hpp"
+#include "quick_list.hpp"
+#include "entries/value.hpp"
+
+// an entry as LRUCache::extract writes it
+static std::string entry(const std::string &key, const std::string &value) {
+    return "*2\r\n$" + std::to_string(key.size()) + "\r\n" + key + "\r\n"
+        + "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+}
+
+static std::string entry(const std::string &key, int64_t num) {
+    return "*2\r\n$" + std::to_string(key.size()) + "\r\n" + key + "\r\n"
+        + ":" + std::to_string(num) + "\r\n";
+}
 
 TEST(LRUCacheTests, Clear) {
     LRUCache cache { };
 
-    cache.add("key1", new StringEntry("Value 1"));
-    cache.add("key2", new StringEntry("Value 2"));
-    cache.add("key3", new StringEntry("Value 3"));
+    cache.add("key1", Value("Value 1"));
+    cache.add("key2", Value("Value 2"));
+    cache.add("key3", Value("Value 3"));
     
     cache.clear();
     EXPECT_EQ(cache.size(), 0);
@@ -19,27 +31,24 @@ TEST(LRUCacheTests, Clear) {
 TEST(LRUCacheTests, AddAndRemove) {
     LRUCache cache { };
 
-    StringEntry *v1 = new StringEntry("Value 1");
-    StringEntry *v2 = new StringEntry("Value 2");
-
-    cache.add("key1", v1);
-    cache.add("key2", v2);
+    cache.add("key1", Value("Value 1"));
+    cache.add("key2", Value("Value 2"));
 
     EXPECT_EQ(
-        dynamic_cast<StringEntry*>(cache.get("key1"))->value, 
+        cache.get("key1")->str(), 
         "Value 1");
     EXPECT_EQ(
-        dynamic_cast<StringEntry*>(cache.get("key2"))->value, 
+        cache.get("key2")->str(), 
         "Value 2");
 
-    EXPECT_EQ(cache.remove("key1"), v1);
+    EXPECT_EQ(cache.remove("key1").str(), "Value 1");
 
     EXPECT_EQ(cache.get("key1"), nullptr);
 
-    EXPECT_EQ(cache.remove("key1"), nullptr);
-    EXPECT_EQ(cache.remove("random key"), nullptr);
+    EXPECT_TRUE(cache.remove("key1").is_none());
+    EXPECT_TRUE(cache.remove("random key").is_none());
 
-    EXPECT_EQ(cache.remove("key2"), v2);
+    EXPECT_EQ(cache.remove("key2").str(), "Value 2");
 }
 
 
@@ -50,28 +59,28 @@ TEST(LRUCacheTests, ReplaceKey) {
     std::string value1 = "Value1";
     std::string value2 = "Value2";
 
-    cache.add("key1", new StringEntry(value1));
-    cache.add("key2", new StringEntry(value2));
+    cache.add("key1", Value(value1));
+    cache.add("key2", Value(value2));
 
     EXPECT_EQ(
-        dynamic_cast<StringEntry*>(cache.get("key1"))->value, 
+        cache.get("key1")->str(), 
         value1);
     EXPECT_EQ(
-        dynamic_cast<StringEntry*>(cache.get("key2"))->value, 
+        cache.get("key2")->str(), 
         value2);
 
     std::string value3 = "Value3";
     std::string value4 = "Value4";
 
-    cache.add("key1", new StringEntry(value3));
-    cache.add("key2", new StringEntry(value4));
+    cache.add("key1", Value(value3));
+    cache.add("key2", Value(value4));
 
     EXPECT_EQ(
-        dynamic_cast<StringEntry*>(cache.get("key1"))->value, 
+        cache.get("key1")->str(), 
         value3);
         
     EXPECT_EQ(
-        dynamic_cast<StringEntry*>(cache.get("key2"))->value, 
+        cache.get("key2")->str(), 
         value4);
 }
 
@@ -83,7 +92,7 @@ TEST(LRUCacheTests, KeySet) {
     std::vector<std::string> vals {"A", "B", "C", "D", "E", "F", "G"};
 
     for (int i = 0; i < keys.size(); i++) {
-        cache.add(keys[i], new StringEntry(vals[i]));
+        cache.add(keys[i], Value(vals[i]));
 
         if (i == 4) {
             cache.set_expire(keys[i], 1);
@@ -104,8 +113,8 @@ TEST(LRUCacheTests, Expire) {
     std::string value1 = "Value1";
     std::string value2 = "Value2";
 
-    cache.add("key1", new StringEntry(value1));
-    cache.add("key2", new StringEntry(value2));
+    cache.add("key1", Value(value1));
+    cache.add("key2", Value(value2));
 
     EXPECT_EQ(
         cache.get_cache_entry("key1")->expiration, 
@@ -128,27 +137,27 @@ TEST(LRUCacheTests, Expire) {
 TEST(LRUCacheTests, LRU) {
     LRUCache cache { 5, 5 };
 
-    cache.add("1", new StringEntry("a"));
-    cache.add("2", new StringEntry("b"));
-    cache.add("3", new StringEntry("c"));
-    cache.add("4", new StringEntry("d"));
-    cache.add("5", new StringEntry("e"));
+    cache.add("1", Value("a"));
+    cache.add("2", Value("b"));
+    cache.add("3", Value("c"));
+    cache.add("4", Value("d"));
+    cache.add("5", Value("e"));
     std::vector<std::string> exp1 {"1", "2", "3", "4", "5"};
     EXPECT_EQ(cache.key_set(), exp1);
     
     EXPECT_EQ(
-        dynamic_cast<StringEntry*>(cache.get("1"))->value, 
+        cache.get("1")->str(), 
         "a");
     std::vector<std::string> exp2 {"2", "3", "4", "5", "1"};
     EXPECT_EQ(cache.key_set(), exp2);
 
     
-    cache.add("2", new StringEntry("b"));
+    cache.add("2", Value("b"));
     std::vector<std::string> exp3 {"3", "4", "5", "1", "2"};
     EXPECT_EQ(cache.key_set(), exp3);
 
 
-    cache.add("6", new StringEntry("b"));
+    cache.add("6", Value("b"));
     std::vector<std::string> exp4 {"4", "5", "1", "2", "6"};
     EXPECT_EQ(cache.key_set(), exp4);
     EXPECT_EQ(cache.get("3"), nullptr);
@@ -158,40 +167,34 @@ TEST(LRUCacheTests, LRU) {
 TEST(LRUCacheTests, LRUTypes) {
     LRUCache cache { 2, 2 };
 
-    ListEntry *list_entry = new ListEntry();
-    LinkedList *list = list_entry->list;
-    list->add_end(new StringEntry("1"));
-    list->add_end(new StringEntry("2"));
-    list->add_end(new StringEntry("3"));
+    Value list_value = Value::new_list();
+    QuickList *list = list_value.list();
+    list->add_end(Value("1"));
+    list->add_end(Value("2"));
+    list->add_end(Value("3"));
 
-    cache.add("list", list_entry);
+    cache.add("list", std::move(list_value));
     EXPECT_EQ(cache.get("list")->to_string(), "1 2 3");
 
-    cache.add("num", new IntEntry(1));
+    cache.add("num", Value(1));
     EXPECT_EQ(cache.get("num")->to_string(), "1");
 
     std::vector<std::string> exp1 {"list", "num"};
     EXPECT_EQ(cache.key_set(), exp1);
 
-    cache.add("str", new StringEntry("b"));
+    cache.add("str", Value("b"));
     std::vector<std::string> exp2 {"num", "str"};
     EXPECT_EQ(cache.key_set(), exp2);
     EXPECT_EQ(cache.get("list"), nullptr);
 
-    cache.add("str2", new StringEntry("c"));    
+    cache.add("str2", Value("c"));    
     std::vector<std::string> exp3 {"str", "str2"};
     EXPECT_EQ(cache.key_set(), exp3);
     EXPECT_EQ(cache.get("num"), nullptr);
 }
 
 TEST(LRUCacheTests, ImportConstruct) {
-    std::string str = 
-    "key1\n"
-    "value1\n"
-    "key2\n"
-    "value2\n"
-    "key3\n"
-    "value3\n";
+    std::string str = entry("key1", "value1") + entry("key2", "value2") + entry("key3", "value3");
 
     LRUCache cache { str, 5, 5 };
 
@@ -208,41 +211,55 @@ TEST(LRUCacheTests, Import) {
     EXPECT_EQ(cache.import(""), true);
     EXPECT_EQ(cache.size(), 0);
 
-    cache.add("key0", new StringEntry("value0"));
-    cache.add("key1", new StringEntry("1"));
+    cache.add("key0", Value("value0"));
+    cache.add("key1", Value("1"));
 
-    std::string import_str = 
-    "key1\n"
-    "value1\n"
-    "key2\n"
-    "2\n"
-    "key3\n"
-    "str 2 3\n";
+    std::string import_str = entry("key1", "value1") + entry("key2", 2)
+        + "*2\r\n$4\r\nkey3\r\n*3\r\n$3\r\nstr\r\n$1\r\n2\r\n$1\r\n3\r\n";
 
     EXPECT_EQ(cache.import(import_str), true);
 
     EXPECT_EQ(cache.size(), 4);
     EXPECT_EQ(cache.get("key0")->to_string(), "value0");
-    EXPECT_EQ(cache.get("key0")->get_type(), EntryType::str);
+    EXPECT_EQ(cache.get("key0")->type(), EntryType::str);
 
     EXPECT_EQ(cache.get("key1")->to_string(), "value1");
-    EXPECT_EQ(cache.get("key1")->get_type(), EntryType::str);
+    EXPECT_EQ(cache.get("key1")->type(), EntryType::str);
 
     EXPECT_EQ(cache.get("key2")->to_string(), "2");
-    EXPECT_EQ(cache.get("key2")->get_type(), EntryType::integer);
+    EXPECT_EQ(cache.get("key2")->type(), EntryType::integer);
 
     EXPECT_EQ(cache.get("key3")->to_string(), "str 2 3");
-    EXPECT_EQ(cache.get("key3")->get_type(), EntryType::list);
+    EXPECT_EQ(cache.get("key3")->type(), EntryType::list);
+}
+
+
+TEST(LRUCacheTests, ImportBinarySafe) {
+    LRUCache cache { 5, 5 };
+    cache.add("spaces", Value("a b c"));
+    cache.add("key\nwith\r\nnewlines", Value(std::string_view("x\0y\r\n", 5)));
+    cache.add("list", str_to_value("1 two 3"));
+
+    std::vector<std::string> strs = cache.extract({ 0, 0 });
+    EXPECT_EQ(strs.size(), 1);
+
+    // values with spaces stay strings, and keys and values may hold any bytes
+    LRUCache copy { strs[0], 5, 5 };
+    EXPECT_EQ(copy.size(), 3);
+    EXPECT_EQ(copy.get("spaces")->type(), EntryType::str);
+    EXPECT_EQ(copy.get("spaces")->to_string(), "a b c");
+    EXPECT_EQ(copy.get("key\nwith\r\nnewlines")->str(), std::string_view("x\0y\r\n", 5));
+    EXPECT_EQ(copy.get("list")->type(), EntryType::list);
+    EXPECT_EQ(copy.get("list")->list()->get(0).integer(), 1);
+    EXPECT_EQ(copy.get("list")->to_string(), "1 two 3");
 }
 
 
 TEST(LRUCacheTests, IncompleteImport) {
     LRUCache cache { 5, 5 };
 
-    std::string import_str = 
-    "key1\n"
-    "value1\n"
-    "key2\n";
+    // key2 has no value
+    std::string import_str = entry("key1", "value1") + "*2\r\n$4\r\nkey2\r\n";
 
     EXPECT_EQ(cache.import(import_str), false);
 
@@ -255,44 +272,48 @@ TEST(LRUCacheTests, IncompleteImport) {
 TEST(LRUCacheTests, Extract) {
     LRUCache cache { 10, 10 };
 
+    // in ring order
+    uint64_t key3 = hash_function("key3"); // 2441534853086906165
+    uint64_t key1 = hash_function("key1"); // 10749846375273410764
+    uint64_t key2 = hash_function("key2"); // 12217841712305229807
+    uint64_t key4 = hash_function("key4"); // 12954295200736430954
+    uint64_t key5 = hash_function("key5"); // 14489066320677255528
+    ASSERT_TRUE(key3 < key1 && key1 < key2 && key2 < key4 && key4 < key5);
+
     std::string import_str = 
-    "key1\n" // 322
-    "1\n"
-    "key2\n" // 316
-    "2\n"
-    "key3\n" // 18
-    "3\n"
-    "key4\n" // 38
-    "4\n" 
-    "key5\n" // 56
-    "5\n"; 
+    entry("key1", 1) +
+    entry("key2", 2) +
+    entry("key3", 3) +
+    entry("key4", 4) +
+    entry("key5", 5);
 
     EXPECT_EQ(cache.import(import_str), true);
     EXPECT_EQ(cache.size(), 5);
 
-    std::vector<std::string> strs = cache.extract({ 0, 20, 40, 320 });
+    std::vector<std::string> strs = cache.extract({ 0, key1, key2, key5 });
     EXPECT_EQ(strs.size(), 3);
-    EXPECT_EQ(strs[0], "key3\n3\n");
-    EXPECT_EQ(strs[1], "key4\n4\n");
-    EXPECT_TRUE(strs[2] == "key2\n2\nkey5\n5\n" || strs[2] == "key5\n5\nkey2\n2\n");
+    EXPECT_EQ(strs[0], entry("key3", 3));
+    EXPECT_EQ(strs[1], entry("key1", 1));
+    EXPECT_TRUE(strs[2] == entry("key2", 2) + entry("key4", 4) || strs[2] == entry("key4", 4) + entry("key2", 2));
 
-    strs = cache.extract({ 20, 40, 320 });
+    strs = cache.extract({ key1, key2, key5 });
     EXPECT_EQ(strs.size(), 2);
-    EXPECT_EQ(strs[0], "key4\n4\n");
-    EXPECT_TRUE(strs[1] == "key2\n2\nkey5\n5\n" || strs[1] == "key5\n5\nkey2\n2\n");
+    EXPECT_EQ(strs[0], entry("key1", 1));
+    EXPECT_TRUE(strs[1] == entry("key2", 2) + entry("key4", 4) || strs[1] == entry("key4", 4) + entry("key2", 2));
 
-    strs = cache.extract({ 322, 20, 56 });
+    // wraps around the ring
+    strs = cache.extract({ key5, key1, key2 });
     EXPECT_EQ(strs.size(), 2);
-    EXPECT_TRUE(strs[0] == "key1\n1\nkey3\n3\n" || strs[0] == "key3\n3\nkey1\n1\n");
-    EXPECT_EQ(strs[1], "key4\n4\n");
+    EXPECT_TRUE(strs[0] == entry("key5", 5) + entry("key3", 3) || strs[0] == entry("key3", 3) + entry("key5", 5));
+    EXPECT_EQ(strs[1], entry("key1", 1));
 
-    strs = cache.extract({ 310, 322, 20, 56 });
+    strs = cache.extract({ key4, key5, key1, key2 });
     EXPECT_EQ(strs.size(), 3);
-    EXPECT_TRUE(strs[0] == "key2\n2\n");
-    EXPECT_TRUE(strs[1] == "key1\n1\nkey3\n3\n" || strs[1] == "key3\n3\nkey1\n1\n");
-    EXPECT_EQ(strs[2], "key4\n4\n");
+    EXPECT_TRUE(strs[0] == entry("key4", 4));
+    EXPECT_TRUE(strs[1] == entry("key5", 5) + entry("key3", 3) || strs[1] == entry("key3", 3) + entry("key5", 5));
+    EXPECT_EQ(strs[2], entry("key1", 1));
 
-    strs = cache.extract({ 0, 18 });
+    strs = cache.extract({ 0, key3 });
     EXPECT_EQ(strs.size(), 1);
     EXPECT_EQ(strs[0], "");
 
@@ -302,12 +323,129 @@ TEST(LRUCacheTests, Extract) {
     strs = cache.extract({ });
     EXPECT_EQ(strs.size(), 0);
 
-    strs = cache.extract({ 0, 38 });
+    strs = cache.extract({ 0, key1 });
     EXPECT_EQ(strs.size(), 1);
-    EXPECT_EQ(strs[0], "key3\n3\n");
+    EXPECT_EQ(strs[0], entry("key3", 3));
 
-    strs = cache.extract({ 0, 360 });
+    // back to the same bound is the whole ring
+    strs = cache.extract({ key2, key2 });
     EXPECT_EQ(strs.size(), 1);
     EXPECT_EQ(strs[0].size(), import_str.size());
 
 }
+
+
+TEST(LRUCacheTests, MemoryAccounting) {
+    LRUCache cache { };
+    EXPECT_EQ(cache.memory(), 0);
+
+    cache.add("short", Value("a"));
+    long short_usage = cache.memory_usage("short");
+    EXPECT_GT(short_usage, 0);
+    EXPECT_EQ(cache.memory(), short_usage);
+
+    // a value too long to be stored inline is counted on the heap
+    std::string long_value(1000, 'x');
+    cache.add("long", Value(long_value));
+    long long_usage = cache.memory_usage("long");
+    EXPECT_EQ(long_usage, short_usage + long_value.size());
+    EXPECT_EQ(cache.memory(), short_usage + long_usage);
+
+    // replacing a value updates the total
+    cache.add("long", Value("b"));
+    EXPECT_EQ(cache.memory_usage("long"), short_usage);
+    EXPECT_EQ(cache.memory(), 2 * short_usage);
+
+    cache.remove("short");
+    EXPECT_EQ(cache.memory(), short_usage);
+    EXPECT_EQ(cache.memory_usage("short"), -1);
+
+    cache.clear();
+    EXPECT_EQ(cache.memory(), 0);
+}
+
+TEST(LRUCacheTests, KeyStoredOnce) {
+    LRUCache cache { };
+    cache.add("k", Value("a"));
+
+    // a key too long for the small string buffer costs its heap buffer once, not once per copy
+    std::string long_key(100, 'k');
+    cache.add(long_key, Value("a"));
+    EXPECT_EQ(cache.memory_usage(long_key), cache.memory_usage("k") + heap_string_size(long_key));
+
+    std::vector<std::string> exp {"k", long_key};
+    EXPECT_EQ(cache.key_set(), exp);
+
+    cache.remove("k");
+    EXPECT_EQ(cache.get("k"), nullptr);
+    EXPECT_EQ(cache.get(long_key)->str(), "a");
+}
+
+TEST(LRUCacheTests, MaxMemory) {
+    LRUCache sizing { };
+    sizing.add("1", Value("a"));
+    long entry_usage = sizing.memory();
+
+    // room for 3 entries by bytes, but plenty by count
+    LRUCache cache { 10, 100, entry_usage * 3 };
+
+    cache.add("1", Value("a"));
+    cache.add("2", Value("b"));
+    cache.add("3", Value("c"));
+    EXPECT_EQ(cache.size(), 3);
+
+    cache.add("4", Value("d"));
+    std::vector<std::string> exp1 {"2", "3", "4"};
+    EXPECT_EQ(cache.key_set(), exp1);
+    EXPECT_LE(cache.memory(), cache.max_memory);
+
+    // one large entry evicts from the LRU head until it fits
+    cache.get("2");
+    cache.add("5", Value(std::string(entry_usage / 2, 'x')));
+    std::vector<std::string> exp2 {"2", "5"};
+    EXPECT_EQ(cache.key_set(), exp2);
+    EXPECT_LE(cache.memory(), cache.max_memory);
+
+    // an entry larger than max_memory is kept on its own
+    cache.add("6", Value(std::string(entry_usage * 4, 'x')));
+    std::vector<std::string> exp3 {"6"};
+    EXPECT_EQ(cache.key_set(), exp3);
+}
+
+TEST(LRUCacheTests, ActiveExpire) {
+    LRUCache cache { };
+
+    for (int i = 0; i < 100; i++) {
+        cache.add(std::to_string(i), Value("a"));
+    }
+
+    seconds::rep now = time_secs();
+    for (int i = 0; i < 50; i++) {
+        cache.set_expire(std::to_string(i), now + 10);
+    }
+    cache.set_expire("50", now + 1000);
+    cache.set_expire("51", now + 10);
+    cache.set_expire("51", 0);
+
+    EXPECT_EQ(cache.expires_scheduled(), 51);
+    EXPECT_EQ(cache.active_expire(), 0);
+    EXPECT_EQ(cache.size(), 100);
+
+    // expired keys are removed without being touched
+    int old_offset = secs_offset;
+    secs_offset += 20;
+    EXPECT_EQ(cache.active_expire(), 50);
+    EXPECT_EQ(cache.size(), 50);
+    EXPECT_EQ(cache.expires_scheduled(), 1);
+    EXPECT_EQ(cache.expired_keys(), 50);
+    EXPECT_EQ(cache.expired_per_sec(), 50.0 / EXPIRE_STATS_WINDOW);
+    EXPECT_EQ(cache.get("0"), nullptr);
+    EXPECT_NE(cache.get("50"), nullptr);
+    EXPECT_NE(cache.get("51"), nullptr);
+
+    // deleted keys leave the wheel
+    cache.remove("50");
+    EXPECT_EQ(cache.expires_scheduled(), 0);
+
+    secs_offset = old_offset;
+}
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "placement.hpp"
+#include "consistent-hashing.hpp"
+
+static const PlacementType TYPES[] = {
+    PlacementType::Ring, PlacementType::Jump, PlacementType::Rendezvous, PlacementType::Bounded
+};
+
+static std::vector<Placement::Node> make_nodes(int count) {
+    std::vector<Placement::Node> nodes;
+    for (int i = 0; i < count; i++) {
+        nodes.push_back({ std::to_string(100 + i), "tcp://localhost:" + std::to_string(25551 + i), 16 });
+    }
+
+    return nodes;
+}
+
+// the pid of each key's owner
+static std::vector<std::string> owners(PlacementType type, const std::vector<Placement::Node> &nodes) {
+    std::unique_ptr<Placement> placement = Placement::make(type, nodes);
+    std::vector<std::string> pids;
+    for (int i = 0; i < 20000; i++) {
+        pids.push_back(nodes[placement->get(hash_function("key" + std::to_string(i)))].pid);
+    }
+
+    return pids;
+}
+
+TEST(PlacementTests, Names) {
+    for (PlacementType type : TYPES) {
+        PlacementType parsed;
+        ASSERT_TRUE(parse_placement(placement_name(type), parsed));
+        EXPECT_EQ(parsed, type);
+    }
+
+    PlacementType parsed = PlacementType::Jump;
+    EXPECT_FALSE(parse_placement("modulo", parsed));
+    EXPECT_EQ(parsed, PlacementType::Jump);
+}
+
+TEST(PlacementTests, SameForAnyOrder) {
+    std::vector<Placement::Node> nodes = make_nodes(6);
+    std::vector<Placement::Node> reversed(nodes.rbegin(), nodes.rend());
+
+    for (PlacementType type : TYPES) {
+        EXPECT_EQ(owners(type, nodes), owners(type, reversed)) << placement_name(type);
+    }
+}
+
+TEST(PlacementTests, Balance) {
+    std::vector<Placement::Node> nodes = make_nodes(8);
+
+    for (PlacementType type : TYPES) {
+        std::vector<std::string> pids = owners(type, nodes);
+        for (const Placement::Node &node : nodes) {
+            long count = std::count(pids.begin(), pids.end(), node.pid);
+            EXPECT_GT(count, 0) << placement_name(type);
+
+            // the ring with 16 points is the least even, the others are near the mean
+            double max = type == PlacementType::Ring ? 1.6 : 1.3;
+            EXPECT_LT(count, max * pids.size() / nodes.size()) << placement_name(type);
+        }
+    }
+}
+
+TEST(PlacementTests, JoinMovesKeysToNewNode) {
+    std::vector<Placement::Node> nodes = make_nodes(6);
+    std::vector<Placement::Node> joined = make_nodes(7);
+
+    // bounded placement may also move keys between nodes that stay, as their caps shrink
+    for (PlacementType type : { PlacementType::Ring, PlacementType::Jump, PlacementType::Rendezvous }) {
+        std::vector<std::string> before = owners(type, nodes);
+        std::vector<std::string> after = owners(type, joined);
+
+        size_t moved = 0;
+        for (size_t i = 0; i < before.size(); i++) {
+            if (before[i] != after[i]) {
+                EXPECT_EQ(after[i], joined.back().pid) << placement_name(type);
+                moved++;
+            }
+        }
+        EXPECT_GT(moved, 0) << placement_name(type);
+    }
+}
+
+TEST(PlacementTests, Weights) {
+    // weights 1 to 4, so the last node should own 4 in 10 keys
+    std::vector<Placement::Node> nodes = make_nodes(4);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i].vnodes = 64;
+        nodes[i].weight = i + 1;
+    }
+
+    for (PlacementType type : TYPES) {
+        std::vector<std::string> pids = owners(type, nodes);
+        for (const Placement::Node &node : nodes) {
+            double share = static_cast<double>(std::count(pids.begin(), pids.end(), node.pid)) / pids.size();
+            EXPECT_NEAR(share, node.weight / 10.0, 0.2 * node.weight / 10.0) << placement_name(type) << " " << node.pid;
+        }
+    }
+}
+
+TEST(PlacementTests, RingCarriesPlacement) {
+    for (PlacementType type : TYPES) {
+        ConsistentHashing ch_ring;
+        ch_ring.set_placement(type);
+        ch_ring.add("one", "tcp://localhost:25551", true, 16);
+        ch_ring.add("two", "tcp://localhost:25552", false, 16);
+        ch_ring.add("three", "tcp://localhost:25553", false, 16, 2);
+        EXPECT_EQ(ch_ring.point_count(), 64);
+
+        // a worker gets the leader's placement and weights with the ring, and places keys the same way
+        ConsistentHashing ch_ring2;
+        ch_ring2.update(ch_ring.to_internal_string());
+        EXPECT_EQ(ch_ring2.placement(), type);
+        EXPECT_EQ(ch_ring2.get_by_pid("three")->weight, 2);
+        for (int i = 0; i < 1000; i++) {
+            std::string key = "key" + std::to_string(i);
+            EXPECT_EQ(ch_ring2.get(key)->pid, ch_ring.get(key)->pid) << placement_name(type);
+        }
+
+        double total = 0;
+        for (const auto &[pid, owned] : ch_ring.ownership()) {
+            EXPECT_GT(owned, 0);
+            total += owned;
+        }
+        EXPECT_NEAR(total, 1, 1e-9);
+    }
+}
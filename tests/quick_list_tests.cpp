@@ -0,0 +1,296 @@
+#include "gtest/gtest.h"
+
+#include "quick_list.hpp"
+#include "entries/value.hpp"
+
+TEST(QuickListTests, Empty) {
+    QuickList list;
+    EXPECT_EQ(list.get_size(), 0);
+    EXPECT_EQ(list.values().size(), 0);
+}
+
+TEST(QuickListTests, Values) {
+    QuickList list;
+
+    std::vector<std::string> exp_none { };
+    EXPECT_EQ(list.values(), exp_none);
+    EXPECT_EQ(list.values(0, -1), exp_none);
+    EXPECT_EQ(list.values(-1, -1), exp_none);
+    EXPECT_EQ(list.values(0), exp_none);
+
+    for (int i = 0; i < 5; i++) {
+        list.add_end(Value(std::to_string(i)));
+    }
+    
+    std::vector<std::string> exp_all {"0", "1", "2", "3", "4"};
+    EXPECT_EQ(list.values(), exp_all);
+    EXPECT_EQ(list.values(0, -1), exp_all);
+    EXPECT_EQ(list.values(-1, -1), exp_all);
+    EXPECT_EQ(list.values(0), exp_all);
+    EXPECT_EQ(list.values(0, 4), exp_all);
+    EXPECT_EQ(list.values(0, 10), exp_all);
+
+    std::vector<std::string> exp_some {"0", "1", "2", "3"};
+    EXPECT_EQ(list.values(0, 3), exp_some);
+
+    std::vector<std::string> exp_some2 {"1", "2", "3", "4"};
+    EXPECT_EQ(list.values(1), exp_some2);
+    EXPECT_EQ(list.values(1, 4), exp_some2);
+    EXPECT_EQ(list.values(1, -1), exp_some2);
+
+    std::vector<std::string> exp_some3 {"2", "3", "4"};
+    EXPECT_EQ(list.values(2, 4), exp_some3);
+
+    std::vector<std::string> exp_one {"2"};
+    EXPECT_EQ(list.values(2, 2), exp_one);
+
+    std::vector<std::string> exp_head {"0"};
+    EXPECT_EQ(list.values(0, 0), exp_head);
+
+    std::vector<std::string> exp_tail {"4"};
+    EXPECT_EQ(list.values(4, 4), exp_tail);
+}
+
+
+TEST(QuickListTests, Reverse) {
+    QuickList list;
+
+    std::vector<std::string> exp_none { };
+    EXPECT_EQ(list.values(0, 0, true), exp_none);
+
+    for (int i = 0; i < 5; i++) {
+        list.add_end(Value(std::to_string(i)));
+    }
+    
+    std::vector<std::string> exp_all {"4", "3", "2", "1", "0"};
+    EXPECT_EQ(list.values(0, -1, true), exp_all);
+
+    std::vector<std::string> exp_some {"4", "3", "2", "1"};
+    EXPECT_EQ(list.values(0, 3, true), exp_some);
+
+    std::vector<std::string> exp_some2 {"3", "2", "1", "0"};
+    EXPECT_EQ(list.values(1, 4, true), exp_some2);
+
+    std::vector<std::string> exp_some3 {"2", "1", "0"};
+    EXPECT_EQ(list.values(2, 4, true), exp_some3);
+
+    std::vector<std::string> exp_one {"2"};
+    EXPECT_EQ(list.values(2, 2, true), exp_one);
+
+    std::vector<std::string> exp_head {"4"};
+    EXPECT_EQ(list.values(0, 0, true), exp_head);
+
+    std::vector<std::string> exp_tail {"0"};
+    EXPECT_EQ(list.values(4, 4, true), exp_tail);
+}
+
+TEST(QuickListTests, SingleString) {
+    QuickList list;
+
+    EXPECT_EQ(list.values(0, 0, false, true)[0], "");
+    EXPECT_EQ(list.values(0, 0, true, true)[0], "");
+
+    for (int i = 0; i < 5; i++) {
+        list.add_end(Value(std::to_string(i)));
+    }
+    EXPECT_EQ(list.values(0, 5, false, true)[0], "0 1 2 3 4");
+    EXPECT_EQ(list.values(0, 5, true, true)[0], "4 3 2 1 0");
+
+    EXPECT_EQ(list.values(0, 3, false, true)[0], "0 1 2 3");
+    EXPECT_EQ(list.values(0, 3, true, true)[0], "4 3 2 1");
+
+    EXPECT_EQ(list.values(1, 4, false, true)[0], "1 2 3 4");
+    EXPECT_EQ(list.values(1, 4, true, true)[0], "3 2 1 0");
+
+    EXPECT_EQ(list.values(2, 4, false, true)[0], "2 3 4");
+    EXPECT_EQ(list.values(2, 4, true, true)[0], "2 1 0");
+
+    EXPECT_EQ(list.values(2, 2, false, true)[0], "2");
+    EXPECT_EQ(list.values(2, 2, true, true)[0], "2");
+
+    EXPECT_EQ(list.values(0, 0, false, true)[0], "0");
+    EXPECT_EQ(list.values(0, 0, true, true)[0], "4");
+
+    EXPECT_EQ(list.values(4, 4, false, true)[0], "4");
+    EXPECT_EQ(list.values(4, 4, true, true)[0], "0");
+}
+
+TEST(QuickListTests, Adding) {
+    QuickList list;
+
+    list.add_end(Value("1"));
+    list.add_end(Value("2"));
+    list.add_front(Value("0"));
+    list.add_end(Value("3"));
+
+    EXPECT_EQ(list.get_size(), 4);
+
+    std::vector<std::string> exp {"0", "1", "2", "3"};
+    EXPECT_EQ(list.values(), exp);
+}
+
+TEST(QuickListTests, Get) {
+    QuickList list;
+
+    list.add_end(Value("1"));
+    list.add_end(Value("2"));
+    list.add_front(Value("0"));
+    list.add_end(Value("3"));
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(
+            list.get(i).str(), 
+            std::to_string(i));
+    }    
+}
+
+
+TEST(QuickListTests, Remove) {
+    QuickList list;
+
+    for (int i = 0; i < 5; i++) {
+        list.add_end(Value(std::to_string(i)));
+    }
+
+    EXPECT_EQ(list.get_size(), 5);
+
+    std::vector<std::string> exp {"0", "1", "2", "3", "4"};
+    EXPECT_EQ(list.values(), exp);
+
+    for (int i = 0; i < 5; i++) {
+        list.remove_end();
+    }
+
+    EXPECT_EQ(list.get_size(), 0);
+    EXPECT_EQ(list.values().size(), 0);
+}
+TEST(QuickListTests, RemoveLots) {
+    QuickList list;
+
+    for (int i = 0; i < 10; i++) {
+        list.add_end(Value(std::to_string(i)));
+    }
+
+    list.remove_end(); //9
+    list.remove_end(); //8
+
+    list.remove_front(); //0
+
+    list.remove(2); //3
+
+    EXPECT_EQ(list.get_size(), 6);
+    std::vector<std::string> exp {"1", "2", "4", "5", "6", "7"};
+
+    EXPECT_EQ(list.values(), exp);
+}
+
+TEST(QuickListTests, RemoveMiddle) {
+    QuickList list;
+
+    for (int i = 0; i < 5; i++) {
+        list.add_end(Value(std::to_string(i)));
+    }
+
+    EXPECT_EQ(list.remove(0).str(), "0");
+    EXPECT_EQ(list.remove(1).str(), "2");
+    EXPECT_EQ(list.remove(2).str(), "4");
+    EXPECT_TRUE(list.remove(2).is_none());
+    EXPECT_TRUE(list.remove(-1).is_none());
+
+    EXPECT_EQ(list.get_size(), 2);
+    std::vector<std::string> exp {"1", "3"};
+
+    EXPECT_EQ(list.values(), exp);
+}
+
+TEST(QuickListTests, MixedTypes) {
+    QuickList list;
+
+    std::string long_str(100, 'l');
+    list.add_end(Value("a"));
+    list.add_end(Value(2));
+    list.add_end(Value(-100000));
+    list.add_end(Value(INT64_MAX));
+    list.add_end(Value(long_str));
+    list.add_end(str_to_value("b c"));
+
+    EXPECT_EQ(list.get(0).str(), "a");
+    EXPECT_EQ(list.get(1).integer(), 2);
+    EXPECT_EQ(list.get(2).integer(), -100000);
+    EXPECT_EQ(list.get(3).integer(), INT64_MAX);
+    EXPECT_EQ(list.get(4).str(), long_str);
+    // lists are flattened into strings
+    EXPECT_EQ(list.get(5).str(), "b c");
+    EXPECT_TRUE(list.get(6).is_none());
+
+    EXPECT_EQ(list.get_size(), 6);
+    std::vector<std::string> exp {"a", "2", "-100000", std::to_string(INT64_MAX), long_str, "b c"};
+
+    EXPECT_EQ(list.values(), exp);
+    EXPECT_EQ(list.memory_usage(), list.chunk_count() * QUICKLIST_CHUNK_SIZE + long_str.size());
+
+    EXPECT_EQ(list.remove_end().str(), "b c");
+    EXPECT_EQ(list.remove_end().str(), long_str);
+    EXPECT_EQ(list.memory_usage(), list.chunk_count() * QUICKLIST_CHUNK_SIZE);
+}
+
+TEST(QuickListTests, ManyChunks) {
+    QuickList list;
+    const int n = 10000;
+
+    // push to both ends so chunks fill from either side
+    for (int i = 0; i < n; i++) {
+        list.add_end(Value("v" + std::to_string(i)));
+        list.add_front(Value(-i - 1));
+    }
+
+    EXPECT_EQ(list.get_size(), 2 * n);
+    EXPECT_GT(list.chunk_count(), 2);
+    EXPECT_LT(list.chunk_count(), 2 * n / 20);
+
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(list.get(i).integer(), i - n);
+        EXPECT_EQ(list.get(n + i).str(), "v" + std::to_string(i));
+    }
+
+    std::vector<std::string> all = list.values();
+    std::vector<std::string> reversed = list.values(0, -1, true);
+    ASSERT_EQ(all.size(), 2 * n);
+    for (int i = 0; i < 2 * n; i++) {
+        EXPECT_EQ(all[i], reversed[2 * n - 1 - i]);
+    }
+
+    // ranges crossing chunk boundaries in both directions
+    std::vector<std::string> exp {"-2", "-1", "v0", "v1"};
+    EXPECT_EQ(list.values(n - 2, n + 1), exp);
+    std::vector<std::string> exp_reversed {"v1", "v0", "-1", "-2"};
+    EXPECT_EQ(list.values(n - 2, n + 1, true), exp_reversed);
+
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(list.remove_front().integer(), i - n);
+        EXPECT_EQ(list.remove_end().str(), "v" + std::to_string(n - 1 - i));
+    }
+
+    EXPECT_EQ(list.get_size(), 0);
+    EXPECT_EQ(list.chunk_count(), 0);
+    EXPECT_EQ(list.memory_usage(), 0);
+    EXPECT_TRUE(list.remove_front().is_none());
+}
+
+TEST(QuickListTests, LongStrings) {
+    QuickList list;
+
+    // larger than a chunk, so they can only be stored outside of one
+    std::string huge(QUICKLIST_CHUNK_SIZE * 2, 'h');
+    for (int i = 0; i < 10; i++) {
+        list.add_front(Value(huge + std::to_string(i)));
+    }
+
+    EXPECT_EQ(list.get(0).str(), huge + "9");
+    EXPECT_EQ(list.remove(5).str(), huge + "4");
+    EXPECT_EQ(list.get_size(), 9);
+
+    list.clear();
+    EXPECT_EQ(list.get_size(), 0);
+    EXPECT_EQ(list.memory_usage(), 0);
+}
@@ -0,0 +1,218 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include "resp.hpp"
+#include "quick_list.hpp"
+
+TEST(RespTests, ParseRequest) {
+    std::string buf = "*3\r\n$3\r\nset\r\n$3\r\na b\r\n$4\r\n1\r\n2\r\n";
+    Tokens args;
+    size_t consumed = 0;
+
+    EXPECT_EQ(resp::parse_request(buf, args, consumed), resp::Status::Complete);
+    EXPECT_EQ(consumed, buf.size());
+    EXPECT_EQ(args.size(), 3);
+    EXPECT_EQ(args[0], "set");
+    // args may hold spaces and newlines
+    EXPECT_EQ(args[1], "a b");
+    EXPECT_EQ(args[2], "1\r\n2");
+}
+
+TEST(RespTests, ParseIncremental) {
+    std::string buf = "*2\r\n$3\r\nget\r\n$5\r\nhello\r\n";
+    Tokens args;
+    size_t consumed = 0;
+
+    // every prefix is incomplete until the last byte arrives
+    for (size_t i = 0; i < buf.size(); i++) {
+        EXPECT_EQ(resp::parse_request(std::string_view(buf).substr(0, i), args, consumed),
+            resp::Status::Incomplete) << "prefix " << i;
+    }
+
+    EXPECT_EQ(resp::parse_request(buf, args, consumed), resp::Status::Complete);
+    EXPECT_EQ(args[1], "hello");
+}
+
+TEST(RespTests, ParsePipelined) {
+    std::string buf = "*1\r\n$4\r\nping\r\nget a\r\n*2\r\n$3\r\nget\r\n$1\r\nb\r\n";
+    std::string_view rest = buf;
+    Tokens args;
+    size_t consumed = 0;
+
+    EXPECT_EQ(resp::parse_request(rest, args, consumed), resp::Status::Complete);
+    EXPECT_EQ(args.size(), 1);
+    EXPECT_EQ(args[0], "ping");
+    rest.remove_prefix(consumed);
+
+    // inline requests end at \n
+    EXPECT_EQ(resp::parse_request(rest, args, consumed), resp::Status::Complete);
+    EXPECT_EQ(args.size(), 2);
+    EXPECT_EQ(args[1], "a");
+    rest.remove_prefix(consumed);
+
+    EXPECT_EQ(resp::parse_request(rest, args, consumed), resp::Status::Complete);
+    EXPECT_EQ(args[1], "b");
+    rest.remove_prefix(consumed);
+    EXPECT_TRUE(rest.empty());
+}
+
+TEST(RespTests, ParseErrors) {
+    Tokens args;
+    size_t consumed = 0;
+
+    EXPECT_EQ(resp::parse_request("*x\r\n", args, consumed), resp::Status::Error);
+    EXPECT_EQ(resp::parse_request("*-1\r\n", args, consumed), resp::Status::Error);
+    EXPECT_EQ(resp::parse_request("*1\r\n:1\r\n", args, consumed), resp::Status::Error);
+    EXPECT_EQ(resp::parse_request("*1\r\n$-1\r\n", args, consumed), resp::Status::Error);
+    // the bulk string is longer than its length
+    EXPECT_EQ(resp::parse_request("*1\r\n$1\r\nab\r\n", args, consumed), resp::Status::Error);
+    EXPECT_EQ(resp::parse_request("*1\n", args, consumed), resp::Status::Error);
+}
+
+TEST(RespTests, ParseMessage) {
+    Tokens args;
+    resp::Protocol protocol;
+
+    EXPECT_TRUE(resp::parse_message("get a", args, protocol));
+    EXPECT_EQ(protocol, resp::Protocol::Text);
+    EXPECT_EQ(args.size(), 2);
+
+    EXPECT_TRUE(resp::parse_message("*1\r\n$4\r\nping\r\n", args, protocol));
+    EXPECT_EQ(protocol, resp::Protocol::RESP2);
+    EXPECT_EQ(args[0], "ping");
+
+    // a message is exactly one request
+    EXPECT_FALSE(resp::parse_message("*1\r\n$4\r\nping\r\nextra", args, protocol));
+    EXPECT_FALSE(resp::parse_message("*1\r\n$4\r\nping", args, protocol));
+}
+
+TEST(RespTests, WriteRequest) {
+    std::string str = "lpush list a";
+    Tokens args { str };
+    std::string out;
+    resp::write_request(args, out);
+    EXPECT_EQ(out, "*3\r\n$5\r\nlpush\r\n$4\r\nlist\r\n$1\r\na\r\n");
+
+    Tokens parsed;
+    size_t consumed = 0;
+    EXPECT_EQ(resp::parse_request(out, parsed, consumed), resp::Status::Complete);
+    EXPECT_EQ(parsed.size(), 3);
+    EXPECT_EQ(parsed[2], "a");
+}
+
+TEST(RespTests, Writer) {
+    auto write = [](resp::Protocol protocol) {
+        std::string out;
+        resp::Writer writer { out, protocol };
+        writer.array(5);
+        writer.simple("OK");
+        writer.integer(-12);
+        writer.bulk("a b");
+        writer.null();
+        writer.error("FAILURE");
+        return out;
+    };
+
+    EXPECT_EQ(write(resp::Protocol::Text), "OK -12 a b (NIL) FAILURE");
+    EXPECT_EQ(write(resp::Protocol::RESP2), "*5\r\n+OK\r\n:-12\r\n$3\r\na b\r\n$-1\r\n-ERR FAILURE\r\n");
+    EXPECT_EQ(write(resp::Protocol::RESP3), "*5\r\n+OK\r\n:-12\r\n$3\r\na b\r\n_\r\n-ERR FAILURE\r\n");
+
+    std::string map2, map3;
+    resp::Writer { map2, resp::Protocol::RESP2 }.map(2);
+    resp::Writer { map3, resp::Protocol::RESP3 }.map(2);
+    EXPECT_EQ(map2, "*4\r\n");
+    EXPECT_EQ(map3, "%2\r\n");
+}
+
+TEST(RespTests, ValueRoundTrip) {
+    std::string out;
+    resp::Writer writer { out, resp::Protocol::RESP2 };
+    writer.value(Value(42));
+    writer.value(Value("two words"));
+    writer.value(str_to_value("1 b"));
+
+    resp::Reader reader { out };
+    Value num, str, list;
+    EXPECT_TRUE(reader.read_value(num));
+    EXPECT_TRUE(reader.read_value(str));
+    EXPECT_TRUE(reader.read_value(list));
+    EXPECT_TRUE(reader.done());
+
+    EXPECT_EQ(num.integer(), 42);
+    EXPECT_EQ(str.str(), "two words");
+    EXPECT_EQ(list.list()->get_size(), 2);
+    EXPECT_EQ(list.list()->get(0).integer(), 1);
+    EXPECT_EQ(list.list()->get(1).str(), "b");
+}
+
+TEST(RespTests, ReaderRejectsCutOff) {
+    resp::Reader reader { "$5\r\nab" };
+    std::string_view str;
+    EXPECT_FALSE(reader.read_bulk(str));
+    // nothing was read
+    EXPECT_EQ(reader.peek(), '$');
+
+    size_t size;
+    EXPECT_FALSE(reader.read_array(size));
+}
+
+TEST(RespTests, MergeArrays) {
+    std::string merged = resp::merge_arrays({
+        "*2\r\n$1\r\na\r\n$1\r\nb\r\n",
+        "*0\r\n",
+        "$9\r\n[node 12]\r\n"
+    });
+
+    EXPECT_EQ(merged, "*3\r\n$1\r\na\r\n$1\r\nb\r\n$9\r\n[node 12]\r\n");
+}
+
+TEST(RespTests, MergeKeys) {
+    auto merge = [](const std::vector<std::string> &replies, const std::vector<std::vector<size_t>> &keys,
+        size_t key_count, resp::Protocol protocol = resp::Protocol::RESP2) {
+        std::string out;
+        resp::merge_keys(replies, keys, key_count, protocol, out);
+        return out;
+    };
+
+    // MGET a b c d with a and c on one node, b and d on another
+    std::vector<std::vector<size_t>> keys = { {0, 2}, {1, 3} };
+    std::vector<std::string> values = { "*2\r\n$1\r\n1\r\n$-1\r\n", "*2\r\n$3\r\nx y\r\n$1\r\n4\r\n" };
+    EXPECT_EQ(merge(values, keys, 4), "*4\r\n$1\r\n1\r\n$3\r\nx y\r\n$-1\r\n$1\r\n4\r\n");
+    EXPECT_EQ(merge(values, keys, 4, resp::Protocol::RESP3), "*4\r\n$1\r\n1\r\n$3\r\nx y\r\n_\r\n$1\r\n4\r\n");
+    EXPECT_EQ(merge(values, keys, 4, resp::Protocol::Text), "1 x y (NIL) 4");
+
+    // DEL and EXISTS counts are added
+    EXPECT_EQ(merge({ ":1\r\n", ":2\r\n" }, keys, 4), ":3\r\n");
+    EXPECT_EQ(merge({ ":1\r\n", ":2\r\n" }, keys, 4, resp::Protocol::Text), "3");
+
+    EXPECT_EQ(merge({ "+OK\r\n", "+OK\r\n" }, keys, 4), "+OK\r\n");
+    EXPECT_EQ(merge({ "+OK\r\n", "+OK\r\n" }, keys, 4, resp::Protocol::Text), "SUCCESS");
+
+    // a node that failed fails the command
+    EXPECT_EQ(merge({ "+OK\r\n", "-ERR FAILED\r\n" }, keys, 4), "-ERR FAILED\r\n");
+}
+
+TEST(RespTests, ParseReply) {
+    // pipelined replies, split one at a time
+    std::string buf = "+OK\r\n$4\r\na\r\nb\r\n$-1\r\n:12\r\n-ERR NOT AN INT\r\n"
+        "*2\r\n$1\r\n1\r\n*1\r\n:2\r\n%1\r\n$5\r\nproto\r\n:3\r\n_\r\n";
+    std::vector<std::string> expected = { "+OK\r\n", "$4\r\na\r\nb\r\n", "$-1\r\n", ":12\r\n", "-ERR NOT AN INT\r\n",
+        "*2\r\n$1\r\n1\r\n*1\r\n:2\r\n", "%1\r\n$5\r\nproto\r\n:3\r\n", "_\r\n" };
+
+    std::string_view rest = buf;
+    for (const std::string &reply : expected) {
+        size_t consumed = 0;
+        ASSERT_EQ(resp::parse_reply(rest, consumed), resp::Status::Complete);
+        EXPECT_EQ(rest.substr(0, consumed), reply);
+        rest.remove_prefix(consumed);
+    }
+    EXPECT_TRUE(rest.empty());
+
+    // a reply is incomplete until its last element arrives
+    size_t consumed = 0;
+    EXPECT_EQ(resp::parse_reply("*2\r\n$1\r\n1\r\n", consumed), resp::Status::Incomplete);
+    EXPECT_EQ(resp::parse_reply("$5\r\nab", consumed), resp::Status::Incomplete);
+    EXPECT_EQ(resp::parse_reply("", consumed), resp::Status::Incomplete);
+    EXPECT_EQ(resp::parse_reply("SUCCESS", consumed), resp::Status::Error);
+}
@@ -12,6 +12,8 @@
 #include "consistent-hashing.hpp"
 #include "worker.hpp"
 #include "leader.hpp"
+#include "resp.hpp"
+#include "tokens.hpp"
 
 constexpr int END_OF_LINE = -1;
 
@@ -67,6 +69,25 @@ int send_str(const char *str) {
     return write(client_stdin, str, strlen(str));
 }
 
+// sends requests to the leader in one message, a batch, and returns the replies
+std::string send_batch(const std::vector<std::string> &requests) {
+    std::string batch;
+    for (const std::string &request : requests) {
+        resp::write_request(Tokens { request }, batch);
+    }
+
+    zmq::context_t context(1);
+    zmq::socket_t socket(context, zmq::socket_type::req);
+    socket.set(zmq::sockopt::linger, 0);
+    socket.connect("tcp://localhost:16789");
+    socket.send(zmq::buffer(batch), zmq::send_flags::none);
+
+    zmq::message_t reply;
+    if (!socket.recv(reply)) {
+        return "";
+    }
+    return reply.to_string();
+}
 
 std::string randomKey() {
     int minLength = 2;
@@ -154,6 +175,15 @@ TEST(ServerTests, BasicCache) {
     EXPECT_EQ(check_stdout(3), "> ");
 }
 
+TEST(ServerTests, BatchOrder) {
+    // the sets must reach their nodes before flushall, and a before dbsize
+    EXPECT_EQ(send_batch({ "set b 1", "set c 1", "set d 1", "flushall", "set a 1", "dbsize" }),
+        "+OK\r\n+OK\r\n+OK\r\n+Cache cleared\r\n+OK\r\n:1\r\n");
+
+    // multi-key commands see the writes before them
+    EXPECT_EQ(send_batch({ "set k v", "mget k", "del k", "exists k" }),
+        "+OK\r\n*1\r\n$1\r\nv\r\n:1\r\n:0\r\n");
+}
 
 TEST(ServerTests, DistributedRelocation) {
     std::vector<std::string> keys;
@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <chrono>
+#include <poll.h>
+#include <thread>
+
+#include "shards.hpp"
+#include "worker.hpp"
+#include "tokens.hpp"
+#include "resp.hpp"
+
+// a COMMAND or BATCH message for requests, each like "set a 1"
+static std::string message(char type, resp::Protocol protocol, const std::vector<std::string> &requests) {
+    std::string msg;
+    msg += type;
+    msg += static_cast<char>(protocol);
+    for (const std::string &request : requests) {
+        resp::write_request(Tokens { request }, msg);
+    }
+    return msg;
+}
+
+// submits msg and waits for its reply
+static std::string run(Shards &shards, const std::string &msg) {
+    std::string reply;
+    bool done = false;
+    EXPECT_TRUE(shards.submit(msg, [&](std::string &&r) {
+        reply = std::move(r);
+        done = true;
+    }));
+
+    for (int i = 0; !done && i < 1000; i++) {
+        pollfd item { shards.fd(), POLLIN, 0 };
+        poll(&item, 1, 10);
+        shards.collect();
+    }
+    EXPECT_TRUE(done);
+    return reply;
+}
+
+static std::string command(Shards &shards, const std::string &request, resp::Protocol protocol = resp::Protocol::Text) {
+    return run(shards, message(COMMAND, protocol, { request }));
+}
+
+TEST(ShardsTests, KeyCommands) {
+    LRUCache config;
+    Shards shards { 4, config };
+    ASSERT_EQ(shards.size(), 4);
+
+    for (int i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_EQ(command(shards, "set " + key + " " + std::to_string(i)), "SUCCESS");
+    }
+    for (int i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_EQ(command(shards, "get " + key), std::to_string(i));
+        EXPECT_EQ(command(shards, "incr " + key, resp::Protocol::RESP2), ":" + std::to_string(i + 1) + "\r\n");
+    }
+
+    // every shard is asked, and their counts added
+    EXPECT_EQ(command(shards, "dbsize"), "100");
+    EXPECT_EQ(command(shards, "dbsize", resp::Protocol::RESP2), ":100\r\n");
+    EXPECT_EQ(command(shards, "flushall"), "Cache cleared");
+    EXPECT_EQ(command(shards, "dbsize"), "0");
+
+    EXPECT_EQ(command(shards, "echo hi"), "echo hi");
+}
+
+TEST(ShardsTests, MultiKeyCommands) {
+    LRUCache config;
+    Shards shards { 3, config };
+
+    EXPECT_EQ(command(shards, "mset a 1 b 2 c 3 d 4 e 5", resp::Protocol::RESP2), "+OK\r\n");
+    EXPECT_EQ(command(shards, "mget a b x c d e", resp::Protocol::RESP2),
+        "*6\r\n$1\r\n1\r\n$1\r\n2\r\n$-1\r\n$1\r\n3\r\n$1\r\n4\r\n$1\r\n5\r\n");
+    EXPECT_EQ(command(shards, "exists a b x y e"), "3");
+    EXPECT_EQ(command(shards, "del a b x"), "2");
+    EXPECT_EQ(command(shards, "dbsize"), "3");
+
+    // a missing value fails the same as on one cache
+    EXPECT_EQ(command(shards, "mset a 1 b", resp::Protocol::RESP2), "-ERR FAILURE\r\n");
+}
+
+TEST(ShardsTests, Batch) {
+    LRUCache config;
+    Shards shards { 4, config };
+
+    std::vector<std::string> requests;
+    std::string expected;
+    for (int i = 0; i < 50; i++) {
+        requests.push_back("set key" + std::to_string(i) + " " + std::to_string(i));
+        expected += "+OK\r\n";
+    }
+    for (int i = 0; i < 50; i++) {
+        requests.push_back("get key" + std::to_string(i));
+        expected += "$" + std::to_string(std::to_string(i).size()) + "\r\n" + std::to_string(i) + "\r\n";
+    }
+
+    // replies are put back in the order of the requests
+    EXPECT_EQ(run(shards, message(BATCH, resp::Protocol::RESP2, requests)), expected);
+}
+
+TEST(ShardsTests, ImportExtract) {
+    LRUCache config;
+    Shards shards { 4, config };
+
+    LRUCache source;
+    for (int i = 0; i < 100; i++) {
+        source.add("key" + std::to_string(i), Value(std::to_string(i)));
+    }
+    std::vector<std::string> entries = source.extract({ 0, 0 });
+    ASSERT_EQ(entries.size(), 1);
+
+    // entries are split by key, and the keys added by every shard counted
+    EXPECT_EQ(run(shards, CACHE_UPDATE + entries[0]), "100");
+    EXPECT_EQ(command(shards, "get key42"), "42");
+
+    // the two halves of the ring
+    std::vector<std::string> extracted = shards.extract({ 0, 1ull << 63, 0 });
+    ASSERT_EQ(extracted.size(), 2);
+
+    LRUCache dest;
+    EXPECT_TRUE(dest.import(extracted[0]));
+    EXPECT_TRUE(dest.import(extracted[1]));
+    EXPECT_EQ(dest.size(), 100);
+}
+
+TEST(ShardsTests, OtherMessages) {
+    LRUCache config;
+    Shards shards { 2, config };
+
+    EXPECT_FALSE(shards.submit(RING_UPDATE + std::string("x"), [](std::string &&) {}));
+    EXPECT_EQ(run(shards, std::string(1, COMMAND)), "-ERR Protocol error\r\n");
+}
+
+TEST(ShardsTests, Call) {
+    LRUCache config;
+    Shards shards { 3, config, true };
+
+    std::string reply;
+    EXPECT_TRUE(shards.call(message(COMMAND, resp::Protocol::Text, { "mset a 1 b 2 c 3" }), reply));
+    EXPECT_EQ(reply, "SUCCESS");
+
+    // calls from another thread see what was submitted
+    EXPECT_EQ(command(shards, "get b"), "2");
+    std::thread other([&]() {
+        EXPECT_TRUE(shards.call(message(COMMAND, resp::Protocol::Text, { "dbsize" }), reply));
+    });
+    other.join();
+    EXPECT_EQ(reply, "3");
+
+    EXPECT_FALSE(shards.call(RING_UPDATE + std::string("x"), reply));
+}
+
+TEST(ShardsTests, Backlog) {
+    LRUCache config;
+    Shards shards { 2, config };
+
+    // more requests in flight than the queues hold wait until there is room
+    long done = 0;
+    long count = SHARD_QUEUE_SIZE * 3;
+    for (long i = 0; i < count; i++) {
+        std::string msg = message(COMMAND, resp::Protocol::Text, { "incr counter" });
+        ASSERT_TRUE(shards.submit(msg, [&done](std::string &&reply) { done++; }));
+    }
+
+    for (int i = 0; done < count && i < 10000; i++) {
+        pollfd item { shards.fd(), POLLIN, 0 };
+        poll(&item, 1, 10);
+        shards.collect();
+    }
+    EXPECT_EQ(done, count);
+    EXPECT_EQ(command(shards, "get counter"), std::to_string(count));
+}
@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+#include <set>
+
+#include "slab_pool.hpp"
+#include "entries/cache_entry.hpp"
+#include "quick_list.hpp"
+#include "lru_cache.hpp"
+#include "globals.hpp"
+
+TEST(SlabPoolTests, AllocateAndReuse) {
+    SlabPool pool { "test", 24, 8 };
+    EXPECT_EQ(pool.get_object_size(), 24);
+    EXPECT_EQ(pool.get_slab_count(), 0);
+
+    void *a = pool.allocate();
+    void *b = pool.allocate();
+    EXPECT_NE(a, b);
+    EXPECT_EQ(pool.get_in_use(), 2);
+    EXPECT_EQ(pool.get_slab_count(), 1);
+    EXPECT_EQ(pool.memory_usage(), SLAB_SIZE);
+
+    // freed slots are handed out again first
+    pool.deallocate(a);
+    EXPECT_EQ(pool.get_in_use(), 1);
+    EXPECT_EQ(pool.allocate(), a);
+}
+
+TEST(SlabPoolTests, Alignment) {
+    // sizes are rounded up so every slot stays aligned
+    SlabPool small { "small", 1, 8 };
+    EXPECT_EQ(small.get_object_size(), 8);
+
+    SlabPool odd { "odd", 20, 8 };
+    EXPECT_EQ(odd.get_object_size(), 24);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(odd.allocate()) % 8, 0);
+    }
+}
+
+TEST(SlabPoolTests, Grow) {
+    SlabPool pool { "grow", 64, 8 };
+    const size_t per_slab = SLAB_SIZE / 64;
+
+    std::set<void*> ptrs;
+    for (size_t i = 0; i < per_slab * 3; i++) {
+        ptrs.insert(pool.allocate());
+    }
+
+    EXPECT_EQ(ptrs.size(), per_slab * 3);
+    EXPECT_EQ(pool.get_slab_count(), 3);
+
+    pool.release();
+    EXPECT_EQ(pool.get_in_use(), 0);
+    EXPECT_EQ(pool.get_slab_count(), 0);
+    EXPECT_EQ(pool.memory_usage(), 0);
+}
+
+TEST(SlabPoolTests, ForEachInUse) {
+    SlabPool pool { "walk", 64, 8 };
+    const size_t per_slab = SLAB_SIZE / 64;
+
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < per_slab + 10; i++) {
+        ptrs.push_back(pool.allocate());
+    }
+
+    // free every third object, including ones in both slabs
+    std::set<void*> exp;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        if (i % 3 == 0) {
+            pool.deallocate(ptrs[i]);
+        } else {
+            exp.insert(ptrs[i]);
+        }
+    }
+
+    std::set<void*> found;
+    pool.for_each_in_use([&](void *ptr) {
+        EXPECT_TRUE(found.insert(ptr).second);
+    });
+    EXPECT_EQ(found, exp);
+}
+
+TEST(SlabPoolTests, Stats) {
+    SlabPool pool { "test", 16, 8 };
+    pool.allocate();
+    EXPECT_EQ(pool.stats(), "test(size=16 used=1 slabs=1 bytes=" + std::to_string(SLAB_SIZE) + ")");
+}
+
+TEST(SlabPoolTests, PooledClasses) {
+    size_t entries = CacheEntry::pool().get_in_use();
+    size_t chunks = QuickList::chunk_pool().get_in_use();
+
+    CacheEntry *entry = new CacheEntry("a", Value::new_list());
+    entry->value.list()->add_end(Value("b"));
+    EXPECT_EQ(CacheEntry::pool().get_in_use(), entries + 1);
+    EXPECT_EQ(QuickList::chunk_pool().get_in_use(), chunks + 1);
+
+    delete entry;
+    EXPECT_EQ(CacheEntry::pool().get_in_use(), entries);
+    EXPECT_EQ(QuickList::chunk_pool().get_in_use(), chunks);
+}
+
+TEST(SlabPoolTests, ClearDropsSlabs) {
+    // slabs are only dropped when one cache holds every entry, so empty the global one from other tests
+    cache.clear();
+
+    {
+        LRUCache lru { 10, 10000 };
+        for (int i = 0; i < 5000; i++) {
+            lru.add(std::to_string(i), Value(std::string(100, 'v')));
+        }
+        lru.add("list", str_to_value("a b c"));
+        EXPECT_GT(CacheEntry::pool().get_slab_count(), 1);
+
+        lru.clear();
+        EXPECT_EQ(lru.size(), 0);
+        EXPECT_EQ(CacheEntry::pool().get_slab_count(), 0);
+        EXPECT_EQ(QuickList::chunk_pool().get_slab_count(), 0);
+
+        // the cache is still usable
+        lru.add("a", Value("b"));
+        EXPECT_EQ(lru.get("a")->str(), "b");
+    }
+
+    // entries outside the cache keep their slabs
+    CacheEntry *outside = new CacheEntry("outside");
+    {
+        LRUCache other { };
+        other.add("a", Value("b"));
+        other.clear();
+        EXPECT_EQ(other.size(), 0);
+        EXPECT_EQ(CacheEntry::pool().get_in_use(), 1);
+        EXPECT_EQ(outside->key, "outside");
+    }
+    delete outside;
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include "smart_client.hpp"
+#include "consistent-hashing.hpp"
+
+TEST(SmartClientTests, OwnerMatchesRing) {
+    ConsistentHashing ch_ring;
+    ch_ring.add("one", "tcp://localhost:25551", true);
+    ch_ring.add("two", "tcp://localhost:25552", false);
+    ch_ring.add("three", "tcp://localhost:25553", false);
+
+    SmartClient client { "tcp://localhost:25550" };
+    client.set_ring(ch_ring.to_internal_string());
+    ASSERT_EQ(client.ring_nodes().size(), 3);
+
+    // the client finds the same owner for every key as the leader would
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i);
+        const SmartClient::Node *owner = client.owner(key);
+        std::shared_ptr<ServerNode> node = ch_ring.get(key);
+
+        ASSERT_NE(owner, nullptr);
+        EXPECT_EQ(owner->pid, node->pid);
+        EXPECT_EQ(owner->endpoint, node->endpoint);
+        EXPECT_EQ(owner->is_leader, node->is_leader);
+    }
+}
+
+TEST(SmartClientTests, SetRing) {
+    SmartClient client { "tcp://localhost:25550" };
+    EXPECT_EQ(client.owner("a"), nullptr);
+
+    client.set_ring("*10,tcp://localhost:1 20,tcp://localhost:2 ");
+    ASSERT_EQ(client.ring_nodes().size(), 2);
+    EXPECT_NE(client.owner("a"), nullptr);
+
+    int leaders = 0;
+    for (const SmartClient::Node &node : client.ring_nodes()) {
+        leaders += node.is_leader;
+        EXPECT_EQ(node.hash, hash_function(node.pid + node.endpoint));
+    }
+    EXPECT_EQ(leaders, 1);
+
+    // a later ring replaces it
+    client.set_ring("30,tcp://localhost:3");
+    ASSERT_EQ(client.ring_nodes().size(), 1);
+    EXPECT_EQ(client.owner("a")->pid, "30");
+}
+
+TEST(SmartClientTests, OwnerMatchesRingWithVirtualNodes) {
+    ConsistentHashing ch_ring;
+    ch_ring.add("one", "tcp://localhost:25551", true, 16);
+    ch_ring.add("two", "tcp://localhost:25552", false, 16);
+    ch_ring.add("three", "tcp://localhost:25553", false, 16);
+
+    SmartClient client { "tcp://localhost:25550" };
+    client.set_ring(ch_ring.to_internal_string());
+    ASSERT_EQ(client.ring_nodes().size(), 3);
+    EXPECT_EQ(client.ring_nodes()[0].vnodes, 16);
+
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i);
+        const SmartClient::Node *owner = client.owner(key);
+        std::shared_ptr<ServerNode> node = ch_ring.get(key);
+
+        ASSERT_NE(owner, nullptr);
+        EXPECT_EQ(owner->pid, node->pid);
+    }
+}
+
+TEST(SmartClientTests, OwnerMatchesRingWithPlacement) {
+    ConsistentHashing ch_ring;
+    ch_ring.set_placement(PlacementType::Rendezvous);
+    ch_ring.add("one", "tcp://localhost:25551", true, 16);
+    ch_ring.add("two", "tcp://localhost:25552", false, 16);
+    ch_ring.add("three", "tcp://localhost:25553", false, 16, 3);
+
+    // the placement and weights come with the ring
+    SmartClient client { "tcp://localhost:25550" };
+    client.set_ring(ch_ring.to_internal_string());
+    ASSERT_EQ(client.ring_nodes().size(), 3);
+
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_EQ(client.owner(key)->pid, ch_ring.get(key)->pid);
+    }
+}
@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <poll.h>
+
+#include "spsc_queue.hpp"
+
+TEST(SpscQueueTests, PushPop) {
+    SpscQueue<std::string> queue { 3 };
+    // rounded up to a power of two
+    EXPECT_EQ(queue.capacity(), 4);
+
+    std::string item;
+    EXPECT_FALSE(queue.pop(item));
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.push(std::to_string(i)));
+    }
+
+    // a full queue leaves the item to push again later
+    std::string extra = "extra";
+    EXPECT_FALSE(queue.push(std::move(extra)));
+    EXPECT_EQ(extra, "extra");
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.pop(item));
+        EXPECT_EQ(item, std::to_string(i));
+    }
+    EXPECT_FALSE(queue.pop(item));
+
+    // wraps around the ring
+    EXPECT_TRUE(queue.push(std::move(extra)));
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item, "extra");
+}
+
+TEST(SpscQueueTests, TwoThreads) {
+    SpscQueue<long> queue { 64 };
+    Doorbell pushed;
+    const long count = 100000;
+
+    std::thread producer([&]() {
+        for (long i = 0; i < count; i++) {
+            long item = i;
+            while (!queue.push(std::move(item))) {
+                std::this_thread::yield();
+            }
+            pushed.ring();
+        }
+    });
+
+    // every item arrives once, in order
+    long expected = 0;
+    while (expected < count) {
+        pollfd item { pushed.fd(), POLLIN, 0 };
+        poll(&item, 1, 100);
+        pushed.clear();
+
+        long got;
+        while (queue.pop(got)) {
+            ASSERT_EQ(got, expected);
+            expected++;
+        }
+    }
+
+    producer.join();
+}
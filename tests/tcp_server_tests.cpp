@@ -0,0 +1,286 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "tcp_server.hpp"
+#include "command.hpp"
+
+// serves requests on this node's cache, like the leader does for keys it owns
+static bool run_command(const Tokens &args, resp::Protocol &protocol, std::string &out, const TcpServer::Ticket &ticket) {
+    Command cmd { args, protocol };
+    out += cmd.parse_cmd();
+    protocol = cmd.get_protocol();
+    return true;
+}
+
+static int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    return fd;
+}
+
+static void send_all(int fd, const std::string &str) {
+    EXPECT_EQ(send(fd, str.data(), str.size(), 0), str.size());
+}
+
+// polls the server until size bytes are read from fd, or it gives up
+static std::string read_reply(TcpServer &server, int fd, size_t size) {
+    std::string reply;
+    char buf[4096];
+
+    for (int tries = 0; reply.size() < size && tries < 1000; tries++) {
+        server.poll(1);
+        ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0) {
+            reply.append(buf, n);
+        } else if (n == 0) {
+            break;
+        }
+    }
+
+    return reply;
+}
+
+// polls the server a few times, returning true if nothing was sent to fd
+static bool nothing_sent(TcpServer &server, int fd) {
+    char ch;
+    for (int tries = 0; tries < 20; tries++) {
+        server.poll(1);
+        if (recv(fd, &ch, 1, MSG_DONTWAIT) >= 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::string request(TcpServer &server, int fd, const std::string &req, const std::string &expected) {
+    send_all(fd, req);
+    return read_reply(server, fd, expected.size());
+}
+
+TEST(TcpServerTests, ListenOnFreePort) {
+    TcpServer server { run_command };
+    EXPECT_EQ(server.get_port(), -1);
+    ASSERT_TRUE(server.listen(0));
+    EXPECT_GT(server.get_port(), 0);
+
+    // the port is taken now
+    TcpServer other { run_command };
+    EXPECT_FALSE(other.listen(server.get_port()));
+}
+
+TEST(TcpServerTests, PipelinedRequests) {
+    TcpServer server { run_command };
+    ASSERT_TRUE(server.listen(0));
+    int fd = connect_to(server.get_port());
+
+    // replies come back in order, in one write
+    std::string pipeline =
+        "*3\r\n$3\r\nset\r\n$5\r\ntcp_a\r\n$3\r\nx y\r\n"
+        "*2\r\n$3\r\nget\r\n$5\r\ntcp_a\r\n"
+        "*2\r\n$3\r\nget\r\n$7\r\ntcp_nil\r\n";
+    std::string expected = "+OK\r\n$3\r\nx y\r\n$-1\r\n";
+    EXPECT_EQ(request(server, fd, pipeline, expected), expected);
+
+    close(fd);
+}
+
+TEST(TcpServerTests, InlineRequests) {
+    TcpServer server { run_command };
+    ASSERT_TRUE(server.listen(0));
+    int fd = connect_to(server.get_port());
+
+    // inline requests get RESP replies, and blank lines are skipped
+    std::string expected = "+OK\r\n$5\r\nhello\r\n";
+    EXPECT_EQ(request(server, fd, "set tcp_b hello\r\n\r\nget tcp_b\n", expected), expected);
+
+    close(fd);
+}
+
+TEST(TcpServerTests, PartialRequests) {
+    TcpServer server { run_command };
+    ASSERT_TRUE(server.listen(0));
+    int fd = connect_to(server.get_port());
+
+    // a request split across many reads is only served once it is complete
+    std::string req = "*3\r\n$3\r\nset\r\n$5\r\ntcp_c\r\n$2\r\nhi\r\n";
+    for (char ch : req) {
+        send_all(fd, std::string(1, ch));
+        server.poll(0);
+    }
+
+    EXPECT_EQ(read_reply(server, fd, 5), "+OK\r\n");
+    close(fd);
+}
+
+TEST(TcpServerTests, ManyConnections) {
+    TcpServer server { run_command };
+    ASSERT_TRUE(server.listen(0));
+
+    std::vector<int> fds;
+    for (int i = 0; i < 100; i++) {
+        fds.push_back(connect_to(server.get_port()));
+    }
+
+    // every client has a request in flight at once
+    for (size_t i = 0; i < fds.size(); i++) {
+        send_all(fds[i], "set tcp_many" + std::to_string(i) + " " + std::to_string(i) + "\n");
+    }
+
+    for (int fd : fds) {
+        EXPECT_EQ(read_reply(server, fd, 5), "+OK\r\n");
+    }
+
+    EXPECT_EQ(server.connection_count(), 100);
+
+    for (size_t i = 0; i < fds.size(); i++) {
+        std::string num = std::to_string(i);
+        std::string expected = "$" + std::to_string(num.size()) + "\r\n" + num + "\r\n";
+        EXPECT_EQ(request(server, fds[i], "get tcp_many" + num + "\n", expected), expected);
+        close(fds[i]);
+    }
+
+    // closed connections are cleaned up
+    for (int tries = 0; server.connection_count() > 0 && tries < 100; tries++) {
+        server.poll(1);
+    }
+    EXPECT_EQ(server.connection_count(), 0);
+}
+
+TEST(TcpServerTests, HelloPerConnection) {
+    TcpServer server { run_command };
+    ASSERT_TRUE(server.listen(0));
+    int resp3 = connect_to(server.get_port());
+    int resp2 = connect_to(server.get_port());
+
+    std::string hello = "%2\r\n$6\r\nserver\r\n$11\r\nredis-clone\r\n$5\r\nproto\r\n:3\r\n";
+    EXPECT_EQ(request(server, resp3, "hello 3\n", hello), hello);
+
+    // only the connection that sent HELLO switches protocol
+    EXPECT_EQ(request(server, resp3, "get tcp_nil\n", "_\r\n"), "_\r\n");
+    EXPECT_EQ(request(server, resp2, "get tcp_nil\n", "$-1\r\n"), "$-1\r\n");
+
+    close(resp3);
+    close(resp2);
+}
+
+TEST(TcpServerTests, ProtocolError) {
+    TcpServer server { run_command };
+    ASSERT_TRUE(server.listen(0));
+    int fd = connect_to(server.get_port());
+
+    // the error is sent, then the connection is closed
+    std::string expected = "-ERR Protocol error\r\n";
+    EXPECT_EQ(request(server, fd, "*x\r\n", expected), expected);
+
+    char ch;
+    for (int tries = 0; server.connection_count() > 0 && tries < 100; tries++) {
+        server.poll(1);
+    }
+    EXPECT_EQ(recv(fd, &ch, 1, 0), 0);
+
+    close(fd);
+}
+
+// defers "slow" requests, like the leader does for keys on other nodes
+struct SlowHandler {
+    std::vector<TcpServer::Ticket> tickets;
+
+    bool operator()(const Tokens &args, resp::Protocol &protocol, std::string &out, const TcpServer::Ticket &ticket) {
+        if (args.name() != "slow") {
+            return run_command(args, protocol, out, ticket);
+        }
+
+        tickets.push_back(ticket);
+        return false;
+    }
+};
+
+TEST(TcpServerTests, DeferredReplies) {
+    SlowHandler slow;
+    TcpServer server { std::ref(slow) };
+    ASSERT_TRUE(server.listen(0));
+    int fd = connect_to(server.get_port());
+
+    send_all(fd, "slow a\nslow b\nset tcp_d x\nget tcp_d\n");
+    EXPECT_TRUE(nothing_sent(server, fd));
+    ASSERT_EQ(slow.tickets.size(), 2);
+
+    // replies are sent in the order of the requests, whatever order they complete in
+    server.complete(slow.tickets[1], "+b\r\n");
+    EXPECT_TRUE(nothing_sent(server, fd));
+
+    server.complete(slow.tickets[0], "+a\r\n");
+    std::string expected = "+a\r\n+b\r\n+OK\r\n$1\r\nx\r\n";
+    EXPECT_EQ(read_reply(server, fd, expected.size()), expected);
+
+    close(fd);
+}
+
+TEST(TcpServerTests, DeferredAfterClose) {
+    SlowHandler slow;
+    TcpServer server { std::ref(slow) };
+    ASSERT_TRUE(server.listen(0));
+
+    // a client that stops sending still gets its replies before the connection closes
+    int fd = connect_to(server.get_port());
+    send_all(fd, "slow a\n");
+    shutdown(fd, SHUT_WR);
+    EXPECT_TRUE(nothing_sent(server, fd));
+    EXPECT_EQ(server.connection_count(), 1);
+
+    ASSERT_EQ(slow.tickets.size(), 1);
+    server.complete(slow.tickets[0], "+a\r\n");
+    EXPECT_EQ(read_reply(server, fd, 4), "+a\r\n");
+    EXPECT_EQ(server.connection_count(), 0);
+    close(fd);
+
+    // completing for a connection that is gone does nothing
+    int other = connect_to(server.get_port());
+    send_all(other, "slow b\n");
+    EXPECT_TRUE(nothing_sent(server, other));
+
+    // reset rather than closed, so the server drops it at once
+    linger reset { 1, 0 };
+    setsockopt(other, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    close(other);
+    for (int tries = 0; server.connection_count() > 0 && tries < 100; tries++) {
+        server.poll(1);
+    }
+    EXPECT_EQ(server.connection_count(), 0);
+
+    ASSERT_EQ(slow.tickets.size(), 2);
+    server.complete(slow.tickets[1], "+b\r\n");
+    EXPECT_EQ(server.connection_count(), 0);
+}
+
+TEST(TcpServerTests, WatchedFd) {
+    TcpServer server { run_command };
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    int calls = 0;
+    server.watch(fds[0], [&]() {
+        char ch;
+        EXPECT_EQ(read(fds[0], &ch, 1), 1);
+        calls++;
+    });
+
+    EXPECT_EQ(server.poll(0), 0);
+    EXPECT_EQ(write(fds[1], "x", 1), 1);
+    EXPECT_EQ(server.poll(100), 1);
+    EXPECT_EQ(calls, 1);
+
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include <vector>
+#include <algorithm>
+
+#include "timing_wheel.hpp"
+#include "entries/cache_entry.hpp"
+
+constexpr long NO_LIMIT = 1000000000;
+
+// pops everything due at now
+std::vector<std::string> pop_all(TimingWheel &wheel, seconds::rep now) {
+    std::vector<std::string> keys;
+    long work = 0;
+
+    while (CacheEntry *entry = wheel.pop_expired(now, work, NO_LIMIT)) {
+        keys.emplace_back(entry->key);
+    }
+
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+TEST(TimingWheelTests, Empty) {
+    TimingWheel wheel { 1000 };
+    long work = 0;
+    EXPECT_EQ(wheel.pop_expired(5000, work, NO_LIMIT), nullptr);
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimingWheelTests, ExpiresInOrder) {
+    seconds::rep start = 1000;
+    TimingWheel wheel { start };
+
+    // spread across every level of the wheel
+    std::vector<seconds::rep> offsets { 0, 1, 5, 63, 64, 100, 4095, 4096, 5000, 300000, 20000000 };
+    std::vector<CacheEntry*> entries;
+    for (auto offset : offsets) {
+        CacheEntry *entry = new CacheEntry(std::to_string(offset));
+        entry->expiration = start + offset;
+        wheel.add(entry);
+        entries.emplace_back(entry);
+    }
+    EXPECT_EQ(wheel.size(), offsets.size());
+
+    for (auto offset : offsets) {
+        // nothing before its time
+        if (offset > 0) {
+            EXPECT_EQ(pop_all(wheel, start + offset - 1).size(), 0) << offset;
+        }
+
+        std::vector<std::string> exp { std::to_string(offset) };
+        EXPECT_EQ(pop_all(wheel, start + offset), exp) << offset;
+    }
+
+    EXPECT_EQ(wheel.size(), 0);
+    for (auto entry : entries) {
+        EXPECT_EQ(entry->wheel_slot, -1);
+        delete entry;
+    }
+}
+
+TEST(TimingWheelTests, RemoveAndReschedule) {
+    seconds::rep start = 64 * 64;
+    TimingWheel wheel { start };
+
+    CacheEntry a { "a" };
+    CacheEntry b { "b" };
+    CacheEntry c { "c" };
+    a.expiration = start + 10;
+    b.expiration = start + 10;
+    c.expiration = start + 10;
+    wheel.add(&a);
+    wheel.add(&b);
+    wheel.add(&c);
+
+    wheel.remove(&b);
+    wheel.remove(&b);
+    EXPECT_EQ(wheel.size(), 2);
+
+    // move c further out, then persist a
+    c.expiration = start + 1000;
+    wheel.add(&c);
+    a.expiration = 0;
+    wheel.add(&a);
+    EXPECT_EQ(wheel.size(), 1);
+
+    EXPECT_EQ(pop_all(wheel, start + 999).size(), 0);
+    std::vector<std::string> exp { "c" };
+    EXPECT_EQ(pop_all(wheel, start + 1000), exp);
+}
+
+TEST(TimingWheelTests, PastExpirations) {
+    TimingWheel wheel { 1000 };
+
+    CacheEntry a { "a" };
+    a.expiration = 1;
+    wheel.add(&a);
+
+    std::vector<std::string> exp { "a" };
+    EXPECT_EQ(pop_all(wheel, 1000), exp);
+}
+
+TEST(TimingWheelTests, BoundedWork) {
+    seconds::rep start = 1000;
+    TimingWheel wheel { start };
+
+    std::vector<CacheEntry*> entries;
+    for (int i = 0; i < 100; i++) {
+        CacheEntry *entry = new CacheEntry(std::to_string(i));
+        entry->expiration = start + 2000 + i;
+        wheel.add(entry);
+        entries.emplace_back(entry);
+    }
+
+    // each call does a bounded amount of work and resumes where the last one stopped
+    long popped = 0;
+    int calls = 0;
+    while (popped < 100 && calls < 10000) {
+        long work = 0;
+        while (wheel.pop_expired(start + 5000, work, 16)) {
+            popped++;
+        }
+        EXPECT_LE(work, 16 + 100);
+        calls++;
+    }
+
+    EXPECT_EQ(popped, 100);
+    EXPECT_GT(calls, 1);
+
+    for (auto entry : entries) {
+        delete entry;
+    }
+}
@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include "tokens.hpp"
+
+TEST(TokensTests, Split) {
+    std::string str = "  set\tkey \r\n value  ";
+    Tokens tokens { str };
+    EXPECT_EQ(tokens.size(), 3);
+    EXPECT_EQ(tokens[0], "set");
+    EXPECT_EQ(tokens[1], "key");
+    EXPECT_EQ(tokens[2], "value");
+
+    // tokens are views into the request, not copies
+    EXPECT_EQ(tokens[1].data(), str.data() + 6);
+}
+
+TEST(TokensTests, Empty) {
+    Tokens none { "" };
+    EXPECT_TRUE(none.empty());
+    EXPECT_EQ(none.name(), "");
+    EXPECT_EQ(none.key(), "");
+
+    Tokens spaces { " \t \n " };
+    EXPECT_TRUE(spaces.empty());
+}
+
+TEST(TokensTests, ManyTokens) {
+    std::string str = "del";
+    for (int i = 0; i < 100; i++) {
+        str += " key" + std::to_string(i);
+    }
+
+    // tokens past TOKENS_INLINE spill to the heap, but are read the same way
+    Tokens tokens { str };
+    EXPECT_EQ(tokens.size(), 101);
+    EXPECT_EQ(tokens[0], "del");
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(tokens[i + 1], "key" + std::to_string(i));
+    }
+}
+
+TEST(TokensTests, NameAndKey) {
+    Tokens get { "GET a" };
+    EXPECT_EQ(get.name(), "GET");
+    EXPECT_EQ(get.key(), "a");
+
+    Tokens no_key { "dbsize" };
+    EXPECT_EQ(no_key.name(), "dbsize");
+    EXPECT_EQ(no_key.key(), "");
+
+    // memory has a subcommand before its key
+    Tokens memory { "Memory usage b" };
+    EXPECT_EQ(memory.key(), "b");
+    Tokens no_memory_key { "memory usage" };
+    EXPECT_EQ(no_memory_key.key(), "");
+}
+
+TEST(TokensTests, EqualsIgnoreCase) {
+    EXPECT_TRUE(equals_ignore_case("get", "GET"));
+    EXPECT_TRUE(equals_ignore_case("LPush", "lpush"));
+    EXPECT_TRUE(equals_ignore_case("", ""));
+    EXPECT_FALSE(equals_ignore_case("get", "set"));
+    EXPECT_FALSE(equals_ignore_case("get", "gets"));
+    // only ascii letters are folded
+    EXPECT_FALSE(equals_ignore_case("[", "{"));
+}
@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+
+#include "entries/value.hpp"
+#include "quick_list.hpp"
+
+TEST(ValueTests, Size) {
+    EXPECT_EQ(sizeof(Value), 24);
+}
+
+TEST(ValueTests, None) {
+    Value value;
+    EXPECT_TRUE(value.is_none());
+    EXPECT_EQ(value.type(), EntryType::none);
+    EXPECT_EQ(value.memory_usage(), 0);
+}
+
+TEST(ValueTests, Strings) {
+    Value empty { "" };
+    EXPECT_TRUE(empty.is_str());
+    EXPECT_EQ(empty.str(), "");
+
+    // fits inline
+    std::string small(Value::SMALL_CAPACITY, 's');
+    Value small_value { small };
+    EXPECT_TRUE(small_value.is_str());
+    EXPECT_EQ(small_value.str(), small);
+    EXPECT_EQ(small_value.to_string(), small);
+    EXPECT_EQ(small_value.memory_usage(), 0);
+
+    // one byte too long, so it goes on the heap
+    std::string large(Value::SMALL_CAPACITY + 1, 'l');
+    Value large_value { large };
+    EXPECT_TRUE(large_value.is_str());
+    EXPECT_EQ(large_value.str(), large);
+    EXPECT_EQ(large_value.memory_usage(), large.size());
+
+    // binary data is kept as is
+    std::string binary("a\0b", 3);
+    EXPECT_EQ(Value(binary).str(), binary);
+}
+
+TEST(ValueTests, Ints) {
+    Value value { 5 };
+    EXPECT_TRUE(value.is_int());
+    EXPECT_EQ(value.integer(), 5);
+
+    value.set_integer(-9000000000);
+    EXPECT_EQ(value.integer(), -9000000000);
+    EXPECT_EQ(value.to_string(), "-9000000000");
+    EXPECT_EQ(value.memory_usage(), 0);
+}
+
+TEST(ValueTests, Lists) {
+    Value value = Value::new_list();
+    EXPECT_TRUE(value.is_list());
+    EXPECT_EQ(value.to_string(), "");
+
+    value.list()->add_end(Value("a"));
+    value.list()->add_end(Value(1));
+    EXPECT_EQ(value.to_string(), "a 1");
+    EXPECT_GT(value.memory_usage(), sizeof(QuickList));
+}
+
+TEST(ValueTests, Move) {
+    std::string large(100, 'l');
+    Value value { large };
+
+    Value moved = std::move(value);
+    EXPECT_TRUE(value.is_none());
+    EXPECT_EQ(moved.str(), large);
+
+    Value list = Value::new_list();
+    list.list()->add_end(Value("a"));
+    moved = std::move(list);
+    EXPECT_TRUE(list.is_none());
+    EXPECT_EQ(moved.to_string(), "a");
+}
+
+TEST(ValueTests, Parse) {
+    EXPECT_EQ(str_to_value("abc").type(), EntryType::str);
+    EXPECT_EQ(str_to_value("").type(), EntryType::str);
+    EXPECT_EQ(str_to_value("-5").type(), EntryType::str);
+    EXPECT_EQ(str_to_value("12a").type(), EntryType::str);
+    // leading zeros would be lost as an int
+    EXPECT_EQ(str_to_value("007").type(), EntryType::str);
+    EXPECT_EQ(str_to_value("007").to_string(), "007");
+    EXPECT_TRUE(str_to_value("0").is_int());
+
+    Value num = str_to_value("123");
+    EXPECT_TRUE(num.is_int());
+    EXPECT_EQ(num.integer(), 123);
+
+    EXPECT_EQ(str_to_value("9223372036854775807").integer(), INT64_MAX);
+    // too large for 64 bits
+    EXPECT_EQ(str_to_value("9223372036854775808").type(), EntryType::str);
+    EXPECT_EQ(str_to_value("99999999999999999999").type(), EntryType::str);
+
+    Value list = str_to_value("a 2  c");
+    EXPECT_TRUE(list.is_list());
+    EXPECT_EQ(list.list()->get_size(), 3);
+    EXPECT_TRUE(list.list()->get(1).is_int());
+    EXPECT_EQ(list.to_string(), "a 2 c");
+}